@@ -43,6 +43,7 @@ struct BuildSettings
     bool         isDebugFlagSet() const                    { return getWithDefault (debugMember, false); }
     bool         shouldUseFastMaths() const                { return getOptimisationLevel() >= 4; }
     std::string  getMainProcessor() const                  { return getWithDefault (mainProcessorMember, ""); }
+    bool         shouldProfileNodes() const                { return getWithDefault (profileNodesMember, false); }
 
     BuildSettings& setMaxFrequency (double f)              { setProperty (maxFrequencyMember, f); return *this; }
     BuildSettings& setFrequency (double f)                 { setProperty (frequencyMember, f); return *this; }
@@ -55,6 +56,7 @@ struct BuildSettings
     BuildSettings& setSessionID (int32_t id)               { setProperty (sessionIDMember, id); return *this; }
     BuildSettings& setDebugFlag (bool b)                   { setProperty (debugMember, b); return *this; }
     BuildSettings& setMainProcessor (std::string_view s)   { setProperty (mainProcessorMember, s); return *this; }
+    BuildSettings& setProfileNodes (bool b)                { setProperty (profileNodesMember, b); return *this; }
 
     void reset()                                           { settings = choc::value::Value(); }
 
@@ -127,6 +129,7 @@ private:
     static constexpr auto ignoreWarningsMember     = "ignoreWarnings";
     static constexpr auto debugMember              = "debug";
     static constexpr auto mainProcessorMember      = "mainProcessor";
+    static constexpr auto profileNodesMember       = "profileNodes";
 
     template <typename Type>
     Type getWithDefault (std::string_view name, Type defaultValue) const
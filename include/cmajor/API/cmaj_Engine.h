@@ -63,7 +63,9 @@ struct Engine
     ///
     /// The engineCreationOptions parameter is used for supplying obscure
     /// implementation-specific flags to the underlying engine factory, so unlikely
-    /// to be needed by most users.
+    /// to be needed by most users. For example, the LLVM engine accepts
+    /// `{ "cacheObjectCode": true }` to make link() store and reload native object
+    /// code from its cache database rather than just bitcode.
     static Engine create (const std::string& engineType = {},
                           const choc::value::Value* engineCreationOptions = nullptr);
 
@@ -134,6 +136,12 @@ struct Engine
     /// program.
     Performer createPerformer();
 
+    /// When a program has been successfully linked, this creates a pool of performer
+    /// instances which share the engine's compiled code. Back-ends that support it will
+    /// allocate all the instances' state together in one cache-aligned block, and the
+    /// pool can render every instance with a single advance() call.
+    PerformerPool createPerformerPool (uint32_t numInstances);
+
     /// Returns true if a program has been successfully loaded, but not yet linked.
     bool isLoaded() const;
 
@@ -398,6 +406,17 @@ inline Performer Engine::createPerformer()
     return {};
 }
 
+inline PerformerPool Engine::createPerformerPool (uint32_t numInstances)
+{
+    if (! isLinked())
+        return {};
+
+    if (auto pool = PerformerPoolPtr (engine->createPerformerPool (numInstances)))
+        return PerformerPool (pool);
+
+    return {};
+}
+
 inline bool Engine::isLoaded() const    { return engine != nullptr && engine->isLoaded(); }
 inline bool Engine::isLinked() const    { return engine != nullptr && engine->isLinked(); }
 
@@ -21,6 +21,16 @@
 #include "../../choc/audio/choc_AudioFileFormat.h"
 #include "../../choc/audio/choc_SincInterpolator.h"
 #include "../../choc/audio/choc_SampleBufferUtilities.h"
+#include "../../choc/text/choc_StringUtilities.h"
+#include "../../choc/text/choc_JSON.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <random>
+#include <vector>
 
 namespace cmaj
 {
@@ -108,15 +118,16 @@ inline choc::value::Value convertAudioDataToObject (choc::buffer::ChannelArrayVi
     return createAudioFileObject (choc::buffer::createValueViewFromBuffer (scratchBuffer.interleave (source)), sampleRate);
 }
 
-/// Attempts to load the contents of an audio file into a choc::value::Value,
-/// so that it can be passed into an engine as an external variable.
+/// Decodes an audio file into a buffer, applying any "resample" or "sourceChannel"
+/// properties in the annotation of the external variable it's intended for.
 /// On success, returns an empty string, or an error message on failure.
-inline std::string readAudioFileAsValue (choc::value::Value& result,
-                                         const choc::audio::AudioFileFormatList& fileFormatList,
-                                         std::shared_ptr<std::istream> fileReader,
-                                         const choc::value::ValueView& annotation,
-                                         uint32_t maxNumChannels = 16,
-                                         uint64_t maxNumFrames = 48000 * 100)
+inline std::string readAudioFileFrames (choc::buffer::ChannelArrayBuffer<float>& frames,
+                                        double& sampleRate,
+                                        const choc::audio::AudioFileFormatList& fileFormatList,
+                                        std::shared_ptr<std::istream> fileReader,
+                                        const choc::value::ValueView& annotation,
+                                        uint32_t maxNumChannels = 16,
+                                        uint64_t maxNumFrames = 48000 * 100)
 {
     try
     {
@@ -149,10 +160,11 @@ inline std::string readAudioFileAsValue (choc::value::Value& result,
             data.frames = std::move (extractedChannel);
         }
 
-        result = convertAudioDataToObject (data.frames, data.sampleRate);
-
-        if (result.isVoid())
+        if (data.frames.getNumChannels() == 0)
             return "Failed to decode file";
+
+        frames = std::move (data.frames);
+        sampleRate = data.sampleRate;
     }
     catch (const std::exception& e)
     {
@@ -162,4 +174,244 @@ inline std::string readAudioFileAsValue (choc::value::Value& result,
     return {};
 }
 
+/// Attempts to load the contents of an audio file into a choc::value::Value,
+/// so that it can be passed into an engine as an external variable.
+/// On success, returns an empty string, or an error message on failure.
+inline std::string readAudioFileAsValue (choc::value::Value& result,
+                                         const choc::audio::AudioFileFormatList& fileFormatList,
+                                         std::shared_ptr<std::istream> fileReader,
+                                         const choc::value::ValueView& annotation,
+                                         uint32_t maxNumChannels = 16,
+                                         uint64_t maxNumFrames = 48000 * 100)
+{
+    choc::buffer::ChannelArrayBuffer<float> frames;
+    double sampleRate = 0;
+
+    auto error = readAudioFileFrames (frames, sampleRate, fileFormatList, std::move (fileReader),
+                                      annotation, maxNumChannels, maxNumFrames);
+
+    if (! error.empty())
+        return error;
+
+    result = convertAudioDataToObject (frames, sampleRate);
+
+    if (result.isVoid())
+        return "Failed to decode file";
+
+    return {};
+}
+
+//==============================================================================
+/**
+    A file containing decoded audio frames, which an engine can map into memory and
+    read directly.
+
+    The file holds a small header followed by the frames as interleaved float32
+    samples. Use write() to create one, and read() to check one and find out what it
+    contains. Hosts never map these files themselves: they pass the path to the engine
+    in the object returned by createMappedAudioFramesObject(), and the engine decides
+    whether to map the file or copy the frames into the program.
+*/
+struct AudioCacheFile
+{
+    /// Reads and checks the header of a file that was created by write(), returning
+    /// an empty optional if it can't be opened or isn't valid.
+    static std::optional<AudioCacheFile> read (const std::string& path);
+
+    /// Checks the header of a cache file whose first headerSize bytes have already been
+    /// loaded, returning an empty optional if it isn't valid.
+    static std::optional<AudioCacheFile> readHeader (const std::string& path, const void* headerData, uint64_t fileSize);
+
+    /// Writes some frames to a file in the format that read() expects. The file is first
+    /// written under a unique temporary name and then renamed, so other threads or
+    /// processes can never see a partly-written file. Returns true if a valid file exists
+    /// at the path afterwards.
+    static bool write (const std::string& path, choc::buffer::ChannelArrayView<float> frames, double sampleRate);
+
+    /// The frame data starts at this offset from the start of the file
+    static constexpr size_t headerSize = 64;
+
+    std::string path;
+    uint32_t numChannels = 0;
+    uint64_t numFrames = 0;
+    double sampleRate = 0;
+
+private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version, numChannels;
+        uint64_t numFrames;
+        double sampleRate;
+        char padding[32];
+    };
+
+    static_assert (sizeof (Header) == headerSize, "The frame data needs to be aligned to a cache line");
+    static constexpr const char* headerMagic = "CMAJAUD";
+    static constexpr uint32_t currentVersion = 1;
+};
+
+/// Creates an object that can be used in place of the frames array of an audio file
+/// object, which tells the engine to read the frames from a file that was written by
+/// AudioCacheFile::write().
+inline choc::value::Value createMappedAudioFramesObject (const AudioCacheFile& file)
+{
+    return choc::value::createObject ("cmaj::MappedAudioFrames",
+                                      "path", file.path,
+                                      "numChannels", static_cast<int32_t> (file.numChannels),
+                                      "numFrames", static_cast<int64_t> (file.numFrames));
+}
+
+/// Returns true if this value is an object created by createMappedAudioFramesObject()
+inline bool isMappedAudioFramesObject (const choc::value::ValueView& v)
+{
+    return v.isObject() && v.getObjectClassName() == "cmaj::MappedAudioFrames";
+}
+
+/// Like readAudioFileAsValue(), but instead of putting the frames into the value, this
+/// decodes them into the given cache file, and returns an audio file object whose frames
+/// refer to that file. Engines which support it will map the cache file and read the frames
+/// directly from it, and others will copy them into the program in the usual way.
+/// If the cache file already exists, the source is never opened, so the caller should make
+/// sure the cache file name changes when the source or annotation does.
+/// On success, returns an empty string, or an error message on failure.
+inline std::string readAudioFileAsMappedValue (choc::value::Value& result,
+                                               const std::string& cacheFile,
+                                               const choc::audio::AudioFileFormatList& fileFormatList,
+                                               const std::function<std::shared_ptr<std::istream>()>& createFileReader,
+                                               const choc::value::ValueView& annotation,
+                                               uint32_t maxNumChannels = 16,
+                                               uint64_t maxNumFrames = 48000 * 100)
+{
+    auto file = AudioCacheFile::read (cacheFile);
+
+    if (! file)
+    {
+        choc::buffer::ChannelArrayBuffer<float> frames;
+        double sampleRate = 0;
+
+        auto error = readAudioFileFrames (frames, sampleRate, fileFormatList, createFileReader(),
+                                          annotation, maxNumChannels, maxNumFrames);
+
+        if (! error.empty())
+            return error;
+
+        if (! AudioCacheFile::write (cacheFile, frames, sampleRate))
+            return "Failed to write audio cache file";
+
+        file = AudioCacheFile::read (cacheFile);
+
+        if (! file)
+            return "Failed to open audio cache file";
+    }
+
+    result = createAudioFileObject (createMappedAudioFramesObject (*file), file->sampleRate);
+    return {};
+}
+
+//==============================================================================
+//        _        _           _  _
+//     __| |  ___ | |_   __ _ (_)| | ___
+//    / _` | / _ \| __| / _` || || |/ __|
+//   | (_| ||  __/| |_ | (_| || || |\__ \ _  _  _
+//    \__,_| \___| \__| \__,_||_||_||___/(_)(_)(_)
+//
+//   Code beyond this point is implementation detail...
+//
+//==============================================================================
+
+inline std::optional<AudioCacheFile> AudioCacheFile::read (const std::string& filePath)
+{
+    std::error_code error;
+    auto fileSize = std::filesystem::file_size (filePath, error);
+
+    if (error || fileSize < headerSize)
+        return {};
+
+    std::ifstream stream (filePath, std::ios::binary);
+    char header[headerSize];
+
+    if (! stream.read (header, headerSize))
+        return {};
+
+    return readHeader (filePath, header, fileSize);
+}
+
+inline std::optional<AudioCacheFile> AudioCacheFile::readHeader (const std::string& filePath, const void* headerData, uint64_t fileSize)
+{
+    if (fileSize < headerSize)
+        return {};
+
+    Header header;
+    std::memcpy (std::addressof (header), headerData, headerSize);
+
+    if (std::string_view (header.magic, sizeof (header.magic)) != std::string_view (headerMagic, sizeof (header.magic))
+         || header.version != currentVersion
+         || header.numChannels == 0
+         || header.numChannels > 1024
+         || header.numFrames > (fileSize - headerSize) / (sizeof (float) * header.numChannels))
+        return {};
+
+    AudioCacheFile file;
+    file.path = filePath;
+    file.numChannels = header.numChannels;
+    file.numFrames = header.numFrames;
+    file.sampleRate = header.sampleRate;
+    return file;
+}
+
+inline bool AudioCacheFile::write (const std::string& filePath, choc::buffer::ChannelArrayView<float> frames, double rate)
+{
+    Header header {};
+    std::memcpy (header.magic, headerMagic, sizeof (header.magic));
+    header.version = currentVersion;
+    header.numChannels = frames.getNumChannels();
+    header.numFrames = frames.getNumFrames();
+    header.sampleRate = rate;
+
+    auto tempFile = filePath + "." + choc::text::createHexString (std::random_device()()) + ".tmp";
+
+    auto writeTempFile = [&]
+    {
+        std::ofstream stream (tempFile, std::ios::binary | std::ios::trunc);
+
+        if (! stream)
+            return false;
+
+        stream.write (reinterpret_cast<const char*> (std::addressof (header)), sizeof (header));
+
+        std::vector<float> interleaved;
+        interleaved.reserve (header.numChannels);
+
+        for (uint32_t frame = 0; frame < frames.getNumFrames(); ++frame)
+        {
+            interleaved.clear();
+
+            for (uint32_t channel = 0; channel < header.numChannels; ++channel)
+                interleaved.push_back (frames.getSample (channel, frame));
+
+            stream.write (reinterpret_cast<const char*> (interleaved.data()),
+                          static_cast<std::streamsize> (sizeof (float) * interleaved.size()));
+        }
+
+        stream.close();
+        return ! stream.fail();
+    };
+
+    std::error_code error;
+
+    if (writeTempFile())
+    {
+        std::filesystem::rename (tempFile, filePath, error);
+
+        if (! error)
+            return true;
+    }
+
+    std::filesystem::remove (tempFile, error);
+
+    // Another thread or process may have put its own copy in place first
+    return read (filePath).has_value();
+}
+
 }
@@ -24,6 +24,7 @@
 #include "cmaj_Endpoints.h"
 #include "cmaj_ExternalVariables.h"
 #include "../../choc/audio/choc_SampleBufferUtilities.h"
+#include "../../choc/containers/choc_Span.h"
 
 namespace cmaj
 {
@@ -115,6 +116,16 @@ struct Performer
     template <typename ValueType>
     void addInputEvent (EndpointHandle, uint32_t typeIndex, const ValueType& eventValue);
 
+    /// Adds a packed batch of events to the queue for an input event endpoint.
+    /// This behaves like calling addInputEvent() for each event in the batch in order, but
+    /// only crosses the COM boundary once, so is much cheaper for large numbers of events.
+    /// See the EventBatch class for details of how the event records must be laid out.
+    void addInputEvents (EndpointHandle, const EventBatch&);
+
+    /// Returns true if addInputEvents() delivers events at their frameOffset within the
+    /// next block, rather than all at the start of it.
+    bool supportsEventFrameOffsets() const;
+
     /// Copies-out the frame data from an output stream endpoint.
     /// This function must only be called on the rendering thread, after a call to advance().
     /// The handle must have been obtained by calling getEndpointHandle() before the program is linked.
@@ -139,6 +150,19 @@ struct Performer
     template <typename SampleType>
     void copyOutputFrames (EndpointHandle, choc::buffer::InterleavedBuffer<SampleType>& destBuffer) const;
 
+    /// Returns a pointer to the performer's own frame storage for a stream endpoint, so that its
+    /// frames can be read or written in place without the copies made by setInputFrames() and
+    /// copyOutputFrames(). See PerformerInterface::getStreamFrameBuffer() for the rules about
+    /// using it. If this returns nullptr, the caller must fall back to the copying functions.
+    void* getStreamFrameBuffer (EndpointHandle) const;
+
+    /// Returns an interleaved view of a stream endpoint's frame storage, or an empty view if the
+    /// endpoint can't be accessed directly - see getStreamFrameBuffer().
+    /// NB: like copyOutputFrames(), this doesn't check that the sample type and channel count
+    /// match the endpoint's type, so it's up to the caller to make sure they're correct.
+    template <typename SampleType>
+    choc::buffer::InterleavedView<SampleType> getStreamFrameBuffer (EndpointHandle, uint32_t numChannels, uint32_t numFrames) const;
+
     /// Copies-out the data for the current value of an output value endpoint.
     /// This function must only be called on the rendering thread, after a call to advance().
     /// The handle must have been obtained by calling getEndpointHandle() before the program is linked.
@@ -171,6 +195,12 @@ struct Performer
     /// between calls to advance().
     uint32_t getXRuns() const;
 
+    /// If the program was built with BuildSettings::setProfileNodes() enabled, this returns the
+    /// accumulated counters for each node of the main graph, in the order of the "profiledNodes"
+    /// list in the engine's program details. Otherwise it returns an empty span.
+    /// See PerformerInterface::getNodeProfileCounters() for the threading rules.
+    choc::span<const NodeProfileCounter> getNodeProfileCounters() const;
+
     /// Returns the maximum number of frames that may be set as the block size in a call to setBlockSize().
     uint32_t getMaximumBlockSize() const;
 
@@ -191,6 +221,51 @@ private:
     Library::SharedLibraryPtr library;
 };
 
+//==============================================================================
+/** A wrapper around a PerformerPoolInterface, which is a set of performers that
+    all run the same program and share its compiled code.
+
+    Use Engine::createPerformerPool() to create one. Like Performer, this is just a
+    ref-counted pointer to the underlying object.
+*/
+struct PerformerPool
+{
+    PerformerPool() = default;
+    ~PerformerPool();
+
+    PerformerPool (const PerformerPool&) = default;
+    PerformerPool (PerformerPool&&) = default;
+    PerformerPool& operator= (const PerformerPool&) = default;
+    PerformerPool& operator= (PerformerPool&&) = default;
+
+    PerformerPool (PerformerPoolPtr);
+
+    /// Returns true if this is a valid pool.
+    operator bool() const                           { return pool; }
+
+    bool operator!= (decltype (nullptr)) const      { return pool; }
+    bool operator== (decltype (nullptr)) const      { return ! pool; }
+
+    /// Returns the number of instances in the pool.
+    uint32_t getNumInstances() const;
+
+    /// Returns one of the instances, which can be used like any other Performer.
+    Performer getPerformer (uint32_t index) const;
+
+    /// Sets the number of frames that every instance will render during the next call to advance().
+    void setBlockSize (uint32_t numFramesForNextBlock);
+
+    /// Renders the next block for every instance in the pool.
+    void advance();
+
+    //==============================================================================
+    /// The underlying pool that this helper object is wrapping.
+    PerformerPoolPtr pool;
+
+private:
+    Library::SharedLibraryPtr library;
+};
+
 
 
 //==============================================================================
@@ -212,6 +287,37 @@ inline Performer::~Performer()
     library = {};
 }
 
+inline PerformerPool::PerformerPool (PerformerPoolPtr p) : pool (p), library (Library::getSharedLibraryPtr()) {}
+
+inline PerformerPool::~PerformerPool()
+{
+    pool = {};  // explicitly release the pool before the library
+    library = {};
+}
+
+inline uint32_t PerformerPool::getNumInstances() const
+{
+    return pool->getNumInstances();
+}
+
+inline Performer PerformerPool::getPerformer (uint32_t index) const
+{
+    if (auto p = PerformerPtr (pool->getPerformer (index)))
+        return Performer (p);
+
+    return {};
+}
+
+inline void PerformerPool::setBlockSize (uint32_t numFramesForNextBlock)
+{
+    pool->setBlockSize (numFramesForNextBlock);
+}
+
+inline void PerformerPool::advance()
+{
+    pool->advance();
+}
+
 inline void Performer::setBlockSize (uint32_t numFramesForNextBlock)
 {
     performer->setBlockSize (numFramesForNextBlock);
@@ -307,6 +413,17 @@ void Performer::addInputEvent (EndpointHandle e, uint32_t type, const ValueType&
     }
 }
 
+inline void Performer::addInputEvents (EndpointHandle e, const EventBatch& batch)
+{
+    if (batch.numEvents != 0)
+        performer->addInputEvents (e, std::addressof (batch));
+}
+
+inline bool Performer::supportsEventFrameOffsets() const
+{
+    return performer->supportsEventFrameOffsets();
+}
+
 inline void Performer::copyOutputValue (EndpointHandle endpoint, void* dest) const
 {
     performer->copyOutputValue (endpoint, dest);
@@ -329,6 +446,20 @@ void Performer::copyOutputFrames (EndpointHandle endpoint, choc::buffer::Interle
     performer->copyOutputFrames (endpoint, destBuffer.getView().data.data, destBuffer.getNumFrames());
 }
 
+inline void* Performer::getStreamFrameBuffer (EndpointHandle endpoint) const
+{
+    return performer->getStreamFrameBuffer (endpoint);
+}
+
+template <typename SampleType>
+choc::buffer::InterleavedView<SampleType> Performer::getStreamFrameBuffer (EndpointHandle endpoint, uint32_t numChannels, uint32_t numFrames) const
+{
+    if (auto data = performer->getStreamFrameBuffer (endpoint))
+        return choc::buffer::createInterleavedView (static_cast<SampleType*> (data), numChannels, numFrames);
+
+    return {};
+}
+
 template <typename HandlerFn>
 inline void Performer::iterateOutputEvents (EndpointHandle endpoint, HandlerFn&& handler)
 {
@@ -367,6 +498,18 @@ inline std::string_view Performer::getStringForHandle (uint32_t handle) const
 
 inline uint32_t Performer::getXRuns() const             { return performer != nullptr ? performer->getXRuns() : 0; }
 inline uint32_t Performer::getMaximumBlockSize() const  { return performer->getMaximumBlockSize(); }
+
+inline choc::span<const NodeProfileCounter> Performer::getNodeProfileCounters() const
+{
+    uint32_t numNodes = 0;
+
+    if (performer != nullptr)
+        if (auto counters = performer->getNodeProfileCounters (numNodes))
+            return { counters, counters + numNodes };
+
+    return {};
+}
+
 inline double Performer::getLatency() const             { return performer->getLatency(); }
 inline uint32_t Performer::getEventBufferSize() const   { return performer->getEventBufferSize(); }
 inline const char* Performer::getRuntimeError() const   { return performer != nullptr ? performer->getRuntimeError() : nullptr; }
@@ -150,6 +150,15 @@ struct EngineInterface   : public choc::com::Object
 
     /// Returns a space-separated list of available code-gen targets
     virtual const char* getAvailableCodeGenTargetTypes() = 0;
+
+    //==============================================================================
+    /// When a program has been successfully linked, this creates a pool of performer
+    /// instances which all share the same compiled code, and whose state is allocated
+    /// together in a single block of memory.
+    /// This is intended for hosts that need to run many copies of the same program,
+    /// e.g. one per channel strip or voice, and want to render them all in one call.
+    /// If the engine isn't linked, this will return nullptr.
+    [[nodiscard]] virtual PerformerPoolInterface* createPerformerPool (uint32_t numInstances) = 0;
 };
 
 using EnginePtr = choc::com::Ptr<EngineInterface>;
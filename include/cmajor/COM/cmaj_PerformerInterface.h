@@ -36,6 +36,43 @@ namespace cmaj
 /// its endpoints - see PerformerInterface::getEndpointHandle()
 using EndpointHandle = uint32_t;
 
+//==============================================================================
+/// A packed array of events which can be passed to PerformerInterface::addInputEvents()
+/// to deliver a whole sequence of events to an input endpoint in a single call.
+///
+/// The events are laid out as a contiguous array of records which are eventStride bytes
+/// apart. Each record begins with an EventBatch::Header, and the event's data (in the same
+/// choc::value::ValueView format that addInputEvent() expects) follows immediately after it,
+/// at EventBatch::payloadOffset bytes from the start of the record.
+struct EventBatch
+{
+    struct Header
+    {
+        /// For endpoints that support multiple types, selects the type of this event
+        uint32_t typeIndex;
+        /// The frame within the next block at which the event should be delivered
+        uint32_t frameOffset;
+    };
+
+    const void* events = nullptr;
+    uint32_t numEvents = 0;
+    uint32_t eventStride = 0;
+
+    static constexpr uint32_t payloadOffset = static_cast<uint32_t> (sizeof (Header));
+};
+
+//==============================================================================
+/// The running totals for one node of the main graph, as returned by
+/// PerformerInterface::getNodeProfileCounters() when a program was built with
+/// the BuildSettings "profileNodes" option enabled.
+struct NodeProfileCounter
+{
+    /// The total number of CPU cycle-counter ticks spent inside the node's run calls
+    uint64_t totalCycles;
+    /// The number of times the node has been run (i.e. the number of frames it has rendered)
+    uint64_t numCalls;
+};
+
 
 //==============================================================================
 /** This is the basic COM API class for a performer.
@@ -91,6 +128,20 @@ struct PerformerInterface   : public choc::com::Object
     /// (just set it to 0 for endpoints with only one type).
     virtual void addInputEvent (EndpointHandle, uint32_t typeIndex, const void* eventData) = 0;
 
+    /// Adds a batch of events to the queue for an input event endpoint.
+    /// This has the same effect as calling addInputEvent() for each event in the batch in order,
+    /// but avoids the overhead of a separate call (and endpoint lookup) for each one.
+    /// The same threading rules as addInputEvent() apply.
+    /// Events are delivered at their frameOffset within the next block (which must have
+    /// been set with setBlockSize() beforehand) if supportsEventFrameOffsets() returns true.
+    /// Back-ends which can't deliver an event part-way through a block will dispatch all the
+    /// events at the start of the next block, regardless of their frameOffset.
+    virtual void addInputEvents (EndpointHandle, const EventBatch*) = 0;
+
+    /// Returns true if addInputEvents() will deliver each event at its frameOffset within
+    /// the next block, so that a caller doesn't need to split the block up itself.
+    virtual bool supportsEventFrameOffsets() = 0;
+
     /// Fetches the data for the current value of an output stream or value endpoint.
     /// This function must only be called on the rendering thread, after a call to advance().
     /// The handle must have been obtained by calling getEndpointHandle() before the program is linked.
@@ -108,6 +159,20 @@ struct PerformerInterface   : public choc::com::Object
     /// the caller should know in advance by getting the endpoint's details.
     virtual void copyOutputFrames (EndpointHandle, void* dest, uint32_t numFramesToCopy) = 0;
 
+    /// Returns a pointer to the performer's own frame storage for an input or output stream endpoint,
+    /// so that the caller can read and write frames in place rather than having them copied by
+    /// setInputFrames() and copyOutputFrames().
+    /// The storage is suitably aligned for the endpoint's frame type, holds getMaximumBlockSize() frames,
+    /// and uses the same packed choc::value::ValueView frame layout as setInputFrames() and copyOutputFrames().
+    /// For an input, the caller must write the number of frames set by setBlockSize() before each
+    /// call to advance(). For an output, the rendered frames can be read after advance() returns, and
+    /// the performer will clear them itself before rendering the next block.
+    /// The pointer remains valid for the lifetime of the performer.
+    /// This returns nullptr if the endpoint isn't a stream, if its native layout needs packing, or if
+    /// the back-end doesn't support direct access, in which case the caller must fall back to
+    /// setInputFrames() and copyOutputFrames().
+    virtual void* getStreamFrameBuffer (EndpointHandle) = 0;
+
     /// A user-callback function that is passed to iterateOutputEvents().
     /// The frameOffset is an index into the block that was last rendered during the advance() call.
     /// If this returns true, then iteration will continue. If false, then iteration will stop.
@@ -136,6 +201,17 @@ struct PerformerInterface   : public choc::com::Object
     /// between calls to advance().
     virtual uint32_t getXRuns() = 0;
 
+    /// For a program that was built with the BuildSettings "profileNodes" option enabled, this returns
+    /// a counter for each node of the main graph, accumulated over all the advance() calls since the
+    /// performer was created or last reset.
+    /// The counters are in the same order as the names in the "profiledNodes" list of the engine's
+    /// program details, and numNodes is set to the number of counters.
+    /// This must only be called on the rendering thread, between calls to advance(), and the pointer
+    /// it returns remains valid for the lifetime of the performer.
+    /// If profiling wasn't enabled, or the back-end doesn't support it, this returns nullptr and sets
+    /// numNodes to 0.
+    virtual const NodeProfileCounter* getNodeProfileCounters (uint32_t& numNodes) = 0;
+
     /// Returns the maximum number of frames that may be set as the block size in a call to setBlockSize().
     virtual uint32_t getMaximumBlockSize() = 0;
 
@@ -151,6 +227,40 @@ struct PerformerInterface   : public choc::com::Object
 
 using PerformerPtr = choc::com::Ptr<PerformerInterface>;
 
+
+//==============================================================================
+/** A COM API class for a set of performers which all run the same linked program.
+
+    A pool is created by EngineInterface::createPerformerPool(), and lets a back-end
+    share a single copy of the compiled code between all its instances, and lay out
+    their state memory together. The caller can then render every instance with one
+    call to advance().
+*/
+struct PerformerPoolInterface   : public choc::com::Object
+{
+    PerformerPoolInterface() = default;
+
+    /// Returns the number of performer instances in the pool.
+    virtual uint32_t getNumInstances() = 0;
+
+    /// Returns one of the pool's performers, which can be used to send and receive data
+    /// exactly like a performer returned by EngineInterface::createPerformer().
+    /// Each instance has its own independent state. The object returned holds a reference
+    /// to the pool's memory, so it remains valid even if the pool itself is released.
+    [[nodiscard]] virtual PerformerInterface* getPerformer (uint32_t index) = 0;
+
+    /// Sets the number of frames that every instance will render in the next call to advance().
+    /// This is the same as calling PerformerInterface::setBlockSize() on each instance.
+    virtual void setBlockSize (uint32_t numFramesForNextBlock) = 0;
+
+    /// Renders the next block for every instance in the pool, in index order.
+    /// Before calling this, the caller must provide each instance with its input data in
+    /// the same way as it would before calling PerformerInterface::advance().
+    virtual void advance() = 0;
+};
+
+using PerformerPoolPtr = choc::com::Ptr<PerformerPoolInterface>;
+
 } // namespace cmaj
 
 #ifdef __clang__
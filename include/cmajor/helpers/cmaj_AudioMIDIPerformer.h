@@ -117,8 +117,10 @@ struct AudioMIDIPerformer
     /// aren't in use. If false, it will add the output to whatever is already in the buffer.
     bool process (const choc::audio::AudioMIDIBlockDispatcher::Block&, bool replaceOutput);
 
-    /// This version of process will automatically chop up a set of MIDI events with frame
-    /// times into sub-blocks, and process each chunk separately
+    /// This version of process takes a set of MIDI events with frame times. If the performer
+    /// can deliver events part-way through a block, the whole buffer is rendered in one go
+    /// with each message sent at its frame. Otherwise, it will automatically chop up the
+    /// buffer into sub-blocks at the MIDI times, and process each chunk separately.
     bool processWithTimeStampedMIDI (const choc::buffer::ChannelArrayView<const float> audioInput,
                                      const choc::buffer::ChannelArrayView<float> audioOutput,
                                      const choc::midi::ShortMessage* midiInMessages,
@@ -155,12 +157,22 @@ private:
     choc::fifo::VariableSizeFIFO inputQueue, outputQueue;
     OutputEventsReadyFn outputEventsReadyHandler;
     std::vector<std::pair<choc::midi::ShortMessage, uint32_t>> midiOutputMessages;
+
+    struct PackedMIDIEvent
+    {
+        EventBatch::Header header;
+        int32_t packedMIDI;
+        uint32_t padding;
+    };
+
+    std::vector<PackedMIDIEvent> midiInputBatch;
     choc::buffer::InterleavingScratchBuffer<float> audioInputScratchBuffer;
     std::vector<uint8_t> audioOutputScratchSpace;
 
     uint64_t numFramesProcessed = 0;
     static constexpr uint32_t maxFramesPerBlock = 512;
     uint32_t currentMaxBlockSize = 0;
+    bool performerSupportsEventFrameOffsets = false;
 
     std::atomic<uint32_t> processCallCount { 0 };
     uint32_t lastCheckedProcessCallCount = 0;
@@ -171,7 +183,12 @@ private:
     AudioMIDIPerformer (cmaj::Engine, uint32_t eventFIFOSize);
 
     void allocateScratch();
+    bool processBlock (const choc::audio::AudioMIDIBlockDispatcher::Block&, bool replaceOutput,
+                       const int* midiMessageTimes, uint32_t blockStartFrame);
     void dispatchMIDIOutputEvents (const choc::audio::AudioMIDIBlockDispatcher::Block&);
+
+    template <typename SampleType>
+    choc::buffer::InterleavedView<SampleType> getOutputFrames (EndpointHandle, choc::buffer::InterleavedView<SampleType> scratch, uint32_t numFrames);
     void moveOutputEventsToQueue();
 };
 
@@ -251,11 +268,33 @@ inline bool AudioMIDIPerformer::Builder::connectAudioInputTo (const std::vector<
         ensureInputScratchBufferChannelCount (numChannelsInEndpoint);
         auto endpointHandle = result->engine.getEndpointHandle (endpoint.endpointID);
 
-        result->preRenderFunctions.push_back ([amp = result.get(), endpointHandle, numChannelsInEndpoint,
+        auto endpointIsFloat32 = isFloat32 (endpoint.dataTypes.front());
+
+        result->preRenderFunctions.push_back ([amp = result.get(), endpointHandle, numChannelsInEndpoint, endpointIsFloat32,
                                                endpointChannels, inputChannels, listener]
                                               (const choc::audio::AudioMIDIBlockDispatcher::Block& block)
         {
             auto numFrames = block.audioInput.getNumFrames();
+
+            // If the performer lets us write straight into its own stream storage, we can
+            // skip the extra copy through the scratch buffer
+            if (endpointIsFloat32)
+            {
+                auto directBuffer = amp->performer.getStreamFrameBuffer<float> (endpointHandle, numChannelsInEndpoint, numFrames);
+
+                if (directBuffer.data.data != nullptr)
+                {
+                    for (uint32_t i = 0; i < inputChannels.size(); i++)
+                        copy (directBuffer.getChannel (endpointChannels[i]),
+                                block.audioInput.getChannel (inputChannels[i]));
+
+                    if (listener)
+                        listener->process (directBuffer);
+
+                    return;
+                }
+            }
+
             auto interleavedBuffer = amp->audioInputScratchBuffer.getInterleavedBuffer ({ numChannelsInEndpoint, numFrames });
 
             for (uint32_t i = 0; i < inputChannels.size(); i++)
@@ -345,9 +384,7 @@ void AudioMIDIPerformer::Builder::addOutputCopyFunction (EndpointHandle endpoint
                                                       (const choc::audio::AudioMIDIBlockDispatcher::Block& block)
             {
                 auto destSize = block.audioOutput.getSize();
-                auto source = scratch.getStart (destSize.numFrames);
-
-                amp->performer.copyOutputFrames (endpointHandle, source);
+                auto source = amp->getOutputFrames (endpointHandle, scratch, destSize.numFrames);
                 listener->process (source);
             });
 
@@ -355,9 +392,7 @@ void AudioMIDIPerformer::Builder::addOutputCopyFunction (EndpointHandle endpoint
                                                           (const choc::audio::AudioMIDIBlockDispatcher::Block& block)
             {
                 auto destSize = block.audioOutput.getSize();
-                auto source = scratch.getStart (destSize.numFrames);
-
-                amp->performer.copyOutputFrames (endpointHandle, source);
+                auto source = amp->getOutputFrames (endpointHandle, scratch, destSize.numFrames);
                 listener->process (source);
             });
         }
@@ -397,9 +432,7 @@ void AudioMIDIPerformer::Builder::addOutputCopyFunction (EndpointHandle endpoint
                                               (const choc::audio::AudioMIDIBlockDispatcher::Block& block)
     {
         auto destSize = block.audioOutput.getSize();
-        auto source = scratch.getStart (destSize.numFrames);
-
-        amp->performer.copyOutputFrames (endpointHandle, source);
+        auto source = amp->getOutputFrames (endpointHandle, scratch, destSize.numFrames);
 
         if (listener)
             listener->process (source);
@@ -457,9 +490,7 @@ void AudioMIDIPerformer::Builder::addOutputCopyFunction (EndpointHandle endpoint
                                                       (const choc::audio::AudioMIDIBlockDispatcher::Block& block)
         {
             auto destSize = block.audioOutput.getSize();
-            auto source = scratch.getStart (destSize.numFrames);
-
-            amp->performer.copyOutputFrames (endpointHandle, source);
+            auto source = amp->getOutputFrames (endpointHandle, scratch, destSize.numFrames);
 
             if (listener)
                 listener->process (source);
@@ -685,7 +716,9 @@ inline bool AudioMIDIPerformer::prepareToStart()
         return false;
 
     currentMaxBlockSize = std::min (maxFramesPerBlock, performer.getMaximumBlockSize());
+    performerSupportsEventFrameOffsets = performer.supportsEventFrameOffsets();
     midiOutputMessages.reserve (midiOutputEndpoints.size() * performer.getEventBufferSize());
+    midiInputBatch.resize (std::max (1u, performer.getEventBufferSize()));
     endpointTypeCoercionHelpers.initialiseDictionary (performer);
     return true;
 }
@@ -697,6 +730,15 @@ inline void AudioMIDIPerformer::playbackStopped()
 
 //==============================================================================
 inline bool AudioMIDIPerformer::process (const choc::audio::AudioMIDIBlockDispatcher::Block& block, bool replaceOutput)
+{
+    return processBlock (block, replaceOutput, nullptr, 0);
+}
+
+/// If midiMessageTimes is non-null, it provides the time of each of the block's MIDI
+/// messages, relative to blockStartFrame, and the block must not be bigger than
+/// currentMaxBlockSize.
+inline bool AudioMIDIPerformer::processBlock (const choc::audio::AudioMIDIBlockDispatcher::Block& block, bool replaceOutput,
+                                              const int* midiMessageTimes, uint32_t blockStartFrame)
 {
     try
     {
@@ -707,6 +749,8 @@ inline bool AudioMIDIPerformer::process (const choc::audio::AudioMIDIBlockDispat
 
         if (numFrames > currentMaxBlockSize)
         {
+            CMAJ_ASSERT (midiMessageTimes == nullptr);
+
             for (uint32_t start = 0; start < numFrames;)
             {
                 auto numToDo = std::min (currentMaxBlockSize, numFrames - start);
@@ -747,13 +791,34 @@ inline bool AudioMIDIPerformer::process (const choc::audio::AudioMIDIBlockDispat
 
         if (! midiInputEndpoints.empty())
         {
-            for (auto midiEvent : block.midiMessages)
+            auto totalMessages = static_cast<uint32_t> (block.midiMessages.size());
+
+            for (uint32_t start = 0; start < totalMessages;)
             {
-                auto bytes = midiEvent.data;
-                auto packedMIDI = static_cast<int32_t> ((bytes[0] << 16) | (bytes[1] << 8) | bytes[2]);
+                auto numInBatch = std::min (static_cast<uint32_t> (midiInputBatch.size()), totalMessages - start);
+
+                for (uint32_t i = 0; i < numInBatch; ++i)
+                {
+                    auto bytes = block.midiMessages[start + i].data;
+                    auto& e = midiInputBatch[i];
+                    uint32_t frameOffset = 0;
+
+                    if (midiMessageTimes != nullptr)
+                    {
+                        auto time = midiMessageTimes[start + i] - static_cast<int> (blockStartFrame);
+                        frameOffset = static_cast<uint32_t> (std::clamp (time, 0, static_cast<int> (numFrames) - 1));
+                    }
+
+                    e.header = { 0, frameOffset };
+                    e.packedMIDI = static_cast<int32_t> ((bytes[0] << 16) | (bytes[1] << 8) | bytes[2]);
+                }
+
+                EventBatch batch { midiInputBatch.data(), numInBatch, static_cast<uint32_t> (sizeof (PackedMIDIEvent)) };
 
                 for (auto& midiEndpoint : midiInputEndpoints)
-                    performer.addInputEvent (midiEndpoint, 0, packedMIDI);
+                    performer.addInputEvents (midiEndpoint, batch);
+
+                start += numInBatch;
             }
         }
 
@@ -799,6 +864,41 @@ inline bool AudioMIDIPerformer::processWithTimeStampedMIDI (const choc::buffer::
     if (totalNumMIDIMessages == 0)
         return process (choc::audio::AudioMIDIBlockDispatcher::Block { audioInput, audioOutput, {}, sendMidiOut }, replaceOutput);
 
+    if (performerSupportsEventFrameOffsets)
+    {
+        // The performer can deliver the messages at the right frames itself, so the buffer only
+        // needs to be split up if it's bigger than the maximum block size
+        auto totalFrames = audioOutput.getNumFrames();
+        uint32_t midiStartIndex = 0;
+
+        for (uint32_t start = 0; start < totalFrames;)
+        {
+            choc::buffer::FrameRange chunkToDo { start, std::min (start + currentMaxBlockSize, totalFrames) };
+            auto endOfMIDI = midiStartIndex;
+
+            while (endOfMIDI < totalNumMIDIMessages
+                    && (chunkToDo.end == totalFrames || midiInMessageTimes[endOfMIDI] < (int) chunkToDo.end))
+                ++endOfMIDI;
+
+            if (! processBlock (choc::audio::AudioMIDIBlockDispatcher::Block {
+                                    audioInput.getFrameRange (chunkToDo),
+                                    audioOutput.getFrameRange (chunkToDo),
+                                    choc::span<const choc::midi::ShortMessage> (midiInMessages + midiStartIndex,
+                                                                                midiInMessages + endOfMIDI),
+                                    [&] (uint32_t frame, choc::midi::ShortMessage m)
+                                    {
+                                        sendMidiOut (chunkToDo.start + frame, m);
+                                    }
+                                }, replaceOutput, midiInMessageTimes + midiStartIndex, chunkToDo.start))
+                return false;
+
+            start = chunkToDo.end;
+            midiStartIndex = endOfMIDI;
+        }
+
+        return true;
+    }
+
     auto remainingChunk = audioOutput.getFrameRange();
     uint32_t midiStartIndex = 0;
 
@@ -839,6 +939,21 @@ inline bool AudioMIDIPerformer::processWithTimeStampedMIDI (const choc::buffer::
     return false;
 }
 
+template <typename SampleType>
+choc::buffer::InterleavedView<SampleType> AudioMIDIPerformer::getOutputFrames (EndpointHandle endpoint,
+                                                                               choc::buffer::InterleavedView<SampleType> scratch,
+                                                                               uint32_t numFrames)
+{
+    auto frames = performer.getStreamFrameBuffer<SampleType> (endpoint, scratch.getNumChannels(), numFrames);
+
+    if (frames.data.data != nullptr)
+        return frames;
+
+    auto copied = scratch.getStart (numFrames);
+    performer.copyOutputFrames (endpoint, copied);
+    return copied;
+}
+
 inline void AudioMIDIPerformer::dispatchMIDIOutputEvents (const choc::audio::AudioMIDIBlockDispatcher::Block& block)
 {
     if (! block.onMidiOutputMessage)
@@ -199,7 +199,7 @@ struct EmbeddedWebAssets
         "     *     two properties 'min' and 'max', which are each an array of values, one element per audio\n"
         "     *     channel. This allows you to find the highest and lowest samples in that chunk for each channel.\n"
         "     *     If sendFullAudioData is true, the listener's argument will have a property 'data' which is an\n"
-        "     *     array containing one array per channel of raw audio samples data.\n"
+        "     *     array containing one Float32Array per channel of raw audio samples data.\n"
         "     */\n"
         "    addEndpointListener (endpointID, listener, granularity, sendFullAudioData)\n"
         "    {\n"
@@ -285,8 +285,76 @@ struct EmbeddedWebAssets
         "        if (msg.type == \"param_value\")\n"
         "            this.dispatchEvent (\"param_value_\" + msg.message.endpointID, msg.message.value);\n"
         "\n"
+        "        // The server marks packed data on the outer message, which patch values can't reach\n"
+        "        if (msg.packed)\n"
+        "            msg.message = unpackMessage (msg.packed, msg.message);\n"
+        "\n"
         "        this.dispatchEvent (msg.type, msg.message);\n"
         "    }\n"
+        "}\n"
+        "\n"
+        "//==============================================================================\n"
+        "// Large blocks of audio and numeric event data arrive as base64-encoded binary\n"
+        "// rather than as JSON arrays, so these helpers turn them back into typed arrays.\n"
+        "\n"
+        "const base64Values = (() =>\n"
+        "{\n"
+        "    const table = new Uint8Array (128);\n"
+        "    const chars = \"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/\";\n"
+        "\n"
+        "    for (let i = 0; i < chars.length; ++i)\n"
+        "        table[chars.charCodeAt (i)] = i;\n"
+        "\n"
+        "    return table;\n"
+        "})();\n"
+        "\n"
+        "function decodeBase64 (text)\n"
+        "{\n"
+        "    let length = text.length;\n"
+        "\n"
+        "    while (length > 0 && text[length - 1] === \"=\")\n"
+        "        --length;\n"
+        "\n"
+        "    const bytes = new Uint8Array ((length * 3) >> 2);\n"
+        "    let out = 0;\n"
+        "\n"
+        "    for (let i = 0; i < length; i += 4)\n"
+        "    {\n"
+        "        const a = base64Values[text.charCodeAt (i)];\n"
+        "        const b = base64Values[text.charCodeAt (i + 1)];\n"
+        "        const c = base64Values[text.charCodeAt (i + 2)];\n"
+        "        const d = base64Values[text.charCodeAt (i + 3)];\n"
+        "\n"
+        "        bytes[out++] = (a << 2) | (b >> 4);\n"
+        "        if (out < bytes.length)  bytes[out++] = ((b & 15) << 4) | (c >> 2);\n"
+        "        if (out < bytes.length)  bytes[out++] = ((c & 3) << 6) | d;\n"
+        "    }\n"
+        "\n"
+        "    return bytes.buffer;\n"
+        "}\n"
+        "\n"
+        "function unpackMessage (format, message)\n"
+        "{\n"
+        "    const buffer = decodeBase64 (message.data);\n"
+        "    let values;\n"
+        "\n"
+        "    switch (format)\n"
+        "    {\n"
+        "        case \"float32\":  values = new Float32Array (buffer); break;\n"
+        "        case \"float64\":  values = new Float64Array (buffer); break;\n"
+        "        case \"int32\":    values = new Int32Array (buffer); break;\n"
+        "        default:         return message;\n"
+        "    }\n"
+        "\n"
+        "    if (message.numChannels === undefined)\n"
+        "        return values;\n"
+        "\n"
+        "    const channels = [];\n"
+        "\n"
+        "    for (let i = 0; i < message.numChannels; ++i)\n"
+        "        channels.push (values.subarray (i * message.numFrames, (i + 1) * message.numFrames));\n"
+        "\n"
+        "    return { data: channels };\n"
         "}\n";
     static constexpr const char* cmajparametercontrols_js = "//\n"
         "//     ,ad888ba,                              88\n"
@@ -1698,6 +1766,8 @@ struct EmbeddedWebAssets
         "    /** Attaches a listener function which will be sent messages containing CPU info.\n"
         "     *  To remove the listener, call `removeCPUListener()`. To change the rate of these\n"
         "     *  messages, use `setCPULevelUpdateRate()`.\n"
+        "     *  If the patch was built with the `profileNodes` build setting, each message also\n"
+        "     *  has a `nodes` array giving the `name` and `cyclesPerFrame` of each graph node.\n"
         "     */\n"
         "    addCPUListener (listener)                       { this.addEventListener    (\"cpu_info\", listener); this.updateCPULevelUpdateRate(); }\n"
         "\n"
@@ -3486,11 +3556,11 @@ struct EmbeddedWebAssets
 
     static constexpr std::array files =
     {
-        File { "cmaj-patch-connection.js", std::string_view (cmajpatchconnection_js, 12712) },
+        File { "cmaj-patch-connection.js", std::string_view (cmajpatchconnection_js, 14769) },
         File { "cmaj-parameter-controls.js", std::string_view (cmajparametercontrols_js, 29343) },
         File { "cmaj-midi-helpers.js", std::string_view (cmajmidihelpers_js, 13253) },
         File { "cmaj-event-listener-list.js", std::string_view (cmajeventlistenerlist_js, 3474) },
-        File { "cmaj-server-session.js", std::string_view (cmajserversession_js, 18844) },
+        File { "cmaj-server-session.js", std::string_view (cmajserversession_js, 19019) },
         File { "cmaj-piano-keyboard.js", std::string_view (cmajpianokeyboard_js, 15540) },
         File { "cmaj-generic-patch-view.js", std::string_view (cmajgenericpatchview_js, 6282) },
         File { "cmaj-patch-view.js", std::string_view (cmajpatchview_js, 7221) },
@@ -88,6 +88,17 @@ struct GeneratedCppEngine  : public choc::com::ObjectWithAtomicRefCount<EngineIn
         return choc::com::create<Performer> (getSessionID(), getFrequency()).getWithIncrementedRefCount();
     }
 
+    PerformerPoolInterface* createPerformerPool (uint32_t numInstances) override
+    {
+        auto pool = choc::com::create<PerformerPool>();
+        pool->instances.reserve (numInstances);
+
+        for (uint32_t i = 0; i < numInstances; ++i)
+            pool->instances.push_back (choc::com::create<Performer> (getSessionID(), getFrequency()));
+
+        return pool.getWithIncrementedRefCount();
+    }
+
     //==============================================================================
     choc::com::String* getProgramDetails() override
     {
@@ -168,6 +179,22 @@ private:
             generatedObject.addEvent (endpoint, typeIndex, eventData);
         }
 
+        void addInputEvents (EndpointHandle endpoint, const EventBatch* batch) override
+        {
+            auto record = static_cast<const uint8_t*> (batch->events);
+
+            for (uint32_t i = 0; i < batch->numEvents; ++i, record += batch->eventStride)
+            {
+                auto& header = *reinterpret_cast<const EventBatch::Header*> (record);
+                generatedObject.addEvent (endpoint, header.typeIndex, record + EventBatch::payloadOffset);
+            }
+        }
+
+        bool supportsEventFrameOffsets() override
+        {
+            return false;
+        }
+
         void copyOutputValue (EndpointHandle endpoint, void* dest) override
         {
             generatedObject.copyOutputValue (endpoint, dest);
@@ -178,6 +205,12 @@ private:
             generatedObject.copyOutputFrames (endpoint, dest, numFramesToCopy);
         }
 
+        void* getStreamFrameBuffer (EndpointHandle) override
+        {
+            // the generated class keeps its stream data private, so callers must copy
+            return nullptr;
+        }
+
         void iterateOutputEvents (EndpointHandle endpoint, void* context, PerformerInterface::HandleOutputEventCallback callback) override
         {
             if (auto numEvents = generatedObject.getNumOutputEvents (endpoint))
@@ -209,6 +242,13 @@ private:
         }
 
         uint32_t getXRuns() override            { return xruns; }
+
+        const NodeProfileCounter* getNodeProfileCounters (uint32_t& numNodes) override
+        {
+            // generated C++ code is never instrumented for profiling
+            numNodes = 0;
+            return nullptr;
+        }
         const char* getRuntimeError() override  { return {}; }
 
         uint32_t getMaximumBlockSize() override { return GeneratedCppClass::maxFramesPerBlock; }
@@ -221,6 +261,34 @@ private:
         int32_t sessionID;
         double frequency;
     };
+
+    //==============================================================================
+    struct PerformerPool  : public choc::com::ObjectWithAtomicRefCount<PerformerPoolInterface, PerformerPool>
+    {
+        uint32_t getNumInstances() override     { return static_cast<uint32_t> (instances.size()); }
+
+        PerformerInterface* getPerformer (uint32_t index) override
+        {
+            if (index < instances.size())
+                return instances[index].getWithIncrementedRefCount();
+
+            return {};
+        }
+
+        void setBlockSize (uint32_t numFramesForNextBlock) override
+        {
+            for (auto& p : instances)
+                p->setBlockSize (numFramesForNextBlock);
+        }
+
+        void advance() override
+        {
+            for (auto& p : instances)
+                p->advance();
+        }
+
+        std::vector<choc::com::Ptr<Performer>> instances;
+    };
 };
 
 //==============================================================================
@@ -0,0 +1,113 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+
+#pragma once
+
+#include <mutex>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "../COM/cmaj_CacheDatabaseInterface.h"
+
+namespace cmaj
+{
+
+//==============================================================================
+/// A simple implementation of CacheDatabaseInterface that keeps its data in
+/// memory, and discards the least-recently used items when the total size
+/// goes over a given limit.
+struct InMemoryCacheDatabase   : public choc::com::ObjectWithAtomicRefCount<CacheDatabaseInterface, InMemoryCacheDatabase>
+{
+    InMemoryCacheDatabase (size_t maxTotalSizeInBytes = 256 * 1024 * 1024)
+       : maxTotalSize (maxTotalSizeInBytes)
+    {
+    }
+
+    virtual ~InMemoryCacheDatabase() = default;
+
+    void store (const char* key, const void* dataToSave, uint64_t dataSize) override
+    {
+        std::lock_guard<decltype(lock)> l (lock);
+
+        auto data = static_cast<const char*> (dataToSave);
+        auto& entry = entries[key];
+        totalSize -= entry.data.size();
+        entry.data.assign (data, data + dataSize);
+        entry.lastUsed = ++useCounter;
+        totalSize += entry.data.size();
+
+        removeOldEntries();
+    }
+
+    uint64_t reload (const char* key, void* destAddress, uint64_t destSize) override
+    {
+        std::lock_guard<decltype(lock)> l (lock);
+
+        auto i = entries.find (key);
+
+        if (i == entries.end())
+            return 0;
+
+        auto& entry = i->second;
+
+        if (destAddress != nullptr && destSize >= entry.data.size())
+        {
+            memcpy (destAddress, entry.data.data(), entry.data.size());
+            entry.lastUsed = ++useCounter;
+        }
+
+        return entry.data.size();
+    }
+
+    size_t getTotalSize() const
+    {
+        std::lock_guard<decltype(lock)> l (lock);
+        return totalSize;
+    }
+
+private:
+    struct Entry
+    {
+        std::vector<char> data;
+        uint64_t lastUsed = 0;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    size_t maxTotalSize = 0, totalSize = 0;
+    uint64_t useCounter = 0;
+    mutable std::mutex lock;
+
+    void removeOldEntries()
+    {
+        while (totalSize > maxTotalSize && entries.size() > 1)
+        {
+            auto oldest = entries.begin();
+
+            for (auto i = entries.begin(); i != entries.end(); ++i)
+                if (i->second.lastUsed < oldest->second.lastUsed)
+                    oldest = i;
+
+            totalSize -= oldest->second.data.size();
+            entries.erase (oldest);
+        }
+    }
+};
+
+} // namespace cmaj
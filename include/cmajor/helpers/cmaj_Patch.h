@@ -20,6 +20,8 @@
 
 #include "cmaj_PatchHelpers.h"
 #include "cmaj_AudioMIDIPerformer.h"
+#include "cmaj_InMemoryCacheDatabase.h"
+#include "../../choc/text/choc_Base64.h"
 
 #include <mutex>
 #include <unordered_map>
@@ -234,16 +236,25 @@ struct Patch
     std::function<void(const Status&)> statusChanged;
 
     /// This object can optionally be provided if you have a build cache that you'd like
-    /// the engine to use when compiling code.
+    /// the engine to use when compiling code. If none is supplied, the patch keeps a
+    /// small in-memory cache, so that a rebuild whose generated code hasn't changed can
+    /// skip LLVM's optimisation and code-generation. Parsing and resolution still run
+    /// in full on every rebuild.
     cmaj::CacheDatabaseInterface::Ptr cache;
 
+    /// If this is set, audio files that the patch's externals refer to are decoded into
+    /// cache files in this folder. Engines that support it will then read the frames
+    /// straight from the mapped cache files rather than copying them into the program.
+    std::string audioFileCacheFolder;
+
     // These dispatch various types of event to any active views that the patch has open.
     void sendMessageToView (PatchView&, std::string_view type, const choc::value::ValueView&) const;
+    void sendPackedDataToView (PatchView&, std::string_view type, std::string_view format, const choc::value::ValueView&) const;
     void broadcastMessageToViews (std::string_view type, const choc::value::ValueView&) const;
     void sendPatchStatusChangeToViews() const;
     void sendParameterChangeToViews (const EndpointID&, float value) const;
     void sendCurrentParameterValueToViews (const EndpointID&) const;
-    void sendCPUInfoToViews (float level) const;
+    void sendCPUInfoToViews (float level, const choc::value::ValueView& nodeProfile = {}) const;
     void sendStoredStateValueToViews (const std::string& key) const;
 
     // These can be called by things like the GUI to control the patch
@@ -337,6 +348,7 @@ private:
     std::string hostDescription;
     std::unordered_map<std::string, CustomAudioSourcePtr> customAudioInputSources;
     std::unique_ptr<PatchFileChangeChecker> fileChangeChecker;
+    cmaj::CacheDatabaseInterface::Ptr rebuildCache;
     std::vector<PatchView*> activeViews;
     std::unordered_map<std::string, choc::value::Value> storedState;
 
@@ -481,11 +493,18 @@ struct Patch::ClientEventQueue
 
     void postCPULevel (float level)
     {
-        fifo.push (1 + sizeof (float), [&] (void* dest)
+        auto numNodes = static_cast<uint32_t> (nodeProfileCounters.size());
+        auto nodeDataSize = numNodes * static_cast<uint32_t> (sizeof (NodeProfileCounter));
+
+        fifo.push (1 + sizeof (float) + sizeof (uint32_t) + nodeDataSize, [&] (void* dest)
         {
             auto d = static_cast<char*> (dest);
             d[0] = static_cast<char> (EventType::cpuLevel);
             choc::memory::writeNativeEndian (d + 1, level);
+            choc::memory::writeNativeEndian (d + 5, numNodes);
+
+            if (numNodes != 0)
+                memcpy (d + 9, nodeProfileCounters.data(), nodeDataSize);
         });
 
         triggerDispatchOnEndOfBlock = true;
@@ -494,23 +513,177 @@ struct Patch::ClientEventQueue
     void dispatchCPULevel (const char* d)
     {
         auto value = choc::memory::readNativeEndian<float> (d + 1);
-        patch.sendCPUInfoToViews (value);
+        auto numNodes = choc::memory::readNativeEndian<uint32_t> (d + 5);
+        patch.sendCPUInfoToViews (value, getNodeProfileSummary (d + 9, numNodes));
+    }
+
+    /// Turns the performer's running totals into the number of cycles per frame
+    /// that each node has used since the previous CPU level update.
+    choc::value::Value getNodeProfileSummary (const char* counterData, uint32_t numNodes)
+    {
+        if (numNodes == 0)
+        {
+            lastNodeProfileCounters.clear();
+            return {};
+        }
+
+        auto nodeNames = patch.getProgramDetails()["profiledNodes"];
+        auto nodes = choc::value::createEmptyArray();
+        lastNodeProfileCounters.resize (numNodes);
+
+        for (uint32_t i = 0; i < numNodes; ++i)
+        {
+            NodeProfileCounter counter;
+            memcpy (std::addressof (counter), counterData + i * sizeof (NodeProfileCounter), sizeof (NodeProfileCounter));
+            auto& last = lastNodeProfileCounters[i];
+
+            // the totals start again if the performer is reset or rebuilt
+            if (counter.numCalls < last.numCalls || counter.totalCycles < last.totalCycles)
+                last = {};
+
+            auto numFrames = counter.numCalls - last.numCalls;
+            auto numCycles = counter.totalCycles - last.totalCycles;
+            last = counter;
+
+            nodes.addArrayElement (choc::json::create ("name", nodeNames.isArray() && i < nodeNames.size() ? nodeNames[i].toString() : std::string(),
+                                                       "cyclesPerFrame", numFrames != 0 ? static_cast<double> (numCycles) / static_cast<double> (numFrames) : 0.0));
+        }
+
+        return nodes;
     }
 
-    void postAudioMinMax (const PatchView& view, const std::string& eventName, const choc::buffer::ChannelArrayBuffer<float>& levels)
+    //==============================================================================
+    /// A tap is the route by which monitoring data gets from the audio thread to the
+    /// views that have asked for it. The audio thread only writes the tap's ID and the raw
+    /// data into the FIFO, and the list of views that are interested is only looked at on
+    /// the dispatch thread, so each block of data gets pushed once however many views are
+    /// watching it.
+    struct MonitorTap
+    {
+        struct Subscriber
+        {
+            uint16_t viewID;
+            std::string replyType;
+        };
+
+        void addSubscriber (const PatchView& view, std::string replyType)
+        {
+            std::lock_guard<decltype(lock)> l (lock);
+            subscribers.push_back ({ view.viewID, std::move (replyType) });
+        }
+
+        bool removeSubscriber (const PatchView& view, const std::string& replyType)
+        {
+            return removeSubscribersIf ([&] (const Subscriber& s) { return s.viewID == view.viewID && s.replyType == replyType; });
+        }
+
+        bool removeSubscribers (const PatchView& view)
+        {
+            return removeSubscribersIf ([&] (const Subscriber& s) { return s.viewID == view.viewID; });
+        }
+
+        bool hasSubscribers()
+        {
+            std::lock_guard<decltype(lock)> l (lock);
+            return ! subscribers.empty();
+        }
+
+        std::vector<Subscriber> getSubscribers()
+        {
+            std::lock_guard<decltype(lock)> l (lock);
+            return subscribers;
+        }
+
+        uint32_t tapID = 0;
+
+        /// The types of event that can be posted to this tap. This can't change once the
+        /// tap has been created, so it's safe for the audio thread to read it.
+        choc::SmallVector<choc::value::Type, 2> eventTypes;
+
+    private:
+        std::mutex lock;
+        std::vector<Subscriber> subscribers;
+
+        template <typename Predicate>
+        bool removeSubscribersIf (Predicate&& shouldRemove)
+        {
+            std::lock_guard<decltype(lock)> l (lock);
+            auto oldEnd = subscribers.end();
+            auto newEnd = std::remove_if (subscribers.begin(), oldEnd, shouldRemove);
+
+            if (newEnd == oldEnd)
+                return false;
+
+            subscribers.erase (newEnd, oldEnd);
+            return true;
+        }
+    };
+
+    /// Creates a new tap, which stays registered for as long as something holds a reference to it.
+    std::shared_ptr<MonitorTap> createTap (choc::SmallVector<choc::value::Type, 2> eventTypes = {})
+    {
+        auto tap = std::make_shared<MonitorTap>();
+        tap->eventTypes = std::move (eventTypes);
+
+        std::lock_guard<decltype(tapLock)> l (tapLock);
+
+        for (auto i = taps.begin(); i != taps.end();)
+        {
+            if (i->second.expired())
+                i = taps.erase (i);
+            else
+                ++i;
+        }
+
+        tap->tapID = nextTapID++;
+        taps[tap->tapID] = tap;
+        return tap;
+    }
+
+    std::shared_ptr<MonitorTap> findTap (uint32_t tapID)
+    {
+        std::lock_guard<decltype(tapLock)> l (tapLock);
+
+        if (auto t = taps.find (tapID); t != taps.end())
+            return t->second.lock();
+
+        return {};
+    }
+
+    void sendToTapSubscribers (MonitorTap& tap, const choc::value::ValueView& message)
+    {
+        for (auto& s : tap.getSubscribers())
+            if (auto view = patch.findViewForID (s.viewID))
+                patch.sendMessageToView (*view, s.replyType, message);
+    }
+
+    void sendPackedDataToTapSubscribers (MonitorTap& tap, const char* format, const choc::value::ValueView& packedData)
+    {
+        for (auto& s : tap.getSubscribers())
+            if (auto view = patch.findViewForID (s.viewID))
+                patch.sendPackedDataToView (*view, s.replyType, format, packedData);
+    }
+
+    void sendEndpointEventToTap (MonitorTap& tap, const choc::value::ValueView& value)
+    {
+        if (auto packed = packNumericArray (value); packed.format != nullptr)
+            sendPackedDataToTapSubscribers (tap, packed.format, packed.data);
+        else
+            sendToTapSubscribers (tap, value);
+    }
+
+    //==============================================================================
+    void postAudioMinMax (uint32_t tapID, const choc::buffer::ChannelArrayBuffer<float>& levels)
     {
         triggerDispatchOnEndOfBlock = true;
         auto numChannels = levels.getNumChannels();
 
-        auto eventNameChars = eventName.data();
-        auto eventNameLen = static_cast<uint32_t> (eventName.length());
-
-        fifo.push (5 + numChannels * sizeof (float) * 2 + eventNameLen, [&] (void* dest)
+        fifo.push (7 + numChannels * sizeof (float) * 2, [&] (void* dest)
         {
             auto d = static_cast<char*> (dest);
             *d++ = static_cast<char> (EventType::audioMinMaxLevels);
-            choc::memory::writeNativeEndian<uint16_t> (d, view.viewID);
-            d += sizeof (uint16_t);
+            choc::memory::writeNativeEndian (d, tapID);
+            d += sizeof (uint32_t);
             choc::memory::writeNativeEndian<uint16_t> (d, static_cast<uint16_t> (numChannels));
             d += sizeof (uint16_t);
 
@@ -523,18 +696,14 @@ struct Patch::ClientEventQueue
                 choc::memory::writeNativeEndian (d, *i);
                 d += sizeof (float);
             }
-
-            memcpy (d, eventNameChars, eventNameLen);
         });
     }
 
     void dispatchAudioMinMax (const char* d, const char* end)
     {
-        auto viewID = choc::memory::readNativeEndian<uint16_t> (++d);
-
-        if (auto view = patch.findViewForID (viewID))
+        if (auto tap = findTap (choc::memory::readNativeEndian<uint32_t> (++d)))
         {
-            d += sizeof (uint16_t);
+            d += sizeof (uint32_t);
             auto numChannels = choc::memory::readNativeEndian<uint16_t> (d);
             d += sizeof (uint16_t);
 
@@ -548,31 +717,27 @@ struct Patch::ClientEventQueue
                 d += sizeof (float);
             }
 
-            CMAJ_ASSERT (end > d);
+            CMAJ_ASSERT (end == d);
 
-            patch.sendMessageToView (*view, std::string_view (d, static_cast<std::string_view::size_type> (end - d)),
-                                     choc::json::create (
-                                        "min", choc::value::createArrayView (mins.data(), static_cast<uint32_t> (mins.size())),
-                                        "max", choc::value::createArrayView (maxs.data(), static_cast<uint32_t> (maxs.size()))));
+            sendToTapSubscribers (*tap, choc::json::create (
+                                            "min", choc::value::createArrayView (mins.data(), static_cast<uint32_t> (mins.size())),
+                                            "max", choc::value::createArrayView (maxs.data(), static_cast<uint32_t> (maxs.size()))));
         }
     }
 
-    void postAudioFullData (const PatchView& view, const std::string& eventName, const choc::buffer::ChannelArrayBuffer<float>& levels)
+    void postAudioFullData (uint32_t tapID, const choc::buffer::ChannelArrayBuffer<float>& levels)
     {
         triggerDispatchOnEndOfBlock = true;
         auto numChannels = levels.getNumChannels();
         auto numFrames = levels.getNumFrames();
         CMAJ_ASSERT (numFrames < 65536);
 
-        auto eventNameChars = eventName.data();
-        auto eventNameLen = static_cast<uint32_t> (eventName.length());
-
-        fifo.push (6 + numChannels * numFrames * sizeof (float) + eventNameLen, [&] (void* dest)
+        fifo.push (8 + numChannels * numFrames * sizeof (float), [&] (void* dest)
         {
             auto d = static_cast<char*> (dest);
             *d++ = static_cast<char> (EventType::audioFullData);
-            choc::memory::writeNativeEndian<uint16_t> (d, view.viewID);
-            d += sizeof (uint16_t);
+            choc::memory::writeNativeEndian (d, tapID);
+            d += sizeof (uint32_t);
             *d++ = static_cast<char> (numChannels);
             choc::memory::writeNativeEndian<uint16_t> (d, static_cast<uint16_t> (numFrames));
             d += sizeof (uint16_t);
@@ -587,88 +752,194 @@ struct Patch::ClientEventQueue
                     d += sizeof (float);
                 }
             }
-
-            memcpy (d, eventNameChars, eventNameLen);
         });
     }
 
     void dispatchAudioFullData (const char* d, const char* end)
     {
-        auto viewID = choc::memory::readNativeEndian<uint16_t> (++d);
-
-        if (auto view = patch.findViewForID (viewID))
+        if (auto tap = findTap (choc::memory::readNativeEndian<uint32_t> (++d)))
         {
-            d += sizeof (uint16_t);
+            d += sizeof (uint32_t);
 
             auto numChannels = static_cast<uint32_t> (static_cast<uint8_t> (*d++));
             auto numFrames = static_cast<uint32_t> (choc::memory::readNativeEndian<uint16_t> (d));
             d += sizeof (uint16_t);
-            auto audioData = d;
-            d += numFrames * numChannels * sizeof (float);
-            CMAJ_ASSERT (end > d);
-
-            auto levels = choc::value::createArray (numChannels, [=] (uint32_t channel)
-            {
-                auto channelData = audioData + channel * numFrames * sizeof (float);
+            auto audioDataSize = numFrames * numChannels * sizeof (float);
+            CMAJ_ASSERT (end == d + audioDataSize);
 
-                return choc::value::createArray (numFrames, [=] (uint32_t frame)
-                {
-                    return choc::memory::readNativeEndian<float> (channelData + frame * sizeof (float));
-                });
-            });
+            // The FIFO already holds the samples channel-by-channel, so they can be sent
+            // as a single packed block rather than a JSON array containing every sample
+            auto packedData = createPackedData (d, audioDataSize);
+            packedData.setMember ("numChannels", static_cast<int32_t> (numChannels));
+            packedData.setMember ("numFrames", static_cast<int32_t> (numFrames));
 
-            patch.sendMessageToView (*view, std::string_view (d, static_cast<std::string_view::size_type> (end - d)),
-                                     choc::json::create ("data", std::move (levels)));
+            sendPackedDataToTapSubscribers (*tap, "float32", packedData);
         }
     }
 
-    void postEndpointEvent (const PatchView& view, const std::string& eventName, const void* messageData, uint32_t messageSize)
+    //==============================================================================
+    /// Posts an event value to a tap. If the value has one of the tap's event types, only
+    /// its raw data and the index of its type are copied, and it gets turned back into a
+    /// value on the dispatch thread. Anything else is serialised directly into the FIFO.
+    /// Neither of these needs to allocate.
+    void postEndpointEvent (const MonitorTap& tap, const choc::value::ValueView& message)
     {
-        auto eventNameChars = eventName.data();
-        auto eventNameLen = static_cast<uint32_t> (eventName.length());
-        auto viewID = view.viewID;
+        auto& type = message.getType();
+
+        for (uint32_t i = 0; i < tap.eventTypes.size(); ++i)
+        {
+            auto& eventType = tap.eventTypes[i];
+
+            if (eventType == type && ! eventType.usesStrings())
+            {
+                postRawEndpointEvent (tap.tapID, i, message.getRawData(),
+                                      static_cast<uint32_t> (eventType.getValueDataSize()));
+                return;
+            }
+        }
+
+        postSerialisedEndpointEvent (tap.tapID, message);
+    }
 
-        fifo.push (4 + eventNameLen + messageSize, [=] (void* dest)
+    void postRawEndpointEvent (uint32_t tapID, uint32_t typeIndex, const void* data, uint32_t size)
+    {
+        fifo.push (9 + size, [&] (void* dest)
         {
             auto d = static_cast<char*> (dest);
             d[0] = static_cast<char> (EventType::endpointEvent);
-            choc::memory::writeNativeEndian (d + 1, viewID);
-            d[3] = static_cast<char> (eventNameLen);
-            memcpy (d + 4, eventNameChars, eventNameLen);
-            memcpy (d + 4 + eventNameLen, messageData, messageSize);
+            choc::memory::writeNativeEndian (d + 1, tapID);
+            choc::memory::writeNativeEndian (d + 5, typeIndex);
+            memcpy (d + 9, data, size);
         });
 
         triggerDispatchOnEndOfBlock = true;
     }
 
-    void postEndpointEvent (const PatchView& view, const std::string& eventName, const choc::value::ValueView& message)
+    void postSerialisedEndpointEvent (uint32_t tapID, const void* serialisedData, uint32_t size)
     {
-        auto serialisedMessage = message.serialise();
-        postEndpointEvent (view, eventName, serialisedMessage.data.data(), static_cast<uint32_t> (serialisedMessage.data.size()));
+        fifo.push (5 + size, [&] (void* dest)
+        {
+            auto d = static_cast<char*> (dest);
+            d[0] = static_cast<char> (EventType::serialisedEndpointEvent);
+            choc::memory::writeNativeEndian (d + 1, tapID);
+            memcpy (d + 5, serialisedData, size);
+        });
+
+        triggerDispatchOnEndOfBlock = true;
+    }
+
+    void postSerialisedEndpointEvent (uint32_t tapID, const choc::value::ValueView& message)
+    {
+        struct SizeCounter
+        {
+            void write (const void*, size_t size)   { total += size; }
+            size_t total = 0;
+        };
+
+        struct Writer
+        {
+            void write (const void* source, size_t size)
+            {
+                memcpy (dest, source, size);
+                dest += size;
+            }
+
+            char* dest;
+        };
+
+        SizeCounter counter;
+        message.serialise (counter);
+
+        fifo.push (5 + static_cast<uint32_t> (counter.total), [&] (void* dest)
+        {
+            auto d = static_cast<char*> (dest);
+            d[0] = static_cast<char> (EventType::serialisedEndpointEvent);
+            choc::memory::writeNativeEndian (d + 1, tapID);
+            Writer writer { d + 5 };
+            message.serialise (writer);
+        });
+
+        triggerDispatchOnEndOfBlock = true;
     }
 
-    void postEndpointMIDI (const PatchView& view, const std::string& eventName, choc::midi::ShortMessage message)
+    void postEndpointMIDI (uint32_t tapID, choc::midi::ShortMessage message)
     {
         auto data = serialisedMIDIMessage.getSerialisedData (message);
-        postEndpointEvent (view, eventName, data.data, data.size);
+        postSerialisedEndpointEvent (tapID, data.data, data.size);
     }
 
     void dispatchEndpointEvent (const char* d, uint32_t size)
     {
-        auto viewID = choc::memory::readNativeEndian<uint16_t> (d + 1);
+        if (auto tap = findTap (choc::memory::readNativeEndian<uint32_t> (d + 1)))
+        {
+            auto typeIndex = choc::memory::readNativeEndian<uint32_t> (d + 5);
+            CMAJ_ASSERT (typeIndex < tap->eventTypes.size());
+            auto& type = tap->eventTypes[typeIndex];
+            CMAJ_ASSERT (9 + type.getValueDataSize() == size);
+
+            sendEndpointEventToTap (*tap, choc::value::ValueView (type, const_cast<char*> (d + 9), nullptr));
+        }
+    }
 
-        if (auto view = patch.findViewForID (viewID))
+    void dispatchSerialisedEndpointEvent (const char* d, uint32_t size)
+    {
+        if (auto tap = findTap (choc::memory::readNativeEndian<uint32_t> (d + 1)))
         {
-            auto eventNameLen = d[3] == 0 ? 256u : static_cast<uint32_t> (static_cast<uint8_t> (d[3]));
-            CMAJ_ASSERT (eventNameLen + 6 < size);
-            auto valueData = choc::value::InputData { reinterpret_cast<const uint8_t*> (d + 4 + eventNameLen),
+            auto valueData = choc::value::InputData { reinterpret_cast<const uint8_t*> (d + 5),
                                                       reinterpret_cast<const uint8_t*> (d + size) };
 
-            patch.sendMessageToView (*view, std::string_view (d + 4, eventNameLen),
-                                     choc::value::Value::deserialise (valueData));
+            sendEndpointEventToTap (*tap, choc::value::Value::deserialise (valueData));
         }
     }
 
+    //==============================================================================
+    /// Wraps a block of raw binary data as a base64 string in a small object which
+    /// cmaj-patch-connection.js will turn back into a typed array. Views can only be
+    /// sent text, so this is the cheapest way to get large numeric arrays through to them.
+    static choc::value::Value createPackedData (const void* data, size_t size)
+    {
+        return choc::json::create ("data", choc::base64::encodeToString (data, size));
+    }
+
+    struct PackedData
+    {
+        const char* format = nullptr;
+        choc::value::Value data;
+    };
+
+    /// Returns a packed version of a large array or vector of numbers, or an empty
+    /// PackedData if the value isn't something that can be packed.
+    static PackedData packNumericArray (const choc::value::ValueView& value)
+    {
+        static constexpr uint32_t minElementsToPack = 32;
+
+        if (! (value.isVector() || (value.isArray() && value.getType().isUniformArray())))
+            return {};
+
+        if (value.size() < minElementsToPack)
+            return {};
+
+        auto elementType = value.getType().getElementType();
+
+        if (elementType.isFloat32())  return { "float32", packElements<float>   (value) };
+        if (elementType.isFloat64())  return { "float64", packElements<double>  (value) };
+        if (elementType.isInt32())    return { "int32",   packElements<int32_t> (value) };
+
+        return {};
+    }
+
+    template <typename ElementType>
+    static choc::value::Value packElements (const choc::value::ValueView& value)
+    {
+        std::vector<ElementType> elements;
+        elements.reserve (value.size());
+
+        for (uint32_t i = 0; i < value.size(); ++i)
+            elements.push_back (value[i].get<ElementType>());
+
+        return createPackedData (elements.data(), elements.size() * sizeof (ElementType));
+    }
+
     void startOfProcessCallback()
     {
         cpu.startProcess();
@@ -680,8 +951,9 @@ struct Patch::ClientEventQueue
         framesProcessedInBlock += block.audioOutput.getNumFrames();
     }
 
-    void endOfProcessCallback()
+    void endOfProcessCallback (choc::span<const NodeProfileCounter> nodeCounters)
     {
+        nodeProfileCounters = nodeCounters;
         cpu.endProcess (framesProcessedInBlock);
 
         if (triggerDispatchOnEndOfBlock)
@@ -699,11 +971,12 @@ struct Patch::ClientEventQueue
 
             switch (static_cast<EventType> (d[0]))
             {
-                case EventType::paramChange:            dispatchParameterChange (d, size); break;
-                case EventType::audioMinMaxLevels:      dispatchAudioMinMax (d, d + size); break;
-                case EventType::audioFullData:          dispatchAudioFullData (d, d + size); break;
-                case EventType::endpointEvent:          dispatchEndpointEvent (d, size); break;
-                case EventType::cpuLevel:               dispatchCPULevel (d); break;
+                case EventType::paramChange:              dispatchParameterChange (d, size); break;
+                case EventType::audioMinMaxLevels:        dispatchAudioMinMax (d, d + size); break;
+                case EventType::audioFullData:            dispatchAudioFullData (d, d + size); break;
+                case EventType::endpointEvent:            dispatchEndpointEvent (d, size); break;
+                case EventType::serialisedEndpointEvent:  dispatchSerialisedEndpointEvent (d, size); break;
+                case EventType::cpuLevel:                 dispatchCPULevel (d); break;
                 default:                                break;
             }
         });
@@ -715,6 +988,7 @@ struct Patch::ClientEventQueue
         audioMinMaxLevels,
         audioFullData,
         endpointEvent,
+        serialisedEndpointEvent,
         cpuLevel
     };
 
@@ -725,6 +999,12 @@ struct Patch::ClientEventQueue
     MIDIEvents::SerialisedShortMIDIMessage serialisedMIDIMessage;
     bool triggerDispatchOnEndOfBlock = false;
     uint32_t framesProcessedInBlock = 0;
+    choc::span<const NodeProfileCounter> nodeProfileCounters;
+    std::vector<NodeProfileCounter> lastNodeProfileCounters;
+
+    std::mutex tapLock;
+    std::unordered_map<uint32_t, std::weak_ptr<MonitorTap>> taps;
+    uint32_t nextTapID = 1;
 
     CPUMonitor cpu;
 };
@@ -815,14 +1095,22 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
     }
 
     //==============================================================================
+    /// Removes any monitors whose taps no longer have any views listening to them.
+    template <typename MonitorList>
+    static void removeUnusedMonitors (MonitorList& monitors)
+    {
+        monitors.erase (std::remove_if (monitors.begin(), monitors.end(),
+                                        [] (auto& m) { return ! m->tap->hasSubscribers(); }),
+                        monitors.end());
+    }
+
     struct AudioLevelMonitor
     {
-        AudioLevelMonitor (PatchView& v, const EndpointDetails& endpoint, std::string type, uint32_t gran, bool fullData)
-            : view (v),
-              endpointID (endpoint.endpointID.toString()),
-              replyType (std::move (type)),
+        AudioLevelMonitor (const EndpointDetails& endpoint, std::shared_ptr<ClientEventQueue::MonitorTap> t, uint32_t gran, bool fullData)
+            : endpointID (endpoint.endpointID.toString()),
+              tap (std::move (t)),
               sendFullData (fullData),
-              granularity (gran >= minGranularity && gran <= maxGranularity ? gran : defaultGranularity)
+              granularity (getGranularity (gran))
         {
             auto numChannels = endpoint.getNumAudioChannels();
             CMAJ_ASSERT (numChannels > 0);
@@ -872,7 +1160,7 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
                 if (++frameCount == granularity)
                 {
                     frameCount = 0;
-                    queue.postAudioMinMax (view, replyType, levels);
+                    queue.postAudioMinMax (tap->tapID, levels);
                 }
             }
         }
@@ -895,7 +1183,7 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
                 if (frameCount == granularity)
                 {
                     frameCount = 0;
-                    queue.postAudioFullData (view, replyType, levels);
+                    queue.postAudioFullData (tap->tapID, levels);
                     break;
                 }
 
@@ -904,13 +1192,19 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
             }
         }
 
-        bool isFor (PatchView& v, const EndpointID& e, const std::string& type) const
+        static uint32_t getGranularity (uint32_t requested)
         {
-            return std::addressof (view) == std::addressof (v) && replyType == type && endpointID == e.toString();
+            return requested >= minGranularity && requested <= maxGranularity ? requested : defaultGranularity;
         }
 
-        PatchView& view;
-        const std::string endpointID, replyType;
+        /// Views that ask for data with the same settings can all share one monitor.
+        bool canBeSharedWith (uint32_t requestedGranularity, bool fullData) const
+        {
+            return sendFullData == fullData && granularity == getGranularity (requestedGranularity);
+        }
+
+        const std::string endpointID;
+        const std::shared_ptr<ClientEventQueue::MonitorTap> tap;
         const bool sendFullData;
         const uint32_t granularity;
 
@@ -959,16 +1253,24 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
                 m->process (queue, block);
         }
 
-        bool removeMonitor (PatchView& view, const EndpointID& e, const std::string& type)
+        AudioLevelMonitor* findMonitor (uint32_t granularity, bool fullData) const
         {
-            auto oldEnd = audioMonitors.end();
-            auto newEnd = std::remove_if (audioMonitors.begin(), oldEnd,
-                                          [&] (auto& m) { return m->isFor (view, e, type); });
+            for (auto& m : audioMonitors)
+                if (m->canBeSharedWith (granularity, fullData))
+                    return m.get();
 
-            if (newEnd != oldEnd)
+            return {};
+        }
+
+        bool removeMonitor (PatchView& view, const std::string& type)
+        {
+            for (auto& m : audioMonitors)
             {
-                audioMonitors.erase (newEnd, oldEnd);
-                return true;
+                if (m->tap->removeSubscriber (view, type))
+                {
+                    removeUnusedMonitors (audioMonitors);
+                    return true;
+                }
             }
 
             return false;
@@ -976,12 +1278,10 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
 
         void removeMonitorsForView (PatchView& view)
         {
-            auto oldEnd = audioMonitors.end();
-            auto newEnd = std::remove_if (audioMonitors.begin(), oldEnd,
-                                          [&] (auto& m) { return std::addressof (m->view) == std::addressof (view); });
+            for (auto& m : audioMonitors)
+                m->tap->removeSubscribers (view);
 
-            if (newEnd != oldEnd)
-                audioMonitors.erase (newEnd, oldEnd);
+            removeUnusedMonitors (audioMonitors);
         }
 
         ClientEventQueue& queue;
@@ -1024,6 +1324,7 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
                 return;
 
             lastBuildLog = engine.getLastBuildLog();
+            programDetails = engine.getProgramDetails(); // linking may add details such as the list of profiled nodes
 
             if (performerBuilder.setEventOutputHandler ([this] { outputEventsReady(); }))
                 startOutputEventThread();
@@ -1234,7 +1535,19 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
         {
             if (auto l = endpointListeners.findAudioDataListener (e))
             {
-                auto monitor = std::make_unique<AudioLevelMonitor> (view, *details, std::move (replyType), granularity, fullData);
+                {
+                    std::lock_guard<decltype(processLock)> lock (processLock);
+
+                    if (auto existing = l->findMonitor (granularity, fullData))
+                    {
+                        existing->tap->addSubscriber (view, std::move (replyType));
+                        return true;
+                    }
+                }
+
+                auto tap = patch.clientEventQueue->createTap();
+                tap->addSubscriber (view, std::move (replyType));
+                auto monitor = std::make_unique<AudioLevelMonitor> (*details, std::move (tap), granularity, fullData);
 
                 std::lock_guard<decltype(processLock)> lock (processLock);
                 l->audioMonitors.push_back (std::move (monitor));
@@ -1243,7 +1556,19 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
 
             if (details->isEvent())
             {
-                auto monitor = std::make_unique<EndpointListeners::EventMonitor> (view, *details, std::move (replyType));
+                {
+                    std::lock_guard<decltype(processLock)> lock (processLock);
+
+                    if (auto existing = endpointListeners.findEventMonitor (e))
+                    {
+                        existing->tap->addSubscriber (view, std::move (replyType));
+                        return true;
+                    }
+                }
+
+                auto tap = patch.clientEventQueue->createTap (details->dataTypes);
+                tap->addSubscriber (view, std::move (replyType));
+                auto monitor = std::make_unique<EndpointListeners::EventMonitor> (*details, std::move (tap));
 
                 std::lock_guard<decltype(processLock)> lock (processLock);
                 endpointListeners.add (std::move (monitor));
@@ -1500,8 +1825,8 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
     {
         struct EventMonitor
         {
-            EventMonitor (PatchView& v, const EndpointDetails& e, std::string type)
-                : view (v), endpointID (e.endpointID.toString()), replyType (std::move (type)), isMIDI (e.isMIDI())
+            EventMonitor (const EndpointDetails& e, std::shared_ptr<ClientEventQueue::MonitorTap> t)
+                : endpointID (e.endpointID.toString()), tap (std::move (t)), isMIDI (e.isMIDI())
             {
             }
 
@@ -1509,7 +1834,7 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
             {
                 if (endpointID == endpoint)
                 {
-                    queue.postEndpointEvent (view, replyType, message);
+                    queue.postEndpointEvent (*tap, message);
                     return true;
                 }
 
@@ -1520,20 +1845,15 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
             {
                 if (isMIDI && endpointID == endpoint)
                 {
-                    queue.postEndpointMIDI (view, replyType, message);
+                    queue.postEndpointMIDI (tap->tapID, message);
                     return true;
                 }
 
                 return false;
             }
 
-            bool isFor (PatchView& v, const EndpointID& e, const std::string& type) const
-            {
-                return std::addressof (view) == std::addressof (v) && replyType == type && endpointID == e.toString();
-            }
-
-            PatchView& view;
-            const std::string endpointID, replyType;
+            const std::string endpointID;
+            const std::shared_ptr<ClientEventQueue::MonitorTap> tap;
             const bool isMIDI;
         };
 
@@ -1550,21 +1870,31 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
         bool remove (PatchView& view, const EndpointID& e, std::string replyType)
         {
             if (auto l = findAudioDataListener (e))
-                return l->removeMonitor (view, e, replyType);
-
-            auto oldEnd = eventMonitors.end();
-            auto newEnd = std::remove_if (eventMonitors.begin(), oldEnd,
-                                          [&] (auto& m) { return m->isFor (view, e, replyType); });
+                return l->removeMonitor (view, replyType);
 
-            if (newEnd != oldEnd)
+            if (auto m = findEventMonitor (e))
             {
-                eventMonitors.erase (newEnd, oldEnd);
-                return true;
+                if (m->tap->removeSubscriber (view, replyType))
+                {
+                    removeUnusedMonitors (eventMonitors);
+                    return true;
+                }
             }
 
             return false;
         }
 
+        EventMonitor* findEventMonitor (const EndpointID& e) const
+        {
+            auto endpointID = e.toString();
+
+            for (auto& m : eventMonitors)
+                if (m->endpointID == endpointID)
+                    return m.get();
+
+            return {};
+        }
+
         DataListener* findAudioDataListener (const EndpointID& e) const
         {
             if (auto l = dataListeners.find (e.toString()); l != dataListeners.end())
@@ -1578,17 +1908,15 @@ struct Patch::PatchRenderer  : public std::enable_shared_from_this<PatchRenderer
             if (! value.isVoid())
                 for (auto& m : eventMonitors)
                     if (m->endpointID == endpointID)
-                        p.sendMessageToView (m->view, m->replyType, value);
+                        p.clientEventQueue->sendEndpointEventToTap (*m->tap, value);
         }
 
         void removeReferencesToView (PatchView& v)
         {
-            auto oldEnd = eventMonitors.end();
-            auto newEnd = std::remove_if (eventMonitors.begin(), oldEnd,
-                                          [&] (auto& m) { return std::addressof (m->view) == std::addressof (v); });
+            for (auto& m : eventMonitors)
+                m->tap->removeSubscribers (v);
 
-            if (newEnd != oldEnd)
-                eventMonitors.erase (newEnd, oldEnd);
+            removeUnusedMonitors (eventMonitors);
 
             for (auto& d : dataListeners)
                 d.second->removeMonitorsForView (v);
@@ -1636,9 +1964,12 @@ struct Patch::Build
         auto engine = patch.createEngine();
         CMAJ_ASSERT (engine);
 
+        loadParams.manifest.audioFileCacheFolder = patch.audioFileCacheFolder;
+
         renderer = std::make_shared<PatchRenderer> (patch);
         renderer->build (engine, loadParams, patch.currentPlaybackParams,
-                         resolveExternals, performLink, patch.cache,
+                         resolveExternals, performLink,
+                         patch.cache != nullptr ? patch.cache : patch.rebuildCache,
                          checkForStopSignal, patch.performerEventQueueSize);
         return engine;
     }
@@ -1773,6 +2104,7 @@ inline Patch::Patch()
     midiMessages.reserve (midiBufferSize);
 
     clientEventQueue = std::make_unique<ClientEventQueue> (*this);
+    rebuildCache = choc::com::create<InMemoryCacheDatabase> (64 * 1024 * 1024);
 }
 
 inline Patch::~Patch()
@@ -2152,7 +2484,7 @@ inline void Patch::processChunk (const choc::audio::AudioMIDIBlockDispatcher::Bl
 
 inline void Patch::endChunkedProcess()
 {
-    clientEventQueue->endOfProcessCallback();
+    clientEventQueue->endOfProcessCallback (renderer->getPerformer().performer.getNodeProfileCounters());
     renderer->endProcessBlock();
 }
 
@@ -2189,6 +2521,16 @@ inline void Patch::sendMessageToView (PatchView& view, std::string_view type, co
                                               "message", message));
 }
 
+/// Packed data is marked by a "packed" property on the outer message rather than inside
+/// the payload, so that no value sent by the patch itself can be mistaken for it.
+inline void Patch::sendPackedDataToView (PatchView& view, std::string_view type, std::string_view format, const choc::value::ValueView& packedData) const
+{
+    if (std::find (activeViews.begin(), activeViews.end(), std::addressof (view)) != activeViews.end())
+        view.sendMessage (choc::json::create ("type", type,
+                                              "packed", format,
+                                              "message", packedData));
+}
+
 inline void Patch::broadcastMessageToViews (std::string_view type, const choc::value::ValueView& message) const
 {
     auto msg = choc::json::create ("type", type,
@@ -2319,10 +2661,14 @@ inline void Patch::sendParameterChangeToViews (const EndpointID& endpointID, flo
                                                      "value", value));
 }
 
-inline void Patch::sendCPUInfoToViews (float level) const
+inline void Patch::sendCPUInfoToViews (float level, const choc::value::ValueView& nodeProfile) const
 {
-    broadcastMessageToViews ("cpu_info",
-                             choc::json::create ("level", level));
+    auto message = choc::json::create ("level", level);
+
+    if (nodeProfile.isArray())
+        message.addMember ("nodes", nodeProfile);
+
+    broadcastMessageToViews ("cpu_info", message);
 }
 
 inline void Patch::sendStoredStateValueToViews (const std::string& key) const
@@ -21,6 +21,7 @@
 #include "../../choc/threading/choc_ThreadSafeFunctor.h"
 #include "../../choc/threading/choc_TaskThread.h"
 #include "../../choc/platform/choc_HighResolutionSteadyClock.h"
+#include "../../choc/memory/choc_xxHash.h"
 #include "cmaj_PatchManifest.h"
 #include "../API/cmaj_Endpoints.h"
 
@@ -140,18 +141,44 @@ private:
         SourceFilesWithTimes (SourceFilesWithTimes&&) = default;
         SourceFilesWithTimes& operator= (SourceFilesWithTimes&&) = default;
 
+        /// Files are compared by a hash of their content rather than their modification
+        /// time, so that saving a file without actually changing it doesn't trigger a rebuild.
+        /// The modification time is only used to avoid re-reading files that haven't been touched.
         struct File
         {
             std::string file;
             std::filesystem::file_time_type lastWriteTime;
+            uint64_t contentHash = 0;
 
-            bool operator== (const File& other) const   { return file == other.file && lastWriteTime == other.lastWriteTime; }
+            bool operator== (const File& other) const   { return file == other.file && contentHash == other.contentHash; }
             bool operator!= (const File& other) const   { return ! operator== (other); }
         };
 
-        void add (const PatchManifest& m, const std::string& file)
+        void add (const PatchManifest& m, const std::string& file, const SourceFilesWithTimes& previous)
         {
-            files.push_back ({ file, m.getFileModificationTime (file) });
+            File f { file, m.getFileModificationTime (file) };
+
+            if (auto old = previous.find (file); old != nullptr && old->lastWriteTime == f.lastWriteTime)
+            {
+                f.contentHash = old->contentHash;
+            }
+            else if (auto content = m.readFileContent (file))
+            {
+                choc::hash::xxHash64 hash;
+                hash.addInput (*content);
+                f.contentHash = hash.getHash();
+            }
+
+            files.push_back (std::move (f));
+        }
+
+        const File* find (const std::string& file) const
+        {
+            for (auto& f : files)
+                if (f.file == file)
+                    return std::addressof (f);
+
+            return {};
         }
 
         bool operator== (const SourceFilesWithTimes& other) const { return files == other.files; }
@@ -565,22 +592,28 @@ inline PatchFileChangeChecker::ChangeType PatchFileChangeChecker::checkAndReset(
 {
     SourceFilesWithTimes newManifests, newSources, newAssets;
 
-    newManifests.add (manifest, manifest.manifestFile);
+    newManifests.add (manifest, manifest.manifestFile, manifestFiles);
 
     for (auto& f : manifest.sourceFiles)
-        newSources.add (manifest, f);
+        newSources.add (manifest, f, cmajorFiles);
 
     for (auto& v : manifest.views)
-        newAssets.add (manifest, v.getSource());
+        newAssets.add (manifest, v.getSource(), assetFiles);
 
     if (! manifest.patchWorker.empty())
-        newSources.add (manifest, manifest.patchWorker);
+        newSources.add (manifest, manifest.patchWorker, cmajorFiles);
 
     ChangeType changes;
 
-    if (manifestFiles != newManifests) { changes.manifestChanged    = true;  manifestFiles = std::move (newManifests); }
-    if (cmajorFiles != newSources)     { changes.cmajorFilesChanged = true;  cmajorFiles = std::move (newSources); }
-    if (assetFiles != newAssets)       { changes.assetFilesChanged  = true;  assetFiles = std::move (newAssets); }
+    changes.manifestChanged    = manifestFiles != newManifests;
+    changes.cmajorFilesChanged = cmajorFiles != newSources;
+    changes.assetFilesChanged  = assetFiles != newAssets;
+
+    // always keep the latest times, even if the content is the same, so that
+    // unchanged files don't need to be re-read next time
+    manifestFiles = std::move (newManifests);
+    cmajorFiles = std::move (newSources);
+    assetFiles = std::move (newAssets);
 
     return changes;
 }
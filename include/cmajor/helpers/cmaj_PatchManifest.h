@@ -23,6 +23,7 @@
 #include <unordered_map>
 #include "../../choc/platform/choc_Platform.h"
 #include "../../choc/text/choc_Files.h"
+#include "../../choc/memory/choc_xxHash.h"
 #include "../../choc/audio/choc_AudioFileFormat_WAV.h"
 #include "../../choc/audio/choc_AudioFileFormat_Ogg.h"
 #include "../../choc/audio/choc_AudioFileFormat_FLAC.h"
@@ -105,6 +106,10 @@ struct PatchManifest
     /// program, e.g in an exported C++ version of a patch.
     bool needsToBuildSource = true;
 
+    /// If this is set, audio files used as externals are decoded once into cache files in
+    /// this folder, and are then mapped from there rather than decoded into a Value.
+    std::string audioFileCacheFolder;
+
     // These functors are used for all file access, as the patch may be loaded from
     // all sorts of virtual filesystems
 
@@ -495,6 +500,26 @@ inline choc::value::Value readManifestResourceAsAudioData (const PatchManifest&
         formats.addFormat<choc::audio::FLACAudioFileFormat<false>>();
         formats.addFormat<choc::audio::WAVAudioFileFormat<true>>();
 
+        if (! manifest.audioFileCacheFolder.empty())
+        {
+            // The cache file is named after everything that affects the decoded frames
+            choc::hash::xxHash64 hash;
+            hash.addInput (manifest.getFullPathForFile (path));
+            hash.addInput (std::to_string (manifest.getFileModificationTime (path).time_since_epoch().count()));
+            hash.addInput (choc::json::toString (annotation));
+
+            auto cacheFile = std::filesystem::path (manifest.audioFileCacheFolder)
+                               / ("audio_" + choc::text::createHexString (hash.getHash()) + ".cmajaudio");
+
+            auto error = cmaj::readAudioFileAsMappedValue (audioFileContent, cacheFile.string(), formats,
+                                                           [&] { return reader; }, annotation);
+
+            if (! error.empty())
+                return {};
+
+            return audioFileContent;
+        }
+
         auto error = cmaj::readAudioFileAsValue (audioFileContent, formats, reader, annotation);
 
         if (! error.empty())
@@ -35,12 +35,16 @@ struct PerformerProxy  : public PerformerInterface
     void setInputFrames (EndpointHandle e, const void* data, uint32_t numFrames) override           { target->setInputFrames (e, data, numFrames); }
     void setInputValue (EndpointHandle e, const void* data, uint32_t n) override                    { target->setInputValue (e, data, n); }
     void addInputEvent (EndpointHandle e, uint32_t index, const void* data) override                { target->addInputEvent (e, index, data); }
+    void addInputEvents (EndpointHandle e, const EventBatch* batch) override                        { target->addInputEvents (e, batch); }
+    bool supportsEventFrameOffsets() override                                                       { return target->supportsEventFrameOffsets(); }
     void copyOutputValue (EndpointHandle e, void* dest) override                                    { target->copyOutputValue (e, dest); }
     void copyOutputFrames (EndpointHandle e, void* dest, uint32_t num) override                     { target->copyOutputFrames (e, dest, num); }
+    void* getStreamFrameBuffer (EndpointHandle e) override                                          { return target->getStreamFrameBuffer (e); }
     void iterateOutputEvents (EndpointHandle e, void* c, HandleOutputEventCallback h) override      { return target->iterateOutputEvents (e, c, h); }
     void advance() override                                                                         { target->advance(); }
     const char* getStringForHandle (uint32_t h, size_t& len) override                               { return target->getStringForHandle (h, len); }
     uint32_t getXRuns() override                                                                    { return target->getXRuns(); }
+    const NodeProfileCounter* getNodeProfileCounters (uint32_t& numNodes) override                  { return target->getNodeProfileCounters (numNodes); }
     uint32_t getMaximumBlockSize() override                                                         { return target->getMaximumBlockSize(); }
     double getLatency() override                                                                    { return target->getLatency(); }
     uint32_t getEventBufferSize() override                                                          { return target->getEventBufferSize(); }
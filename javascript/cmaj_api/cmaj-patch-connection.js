@@ -151,7 +151,7 @@ export class PatchConnection  extends EventListenerList
      *     two properties 'min' and 'max', which are each an array of values, one element per audio
      *     channel. This allows you to find the highest and lowest samples in that chunk for each channel.
      *     If sendFullAudioData is true, the listener's argument will have a property 'data' which is an
-     *     array containing one array per channel of raw audio samples data.
+     *     array containing one Float32Array per channel of raw audio samples data.
      */
     addEndpointListener (endpointID, listener, granularity, sendFullAudioData)
     {
@@ -237,6 +237,74 @@ export class PatchConnection  extends EventListenerList
         if (msg.type == "param_value")
             this.dispatchEvent ("param_value_" + msg.message.endpointID, msg.message.value);
 
+        // The server marks packed data on the outer message, which patch values can't reach
+        if (msg.packed)
+            msg.message = unpackMessage (msg.packed, msg.message);
+
         this.dispatchEvent (msg.type, msg.message);
     }
 }
+
+//==============================================================================
+// Large blocks of audio and numeric event data arrive as base64-encoded binary
+// rather than as JSON arrays, so these helpers turn them back into typed arrays.
+
+const base64Values = (() =>
+{
+    const table = new Uint8Array (128);
+    const chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    for (let i = 0; i < chars.length; ++i)
+        table[chars.charCodeAt (i)] = i;
+
+    return table;
+})();
+
+function decodeBase64 (text)
+{
+    let length = text.length;
+
+    while (length > 0 && text[length - 1] === "=")
+        --length;
+
+    const bytes = new Uint8Array ((length * 3) >> 2);
+    let out = 0;
+
+    for (let i = 0; i < length; i += 4)
+    {
+        const a = base64Values[text.charCodeAt (i)];
+        const b = base64Values[text.charCodeAt (i + 1)];
+        const c = base64Values[text.charCodeAt (i + 2)];
+        const d = base64Values[text.charCodeAt (i + 3)];
+
+        bytes[out++] = (a << 2) | (b >> 4);
+        if (out < bytes.length)  bytes[out++] = ((b & 15) << 4) | (c >> 2);
+        if (out < bytes.length)  bytes[out++] = ((c & 3) << 6) | d;
+    }
+
+    return bytes.buffer;
+}
+
+function unpackMessage (format, message)
+{
+    const buffer = decodeBase64 (message.data);
+    let values;
+
+    switch (format)
+    {
+        case "float32":  values = new Float32Array (buffer); break;
+        case "float64":  values = new Float64Array (buffer); break;
+        case "int32":    values = new Int32Array (buffer); break;
+        default:         return message;
+    }
+
+    if (message.numChannels === undefined)
+        return values;
+
+    const channels = [];
+
+    for (let i = 0; i < message.numChannels; ++i)
+        channels.push (values.subarray (i * message.numFrames, (i + 1) * message.numFrames));
+
+    return { data: channels };
+}
@@ -271,6 +271,8 @@ export class ServerSession   extends EventListenerList
     /** Attaches a listener function which will be sent messages containing CPU info.
      *  To remove the listener, call `removeCPUListener()`. To change the rate of these
      *  messages, use `setCPULevelUpdateRate()`.
+     *  If the patch was built with the `profileNodes` build setting, each message also
+     *  has a `nodes` array giving the `name` and `cyclesPerFrame` of each graph node.
      */
     addCPUListener (listener)                       { this.addEventListener    ("cpu_info", listener); this.updateCPULevelUpdateRate(); }
 
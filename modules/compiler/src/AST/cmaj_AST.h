@@ -47,6 +47,8 @@
 #include "../../../../include/cmajor/API/cmaj_DiagnosticMessages.h"
 #include "../../../../include/cmajor/API/cmaj_BuildSettings.h"
 
+#include "../utilities/cmaj_MappedAudioFile.h"
+
 #include "cmaj_EnumList.h"
 #include "cmaj_IdentifierPath.h"
 
@@ -183,8 +183,10 @@ struct Function  : public Object
     bool isMainFunction() const                     { return name == getStrings().mainFunctionName; }
     bool isSystemInitFunction() const               { return name == getStrings().systemInitFunctionName; }
     bool isSystemAdvanceFunction() const            { return name == getStrings().systemAdvanceFunctionName; }
+    bool isSystemAdvanceToFunction() const          { return name == getStrings().systemAdvanceToFunctionName; }
     bool isUserInitFunction() const                 { return name == getStrings().userInitFunctionName; }
     bool isResetFunction() const                    { return name == getStrings().resetFunctionName && getNumNonInternalParameters() == 0; }
+    bool isIdleFunction() const                     { return name == getStrings().idleFunctionName && getNumNonInternalParameters() == 0; }
     bool isExportedFunction() const                 { return isExported || isEventHandler || isSystemInitFunction() || isSystemAdvanceFunction() || isMainFunction() || isUserInitFunction(); }
     bool isGenericOrParameterised() const override  { return ! genericWildcards.empty(); }
     bool isSpecialisedGeneric() const               { return originalGenericFunction != nullptr; }
@@ -865,6 +867,7 @@ struct LoopStatement  : public Statement
         X (4, ChildObject, numIterations) /* may be a variable with a bounded type, or just an integer constant */ \
         X (5, ChildObject, body) \
         X (6, StringProperty, label) \
+        X (7, BoolProperty, hasIndependentIterations) /* set for loops that run an array of nodes, to let back-ends vectorise them */ \
 
     CMAJ_DECLARE_PROPERTIES(CMAJ_PROPERTIES)
     #undef CMAJ_PROPERTIES
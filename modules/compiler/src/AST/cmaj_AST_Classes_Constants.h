@@ -518,7 +518,36 @@ struct ConstantAggregate  : public ConstantValueBase
 
     ptr<const TypeBase> getResultType() const override          { return castToTypeBase (type); }
     TypeBase& getType() const                                   { return castToTypeBaseRef (type); }
-    void writeSignature (SignatureBuilder& sig) const override  { sig << type << values; }
+
+    void writeSignature (SignatureBuilder& sig) const override
+    {
+        sig << type << values;
+
+        if (refersToExternalData())
+            sig << externalDataFile << externalDataSize;
+    }
+
+    /// A slice constant can refer to a block of frame data that the engine has mapped
+    /// into memory, rather than holding its elements as AST objects. Its elements are
+    /// then unknown at compile-time, and the back-end must reference the data directly.
+    static constexpr std::string_view externalDataClassName = "cmaj::ExternalData";
+
+    bool refersToExternalData() const                           { return ! externalDataFile.get().empty(); }
+    const void* getExternalData() const                         { return getExternalDataFile().getFrameData(); }
+
+    /// Returns the mapping that holds this constant's elements. The constant keeps it
+    /// open, so the data can't be unmapped while anything can still refer to it. A clone
+    /// only copies the file's name, and finds the same shared mapping when it's needed.
+    const MappedAudioFile& getExternalDataFile() const
+    {
+        CMAJ_ASSERT (refersToExternalData());
+
+        if (externalDataMapping == nullptr)
+            externalDataMapping = MappedAudioFile::open (std::string (externalDataFile.get()));
+
+        CMAJ_ASSERT (externalDataMapping != nullptr);
+        return *externalDataMapping;
+    }
 
     template <typename Type, typename GetterFn>
     std::optional<Type> getIfVectorSize1 (GetterFn&& getter) const
@@ -673,18 +702,24 @@ struct ConstantAggregate  : public ConstantValueBase
         auto& t = getType().skipConstAndRefModifiers();
 
         if (t.isSlice())
-            return static_cast<ArraySize> (values.size());
+            return static_cast<ArraySize> (refersToExternalData() ? externalDataSize.get() : static_cast<int64_t> (values.size()));
 
         return t.getFixedSizeAggregateNumElements();
     }
 
     ptr<const ConstantValueBase> getAggregateElementValue (int64_t index) const override
     {
+        if (refersToExternalData())
+            return {};
+
         return getElementValueRefWrapped (index);
     }
 
     ptr<ConstantValueBase> getOrCreateAggregateElementValue (uint32_t index)
     {
+        if (refersToExternalData())
+            return {};
+
         if (index < values.size())
             return getElement (index);
 
@@ -720,7 +755,7 @@ struct ConstantAggregate  : public ConstantValueBase
 
     ptr<ConstantValueBase> getElementSlice (IntegerRange range) const
     {
-        if (! range.isValid())
+        if (! range.isValid() || refersToExternalData())
             return {};
 
         auto& typeRef = castToTypeBaseRef (type);
@@ -755,6 +790,12 @@ struct ConstantAggregate  : public ConstantValueBase
         auto& resultType = getType().skipConstAndRefModifiers();
         auto numResultElements = resultType.getFixedSizeAggregateNumElements();
 
+        if (refersToExternalData())
+        {
+            CMAJ_ASSERT (sliceToValue != nullptr);
+            return (*sliceToValue) (getExternalDataAsValue());
+        }
+
         if (resultType.isArrayType())
         {
             if (values.empty() && ! resultType.isSlice())
@@ -823,6 +864,17 @@ struct ConstantAggregate  : public ConstantValueBase
         return {};
     }
 
+    choc::value::Value getExternalDataAsValue() const
+    {
+        auto& elementType = *getType().skipConstAndRefModifiers().getArrayOrVectorElementType();
+        auto numElements = static_cast<uint32_t> (externalDataSize.get());
+        auto frameType = elementType.toChocType();
+
+        choc::value::ValueView view (choc::value::Type::createArray (frameType, numElements),
+                                     const_cast<void*> (getExternalData()), nullptr);
+        return choc::value::Value (view);
+    }
+
     template <typename ElementType>
     choc::value::Value toVectorValue (uint32_t numElements) const
     {
@@ -842,6 +894,19 @@ struct ConstantAggregate  : public ConstantValueBase
 
         if (resultType.getAsArrayType() != nullptr)
         {
+            if (resultType.isSlice() && v.isObject() && v.getObjectClassName() == externalDataClassName)
+            {
+                values.reset();
+                externalDataMapping = MappedAudioFile::open (std::string (v["path"].getWithDefault<std::string_view> ({})));
+
+                if (externalDataMapping == nullptr)
+                    return false;
+
+                externalDataFile = getStringPool().get (externalDataMapping->path);
+                externalDataSize = v["size"].getWithDefault<int64_t> (0);
+                return true;
+            }
+
             if (numResultElements == 0)
                 numResultElements = v.size();
 
@@ -893,6 +958,17 @@ struct ConstantAggregate  : public ConstantValueBase
     {
         if (auto agg = v.getAsConstantAggregate())
         {
+            if (agg->refersToExternalData())
+            {
+                values.reset();
+                externalDataFile = getStringPool().get (agg->getExternalDataFile().path);
+                externalDataSize = agg->externalDataSize.get();
+                externalDataMapping = agg->externalDataMapping;
+                return;
+            }
+
+            clearExternalData();
+
             if (agg->values.empty())
                 return setToZero();
 
@@ -924,8 +1000,18 @@ struct ConstantAggregate  : public ConstantValueBase
         }
     }
 
+    void clearExternalData()
+    {
+        externalDataFile.reset();
+        externalDataSize = 0;
+        externalDataMapping.reset();
+    }
+
     void setToZero() override
     {
+        if (refersToExternalData())
+            clearExternalData();
+
         if (! isZero())
             for (auto& v : values)
                 castToConstantRef (v).setToZero();
@@ -933,6 +1019,9 @@ struct ConstantAggregate  : public ConstantValueBase
 
     bool isZero() const override
     {
+        if (refersToExternalData())
+            return false;
+
         for (size_t i = 0; i < values.size(); ++i)
             if (! getElement (i).isZero())
                 return false;
@@ -942,8 +1031,13 @@ struct ConstantAggregate  : public ConstantValueBase
 
     #define CMAJ_PROPERTIES(X) \
         X (1, ChildObject, type) \
-        X (2, ListProperty, values)
+        X (2, ListProperty, values) \
+        X (3, StringProperty, externalDataFile) \
+        X (4, IntegerProperty, externalDataSize)
 
     CMAJ_DECLARE_PROPERTIES(CMAJ_PROPERTIES)
     #undef CMAJ_PROPERTIES
+
+private:
+    mutable std::shared_ptr<const MappedAudioFile> externalDataMapping;
 };
@@ -243,6 +243,7 @@ struct ProcessorBase  : public ModuleBase
     ptr<Function> findSystemInitFunction() const              { return findFunction ([] (const Function& f) { return f.isSystemInitFunction(); }); }
     ptr<Function> findSystemAdvanceFunction() const           { return findFunction ([] (const Function& f) { return f.isSystemAdvanceFunction(); }); }
     ptr<Function> findResetFunction() const                   { return findFunction ([] (const Function& f) { return f.isResetFunction(); }); }
+    ptr<Function> findIdleFunction() const                    { return findFunction ([] (const Function& f) { return f.isIdleFunction(); }); }
 
     ptr<VariableDeclaration> findVariable (PooledString variableName) override
     {
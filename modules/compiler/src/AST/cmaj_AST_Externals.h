@@ -25,6 +25,14 @@ struct ExternalVariableManager
         context = c;
         requestExternalVariable = fn;
         externals.clear();
+        referencedExternalData.clear();
+    }
+
+    /// Engines which can reference frame data in memory rather than compiling it into
+    /// the program call this, so that mapped audio files are bound directly to slices.
+    void setCanReferenceExternalData (bool canReference)
+    {
+        canReferenceExternalData = canReference;
     }
 
     bool addExternalIfNotPresent (VariableDeclaration& v)
@@ -53,6 +61,10 @@ struct ExternalVariableManager
 
     bool setValue (std::string name, choc::value::ValueView value)
     {
+        // Only this class may create objects that point at external data
+        if (containsExternalDataObject (value))
+            return false;
+
         if (externals.find (name) != externals.end())
         {
             externals[name] = value;
@@ -62,13 +74,118 @@ struct ExternalVariableManager
         return false;
     }
 
+    //==============================================================================
+    /// Returns the mapped files whose frames the program refers to directly. These
+    /// need to stay alive for as long as any code generated from the program.
+    const std::vector<std::shared_ptr<const MappedAudioFile>>& getReferencedExternalData() const
+    {
+        return referencedExternalData;
+    }
+
+    /// Returns the name a back-end should use for the symbol which refers to a
+    /// block of external data.
+    std::string getExternalDataSymbolName (const void* data) const
+    {
+        for (size_t i = 0; i < referencedExternalData.size(); ++i)
+            if (referencedExternalData[i]->getFrameData() == data)
+                return "_cmaj_external_data_" + std::to_string (i);
+
+        CMAJ_ASSERT_FALSE;
+        return {};
+    }
+
+    /// Returns a map of symbol names to addresses for all the external data blocks
+    std::unordered_map<std::string, void*> getExternalDataSymbols() const
+    {
+        std::unordered_map<std::string, void*> symbols;
+
+        for (auto& file : referencedExternalData)
+            symbols[getExternalDataSymbolName (file->getFrameData())] = const_cast<float*> (file->getFrameData());
+
+        return symbols;
+    }
+
+    /// Returns a string describing the layout of the external data, which affects the
+    /// generated code even though the data itself doesn't.
+    std::string getExternalDataDescription() const
+    {
+        std::string result;
+
+        for (auto& file : referencedExternalData)
+            result += std::to_string (file->numChannels) + "x" + std::to_string (file->numFrames) + " ";
+
+        return result;
+    }
+
+    /// Adds the values that have been supplied for the program's externals to a hash.
+    /// These get baked into the generated code (or into the names of the data blocks it
+    /// links to), so a cache key has to change whenever any of them do.
+    void addExternalValuesToHash (choc::hash::xxHash64& hash) const
+    {
+        struct HashWriter
+        {
+            void write (const void* data, size_t size)   { hash.addInput (data, size); }
+            choc::hash::xxHash64& hash;
+        };
+
+        std::vector<std::string> names;
+
+        for (auto& e : externals)
+            names.push_back (e.first);
+
+        std::sort (names.begin(), names.end());
+        HashWriter writer { hash };
+
+        for (auto& name : names)
+        {
+            hash.addInput (name);
+
+            if (auto& value = externals.at (name); value.has_value())
+                value->serialise (writer);
+        }
+
+        for (auto& file : referencedExternalData)
+        {
+            hash.addInput (file->path);
+            hash.addInput (std::addressof (file->sampleRate), sizeof (file->sampleRate));
+        }
+    }
+
 private:
     std::unordered_map<std::string, std::optional<choc::value::Value>> externals;
+    std::vector<std::shared_ptr<const MappedAudioFile>> referencedExternalData;
 
     EngineInterface::RequestExternalVariableFn requestExternalVariable = nullptr;
     void* context = nullptr;
+    bool canReferenceExternalData = false;
+
+    static bool containsExternalDataObject (const choc::value::ValueView& value)
+    {
+        if (value.isObject())
+        {
+            if (value.getObjectClassName() == ConstantAggregate::externalDataClassName)
+                return true;
+
+            for (uint32_t i = 0; i < value.size(); ++i)
+                if (containsExternalDataObject (value.getObjectMemberAt (i).value))
+                    return true;
+        }
+        else if (value.isArray())
+        {
+            auto type = value.getType();
+
+            if (type.isUniformArray() && (type.getElementType().isPrimitive() || type.getElementType().isVector()))
+                return false;
+
+            for (auto element : value)
+                if (containsExternalDataObject (element))
+                    return true;
+        }
+
+        return false;
+    }
 
-    static bool initialiseExternal (VariableDeclaration& variable)
+    bool initialiseExternal (VariableDeclaration& variable)
     {
         if (variable.initialValue == nullptr)
         {
@@ -102,7 +219,7 @@ private:
         return {};
     }
 
-    static bool applyValueToVariableInitialiser (VariableDeclaration& variable, choc::value::ValueView value)
+    bool applyValueToVariableInitialiser (VariableDeclaration& variable, choc::value::ValueView value)
     {
         auto& variableType = castToTypeBaseRef (variable.declaredType);
         auto coerced = coerceAudioDataToType (variableType.toChocType(), value);
@@ -268,7 +385,52 @@ private:
         return std::move (sourceArray);
     }
 
-    static choc::value::Value coerceAudioDataToType (const choc::value::Type& targetType, const choc::value::ValueView& sourceValue)
+    choc::value::Value coerceAudioFrames (const choc::value::Type& targetArrayType, choc::value::Value&& frames)
+    {
+        if (isMappedAudioFramesObject (frames))
+            return resolveMappedAudioFrames (targetArrayType, frames);
+
+        return coerceAudioFrameArray (targetArrayType.getElementType(), std::move (frames));
+    }
+
+    /// Binds a mapped audio file to a frame array. If the engine can reference the data and
+    /// the frames are already in the right layout, the result is an object which tells the
+    /// slice constant to point at the mapped memory. Otherwise the frames are copied.
+    choc::value::Value resolveMappedAudioFrames (const choc::value::Type& targetArrayType, const choc::value::ValueView& mappedFrames)
+    {
+        auto file = MappedAudioFile::open (std::string (mappedFrames["path"].getWithDefault<std::string_view> ({})));
+
+        if (file == nullptr
+             || file->numChannels != static_cast<uint32_t> (mappedFrames["numChannels"].getWithDefault<int32_t> (0))
+             || file->numFrames != static_cast<uint64_t> (mappedFrames["numFrames"].getWithDefault<int64_t> (0))
+             || file->numFrames > static_cast<uint64_t> (maxNumFrames))
+            return {};
+
+        auto sourceFrameType = file->numChannels == 1 ? choc::value::Type::createFloat32()
+                                                      : choc::value::Type::createVector<float> (file->numChannels);
+        auto targetFrameType = targetArrayType.getElementType();
+
+        // Only power-of-2 channel counts have the same layout in memory as a vector type
+        bool isSlice = targetArrayType.getNumElements() == 0;
+        bool hasSameLayout = targetFrameType == sourceFrameType && choc::math::isPowerOf2 (file->numChannels);
+
+        if (canReferenceExternalData && isSlice && hasSameLayout)
+        {
+            if (std::find (referencedExternalData.begin(), referencedExternalData.end(), file) == referencedExternalData.end())
+                referencedExternalData.push_back (file);
+
+            return choc::value::createObject (ConstantAggregate::externalDataClassName,
+                                              "path", file->path,
+                                              "size", static_cast<int64_t> (file->numFrames));
+        }
+
+        choc::value::ValueView frames (choc::value::Type::createArray (sourceFrameType, static_cast<uint32_t> (file->numFrames)),
+                                       const_cast<float*> (file->getFrameData()), nullptr);
+
+        return coerceAudioFrameArray (targetFrameType, choc::value::Value (frames));
+    }
+
+    choc::value::Value coerceAudioDataToType (const choc::value::Type& targetType, const choc::value::ValueView& sourceValue)
     {
         if (sourceValue.isObject())
         {
@@ -280,14 +442,14 @@ private:
 
                 if (isSampleRateName (member.name) && isSampleRateType (member.value.getType()))
                     rate = member.value;
-                else if (isFrameArray (member.value.getType()))
+                else if (isFrameArray (member.value.getType()) || isMappedAudioFramesObject (member.value))
                     frames = member.value;
             }
 
             if (! (frames.isVoid() && rate.isVoid()))
             {
                 if (targetType.isArray())
-                    return frames;
+                    return isMappedAudioFramesObject (frames) ? resolveMappedAudioFrames (targetType, frames) : frames;
 
                 if (targetType.isObject())
                 {
@@ -300,7 +462,7 @@ private:
                         if (isSampleRateName (member.name) && isSampleRateType (member.type))
                             o.setMember (member.name, rate);
                         else if (isFrameArray (member.type))
-                            o.setMember (member.name, coerceAudioFrameArray (member.type.getElementType(), std::move (frames)));
+                            o.setMember (member.name, coerceAudioFrames (member.type, std::move (frames)));
                     }
 
                     return o;
@@ -44,6 +44,7 @@ struct Intrinsic
         X(sinh,                    1,   false,  true  ) \
         X(cosh,                    1,   false,  true  ) \
         X(tanh,                    1,   false,  true  ) \
+        X(sigmoid,                 1,   false,  true  ) \
         X(asinh,                   1,   false,  true  ) \
         X(acosh,                   1,   false,  true  ) \
         X(atanh,                   1,   false,  true  ) \
@@ -55,6 +56,10 @@ struct Intrinsic
         X(isinf,                   1,   false,  true  ) \
         X(reinterpretFloatToInt,   1,   false,  true  ) \
         X(reinterpretIntToFloat,   1,   true,   false ) \
+        X(complexFFT,              1,   false,  false ) \
+        X(complexIFFT,             1,   false,  false ) \
+        X(matrixVectorMultiply,    3,   false,  false ) \
+        X(matrixVectorMultiplyAdd, 4,   false,  false ) \
 
     enum class Type
     {
@@ -211,6 +216,7 @@ private:
     template <typename T> static T perform_sinh          (const T* args)  { return std::sinh (args[0]); }
     template <typename T> static T perform_cosh          (const T* args)  { return std::cosh (args[0]); }
     template <typename T> static T perform_tanh          (const T* args)  { return std::tanh (args[0]); }
+    template <typename T> static T perform_sigmoid       (const T* args)  { return static_cast<T> (1) / (static_cast<T> (1) + std::exp (-args[0])); }
     template <typename T> static T perform_asinh         (const T* args)  { return std::asinh (args[0]); }
     template <typename T> static T perform_acosh         (const T* args)  { return std::acosh (args[0]); }
     template <typename T> static T perform_atanh         (const T* args)  { return std::atanh (args[0]); }
@@ -87,6 +87,7 @@ struct ObjectContext
     static constexpr const char* propertyNames[numProperties] = { LIST(CMAJ_OBJ_DECLARE_PROPERTY_NAMES) }; \
     PropertyList getPropertyList() override                             { PropertyList props (numProperties); uint32_t i = 0; LIST(CMAJ_OBJ_FILL_PROP_LIST) return props; } \
     Property* findPropertyForID (uint32_t targetID) override            { LIST(CMAJ_OBJ_FIND_PROP_FOR_ID) return nullptr; } \
+    const Property* findPropertyForID (uint32_t targetID) const override { LIST(CMAJ_OBJ_FIND_PROP_FOR_ID) return nullptr; } \
     template <typename VisitorType> void visitObjects (VisitorType& v)  { LIST(CMAJ_OBJ_VISIT_OBJECT_PROPERTY); } \
     bool isIdentical (const Object& other) const override               { return classID == other.getObjectClassID() LIST(CMAJ_OBJ_COMPARE_PROPERTY); } \
 
@@ -123,6 +124,7 @@ struct Object
     virtual std::string_view getPropertyName (uint32_t) const           { CMAJ_ASSERT_FALSE; }
     virtual uint8_t getPropertyID (uint32_t) const                      { CMAJ_ASSERT_FALSE; }
     virtual Property* findPropertyForID (uint32_t)                      { CMAJ_ASSERT_FALSE; }
+    virtual const Property* findPropertyForID (uint32_t) const          { CMAJ_ASSERT_FALSE; }
     virtual bool canConstantFoldProperty (const Property&)              { return true; }
     virtual bool isDummyStatement() const                               { return false; }
     virtual ptr<const Comment> getComment() const                       { return {}; }
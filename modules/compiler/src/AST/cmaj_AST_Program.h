@@ -154,6 +154,7 @@ struct Program  : public choc::com::ObjectWithAtomicRefCount<cmaj::ProgramInterf
     bool reparse()
     {
         needsReparsing = false;
+        resolvedModules.clear();
         rootNamespace.clear();
         endpointList.clear();
         mainProcessor = {};
@@ -237,6 +238,78 @@ struct Program  : public choc::com::ObjectWithAtomicRefCount<cmaj::ProgramInterf
     AST::ExternalVariableManager externalVariableManager;
     AST::ExternalFunctionManager externalFunctionManager;
 
+    //==============================================================================
+    /// Keeps track of modules which were added to the program already resolved (i.e. the
+    /// standard library), so that the resolution passes can leave them alone. A module only
+    /// counts as unmodified while nothing has been added to or removed from it, or from any
+    /// of the modules inside it.
+    struct ResolvedModuleList
+    {
+        void clear()                        { modules.clear(); }
+        void add (AST::ModuleBase& m)       { add (m, noParent); }
+
+        std::vector<ref<AST::ModuleBase>> getUnmodifiedModules() const
+        {
+            std::vector<bool> modified (modules.size());
+
+            // parents always come before their children, so going backwards means
+            // that a change in a child has reached its parent before the parent is checked
+            for (auto i = modules.size(); i > 0; --i)
+            {
+                auto& m = modules[i - 1];
+
+                if (modified[i - 1] || countListItems (m.module) != m.numListItems)
+                {
+                    modified[i - 1] = true;
+
+                    if (m.parentIndex != noParent)
+                        modified[m.parentIndex] = true;
+                }
+            }
+
+            std::vector<ref<AST::ModuleBase>> result;
+
+            for (size_t i = 0; i < modules.size(); ++i)
+                if (! modified[i])
+                    result.push_back (modules[i].module);
+
+            return result;
+        }
+
+    private:
+        struct Item
+        {
+            ref<AST::ModuleBase> module;
+            size_t parentIndex, numListItems;
+        };
+
+        static constexpr size_t noParent = ~static_cast<size_t> (0);
+        std::vector<Item> modules;
+
+        void add (AST::ModuleBase& m, size_t parentIndex)
+        {
+            auto index = modules.size();
+            modules.push_back ({ m, parentIndex, countListItems (m) });
+
+            if (auto ns = m.getAsNamespace())
+                for (auto& sub : ns->subModules.iterateAs<AST::ModuleBase>())
+                    add (sub, index);
+        }
+
+        static size_t countListItems (AST::ModuleBase& m)
+        {
+            size_t total = 0;
+
+            for (auto& p : m.getPropertyList())
+                if (auto list = p->getAsListProperty())
+                    total += list->size();
+
+            return total;
+        }
+    };
+
+    ResolvedModuleList resolvedModules;
+
 
 private:
     mutable ptr<AST::ProcessorBase> mainProcessor;
@@ -94,8 +94,10 @@ struct Strings
                        mainFunctionName              { stringPool.get ("main") },
                        userInitFunctionName          { stringPool.get ("init") },
                        resetFunctionName             { stringPool.get ("reset") },
+                       idleFunctionName              { stringPool.get ("isIdle") },
                        systemInitFunctionName        { stringPool.get ("_initialise") },
                        systemAdvanceFunctionName     { stringPool.get ("_advance") },
+                       systemAdvanceToFunctionName   { stringPool.get ("_advanceTo") },
                        rootNamespaceName             { stringPool.get ("_root") },
                        initFnProcessorIDParamName    { stringPool.get ("processorID") },
                        initFnSessionIDParamName      { stringPool.get ("sessionID") },
@@ -129,5 +131,7 @@ struct Strings
                        frames                        { stringPool.get ("frames") },
                        _frames                       { stringPool.get ("_frames") },
                        _activeRamps                  { stringPool.get ("_activeRamps") },
-                       _updateRamps                  { stringPool.get ("_updateRamps") };
+                       _updateRamps                  { stringPool.get ("_updateRamps") },
+                       profileNodeStartedFunctionName  { stringPool.get ("_profileNodeStarted") },
+                       profileNodeFinishedFunctionName { stringPool.get ("_profileNodeFinished") };
 };
@@ -681,7 +681,7 @@ private:
         auto& info = getInfo (f);
 
         info.calledFromEvent = info.calledFromEvent || callerInfo.calledFromEvent  || f.isEventHandler;
-        info.calledFromRun   = info.calledFromRun   || callerInfo.calledFromRun    || f.isMainFunction();
+        info.calledFromRun   = info.calledFromRun   || callerInfo.calledFromRun    || f.isMainFunction() || f.isIdleFunction();
         info.calledFromInit  = info.calledFromInit  || callerInfo.calledFromInit   || f.isUserInitFunction();
 
         CallStack newStack { previous, nullptr, f };
@@ -45,6 +45,9 @@ struct Visitor
 
     void visitProperty (Property& p)    { p.visitObjects (*this); }
 
+    /// Makes this visitor treat an object as already visited, so it won't go into it
+    void skipObject (Object& o)         { o.checkAndUpdateVisitorStatus (visitorDepth, visitorNumber); }
+
     //==============================================================================
     #define CMAJ_DEFINE_CLASS_VISIT_METHOD(Class) \
         virtual void visit (Class& o) \
@@ -43,10 +43,48 @@ namespace cmaj
         resetMainProcessor();
     }
 
+    /// The standard library is decoded and resolved just once per process into this read-only
+    /// copy, and each new program gets its own clone of it. A clone takes about as long to make
+    /// as decoding the binary data, but it starts out resolved, so the resolution passes have
+    /// less to do in each program. The binary data went through the basic resolution passes
+    /// when it was generated, but that doesn't leave it fully resolved, so they're run again here
+    /// until nothing changes. After that, nothing ever modifies this copy, so it can be shared
+    /// between threads.
+    struct StandardLibraryTemplate
+    {
+        StandardLibraryTemplate()
+        {
+            for (auto& m : transformations::parseBinaryModule (library.allocator, standardLibraryData, sizeof (standardLibraryData), false))
+                library.rootNamespace.subModules.addChildObject (m);
+
+            transformations::mergeDuplicateNamespaces (library.rootNamespace);
+            transformations::runBasicResolutionPasses (library);
+
+            modules = library.rootNamespace.getSubModules();
+            CMAJ_ASSERT (! modules.empty());
+            cloneOrder = transformations::getModuleCloneOrder (modules);
+        }
+
+        static const StandardLibraryTemplate& get()
+        {
+            static const StandardLibraryTemplate instance;
+            return instance;
+        }
+
+        AST::Program library;
+        AST::ObjectRefVector<AST::ModuleBase> modules;
+        transformations::ModuleCloneOrder cloneOrder;
+    };
+
     void AST::Program::addStandardLibraryCode()
     {
-        for (auto& m : transformations::parseBinaryModule (allocator, standardLibraryData, sizeof (standardLibraryData), false))
+        auto& standardLibrary = StandardLibraryTemplate::get();
+
+        for (auto& m : transformations::cloneModules (allocator, standardLibrary.modules, std::addressof (standardLibrary.cloneOrder)))
+        {
             rootNamespace.subModules.addChildObject (m);
+            resolvedModules.add (m);
+        }
 
         transformations::mergeDuplicateNamespaces (rootNamespace);
     }
@@ -1112,6 +1112,11 @@ struct EndpointInfo
         out << "using " << getTypeName (alias, false) << " = " << getTypeName (targetType, false) << ";" << newLine;
     }
 
+    bool addGlobalConstantData (const AST::VariableDeclaration&, const AST::TypeBase&, const AST::ConstantValueBase&)
+    {
+        return false;
+    }
+
     void addGlobalVariable (const AST::VariableDeclaration&, const AST::TypeBase& type,
                             std::string_view name, ValueReader constantValue)
     {
@@ -1245,7 +1250,7 @@ struct EndpointInfo
 
     struct LoopStatus {};
 
-    LoopStatus beginLoop()
+    LoopStatus beginLoop (bool)
     {
         functionOut << "for (;;)" << newLine
                     << "{" << newLine;
@@ -1565,6 +1570,14 @@ struct EndpointInfo
         if (intrinsic == AST::Intrinsic::Type::exp && ! argValues.front().paramType.isPrimitiveFloat())
             return {};
 
+        if (intrinsic == AST::Intrinsic::Type::complexFFT || intrinsic == AST::Intrinsic::Type::complexIFFT)
+            if (! isArrayOfComplexScalars (argValues.front().paramType))
+                return {};
+
+        if (intrinsic == AST::Intrinsic::Type::matrixVectorMultiply || intrinsic == AST::Intrinsic::Type::matrixVectorMultiplyAdd)
+            if (! isMatrixArgumentList (argValues))
+                return {};
+
         bool isVectorOp = ! argValues.empty() && argValues.front().paramType.isVector();
 
         if (isVectorOp
@@ -1578,7 +1591,7 @@ struct EndpointInfo
              && intrinsic != AST::Intrinsic::Type::atanh  && intrinsic != AST::Intrinsic::Type::asin
              && intrinsic != AST::Intrinsic::Type::acos   && intrinsic != AST::Intrinsic::Type::atan
              && intrinsic != AST::Intrinsic::Type::atan2  && intrinsic != AST::Intrinsic::Type::pow
-             && intrinsic != AST::Intrinsic::Type::exp)
+             && intrinsic != AST::Intrinsic::Type::exp    && intrinsic != AST::Intrinsic::Type::sigmoid)
             return {};
 
         return createCall ((isVectorOp ? "intrinsics::VectorOps::"
@@ -1586,6 +1599,39 @@ struct EndpointInfo
                             + std::string (AST::Intrinsic::getIntrinsicName (intrinsic)), argValues);
     }
 
+    /// By the time the code is generated, complex values have been turned into structs
+    /// with a real and imaginary member, which is what the helper FFT functions expect
+    static bool isArrayOfComplexScalars (const AST::TypeBase& type)
+    {
+        auto& arrayType = type.skipConstAndRefModifiers();
+
+        if (arrayType.isFixedSizeArray())
+            if (auto elementType = arrayType.getArrayOrVectorElementType())
+                if (elementType->isStruct())
+                    if (auto memberType = elementType->getAggregateElementType (0))
+                        return memberType->isPrimitiveFloat();
+
+        return false;
+    }
+
+    /// The helper matrix functions need a matrix whose rows are fixed-size arrays or vectors,
+    /// and fixed-size arrays or vectors for all the other arguments
+    template <typename ArgValueList>
+    static bool isMatrixArgumentList (const ArgValueList& argValues)
+    {
+        auto isFixedSizeArrayOrVector = [] (const AST::TypeBase& type)
+        {
+            return type.isFixedSizeArray() || type.isVector();
+        };
+
+        for (auto& arg : argValues)
+            if (! isFixedSizeArrayOrVector (arg.paramType.skipConstAndRefModifiers()))
+                return false;
+
+        auto rowType = argValues.front().paramType.skipConstAndRefModifiers().getArrayOrVectorElementType();
+        return rowType != nullptr && isFixedSizeArrayOrVector (*rowType);
+    }
+
     template <typename ArgValueList>
     ValueReader createFunctionCall (const AST::Function&, std::string_view functionName, const ArgValueList& argValues)
     {
@@ -1940,6 +1986,26 @@ struct Slice
     static std::string_view getIntrinsicFunctions()
     {
         return R"CPPGEN(
+template <typename FloatType, SizeType fftSize>
+struct FFTTwiddleTable
+{
+    FFTTwiddleTable()
+    {
+        for (SizeType i = 0; i < numEntries; ++i)
+        {
+            auto angle = -2.0 * 3.141592653589793238 * static_cast<double> (i) / static_cast<double> (fftSize);
+            real[i] = static_cast<FloatType> (std::cos (angle));
+            imag[i] = static_cast<FloatType> (std::sin (angle));
+        }
+    }
+
+    static constexpr SizeType numEntries = fftSize < 4 ? 1 : (fftSize / 4) * 3;
+    FloatType real[numEntries], imag[numEntries];
+};
+
+template <typename FloatType, SizeType fftSize>
+static inline const FFTTwiddleTable<FloatType, fftSize> fftTwiddles;
+
 struct intrinsics
 {
     template <typename T> static T modulo (T a, T b)
@@ -1978,6 +2044,7 @@ struct intrinsics
     template <typename T> static T sinh          (T a)              { return std::sinh (a); }
     template <typename T> static T cosh          (T a)              { return std::cosh (a); }
     template <typename T> static T tanh          (T a)              { return std::tanh (a); }
+    template <typename T> static T sigmoid       (T a)              { return static_cast<T> (1) / (static_cast<T> (1) + std::exp (-a)); }
     template <typename T> static T asinh         (T a)              { return std::asinh (a); }
     template <typename T> static T acosh         (T a)              { return std::acosh (a); }
     template <typename T> static T atanh         (T a)              { return std::atanh (a); }
@@ -1996,6 +2063,120 @@ struct intrinsics
     static int32_t rightShiftUnsigned (int32_t a, int32_t b)        { return static_cast<int32_t> (static_cast<uint32_t> (a) >> b); }
     static int64_t rightShiftUnsigned (int64_t a, int64_t b)        { return static_cast<int64_t> (static_cast<uint64_t> (a) >> b); }
 
+    template <typename ComplexArray> static void complexFFT  (ComplexArray& data)   { performFFT<false> (data); }
+    template <typename ComplexArray> static void complexIFFT (ComplexArray& data)   { performFFT<true>  (data); }
+
+    template <typename Matrix, typename Input, typename Output>
+    static void matrixVectorMultiply (const Matrix& matrix, const Input& input, Output& output)
+    {
+        for (SizeType row = 0; row < Output::size(); ++row)
+            output.elements[row] = dotProduct (matrix.elements[row], input);
+    }
+
+    template <typename Matrix, typename Input, typename Bias, typename Output>
+    static void matrixVectorMultiplyAdd (const Matrix& matrix, const Input& input, const Bias& bias, Output& output)
+    {
+        for (SizeType row = 0; row < Output::size(); ++row)
+            output.elements[row] = bias.elements[row] + dotProduct (matrix.elements[row], input);
+    }
+
+    // Splits the sum across several accumulators so that the compiler can vectorise it
+    template <typename Row, typename Input>
+    static auto dotProduct (const Row& row, const Input& input)
+    {
+        constexpr SizeType numLanes = 8, size = Input::size(), numWholeColumns = size - size % numLanes;
+        using ElementType = decltype (row.elements[0] * input.elements[0]);
+        ElementType lanes[numLanes] = {}, total = {};
+
+        for (SizeType column = 0; column < numWholeColumns; column += numLanes)
+            for (SizeType lane = 0; lane < numLanes; ++lane)
+                lanes[lane] += row.elements[column + lane] * input.elements[column + lane];
+
+        for (SizeType column = numWholeColumns; column < size; ++column)
+            total += row.elements[column] * input.elements[column];
+
+        for (auto lane : lanes)
+            total += lane;
+
+        return total;
+    }
+
+    // An iterative radix-4 FFT, with a radix-2 first pass for sizes which are odd powers of 2
+    template <bool inverse, typename ComplexArray>
+    static void performFFT (ComplexArray& data)
+    {
+        using FloatType = decltype (data.elements[0].real);
+        constexpr SizeType size = ComplexArray::size();
+        constexpr FloatType sign = inverse ? -1 : 1;
+        auto& twiddles = fftTwiddles<FloatType, size>;
+        auto x = data.elements;
+
+        if constexpr (size > 1)
+        {
+            for (SizeType i = 1, j = 0; i < size; ++i)
+            {
+                auto bit = size >> 1;
+
+                for (; (j & bit) != 0; bit >>= 1)
+                    j ^= bit;
+
+                j ^= bit;
+
+                if (i < j)
+                    std::swap (x[i], x[j]);
+            }
+
+            SizeType length = 1;
+
+            if constexpr ((size & 0x55555555) == 0)
+            {
+                for (SizeType i = 0; i < size; i += 2)
+                {
+                    auto r0 = x[i].real, i0 = x[i].imag, r1 = x[i + 1].real, i1 = x[i + 1].imag;
+                    x[i].real = r0 + r1;      x[i].imag = i0 + i1;
+                    x[i + 1].real = r0 - r1;  x[i + 1].imag = i0 - i1;
+                }
+
+                length = 2;
+            }
+
+            for (length *= 4; length <= size; length *= 4)
+            {
+                auto quarter = length / 4, stride = size / length;
+
+                for (SizeType start = 0; start < size; start += length)
+                {
+                    auto a = x + start, b = a + quarter, c = b + quarter, d = c + quarter;
+
+                    for (SizeType k = 0; k < quarter; ++k)
+                    {
+                        auto w1 = k * stride, w2 = w1 * 2, w3 = w1 * 3;
+                        auto t1r = c[k].real * twiddles.real[w1] - c[k].imag * sign * twiddles.imag[w1],  t1i = c[k].real * sign * twiddles.imag[w1] + c[k].imag * twiddles.real[w1];
+                        auto t2r = b[k].real * twiddles.real[w2] - b[k].imag * sign * twiddles.imag[w2],  t2i = b[k].real * sign * twiddles.imag[w2] + b[k].imag * twiddles.real[w2];
+                        auto t3r = d[k].real * twiddles.real[w3] - d[k].imag * sign * twiddles.imag[w3],  t3i = d[k].real * sign * twiddles.imag[w3] + d[k].imag * twiddles.real[w3];
+
+                        auto sum02r = a[k].real + t2r,  sum02i = a[k].imag + t2i,  diff02r = a[k].real - t2r,  diff02i = a[k].imag - t2i;
+                        auto sum13r = t1r + t3r,        sum13i = t1i + t3i,        diff13r = t1r - t3r,        diff13i = t1i - t3i;
+
+                        a[k].real = sum02r + sum13r;          a[k].imag = sum02i + sum13i;
+                        b[k].real = diff02r + sign * diff13i; b[k].imag = diff02i - sign * diff13r;
+                        c[k].real = sum02r - sum13r;          c[k].imag = sum02i - sum13i;
+                        d[k].real = diff02r - sign * diff13i; d[k].imag = diff02i + sign * diff13r;
+                    }
+                }
+            }
+
+            if constexpr (inverse)
+            {
+                for (SizeType i = 0; i < size; ++i)
+                {
+                    x[i].real *= static_cast<FloatType> (1) / size;
+                    x[i].imag *= static_cast<FloatType> (1) / size;
+                }
+            }
+        }
+    }
+
     struct VectorOps
     {
         template <typename Vec> static Vec abs     (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::abs (x); }); }
@@ -2010,6 +2191,7 @@ struct intrinsics
         template <typename Vec> static Vec sinh    (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::sinh (x); }); }
         template <typename Vec> static Vec cosh    (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::cosh (x); }); }
         template <typename Vec> static Vec tanh    (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::tanh (x); }); }
+        template <typename Vec> static Vec sigmoid (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::sigmoid (x); }); }
         template <typename Vec> static Vec asinh   (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::asinh (x); }); }
         template <typename Vec> static Vec acosh   (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::acosh (x); }); }
         template <typename Vec> static Vec atanh   (Vec a)            { return a.performUnaryOp ([] (auto x) { return intrinsics::atanh (x); }); }
@@ -153,6 +153,8 @@ struct CPlusPlusEngine
     static constexpr bool usesDynamicRateAndSessionID = true;
     static constexpr bool allowTopLevelSlices = false;
     static constexpr bool supportsExternalFunctions = false;
+    static constexpr bool supportsNodeProfiling = false;
+    static constexpr bool canReferenceExternalData = false;
     static bool engineSupportsIntrinsic (AST::Intrinsic::Type) { return true; }
 
     //==============================================================================
@@ -270,6 +272,11 @@ extern "C" CMAJ_DLL_EXPORT cmaj::EngineInterface* createEngine()
         e.setBuildSettings (code->buildSettings);
         return choc::com::create<Proxy> (code, e.engine).getWithIncrementedRefCount();
     }
+
+    PerformerPoolInterface* createPerformerPool (std::shared_ptr<LinkedCode> code, uint32_t numInstances)
+    {
+        return createPoolOfSeparatePerformers (*this, std::move (code), numInstances);
+    }
 };
 
 //==============================================================================
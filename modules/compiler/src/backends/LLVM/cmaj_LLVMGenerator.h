@@ -19,8 +19,13 @@
 #include <iostream>
 
 #include "choc/memory/choc_Endianness.h"
+#include "choc/memory/choc_xxHash.h"
 #include "../../codegen/cmaj_CodeGenHelpers.h"
 #include "../../validation/cmaj_ValidationUtilities.h"
+#include "../cmaj_NodeProfiler.h"
+#include "../cmaj_NativeFFT.h"
+#include "../cmaj_NativeMatrix.h"
+#include "../cmaj_ConstantDataSegment.h"
 
 namespace cmaj::llvm
 {
@@ -62,19 +67,25 @@ struct LLVMCodeGenerator
 
     void addNativeOverriddenFunctions (AST::ExternalFunctionManager& externalFunctionManager)
     {
-        // example of how to use this. Remove the commented-out stuff when there's something real in here..
+        // The node profiling hooks are only present if the graph was flattened with profiling enabled
+        ref<const AST::TypeBase> hookParamTypes[] = { ref<const AST::TypeBase> (allocator.int32Type) };
 
-        (void) externalFunctionManager;
-        // if (auto f = program.rootNamespace.findQualifiedFunction (std::string_view ("std::intrinsics::wrap"),
-        //                                                           allocator.int32Type, allocator.int32Type))
-        //     externalFunctionManager.addFunctionWithImplementation (*f,
-        //         (void*) +[] (int32_t value, int32_t size)
-        //         {
-        //             if (size == 0) return 0; auto n = value % size; if (n < 0) return n + size; return n;
-        //         });
+        if (auto f = program.rootNamespace.findFunction (allocator.strings.profileNodeStartedFunctionName, hookParamTypes))
+            externalFunctionManager.addFunctionWithImplementation (*f, (void*) NodeProfiler::nodeStarted);
+
+        if (auto f = program.rootNamespace.findFunction (allocator.strings.profileNodeFinishedFunctionName, hookParamTypes))
+            externalFunctionManager.addFunctionWithImplementation (*f, (void*) NodeProfiler::nodeFinished);
     }
 
     bool generate()
+    {
+        emitModule();
+        optimiseModule();
+        return true;
+    }
+
+    /// Emits the un-optimised IR for the program into the target module
+    void emitModule()
     {
         CodeGenerator<LLVMCodeGenerator> codeGen (*this, program.getMainProcessor());
         codeGenerator = codeGen;
@@ -95,10 +106,24 @@ struct LLVMCodeGenerator
        #endif
 
         dumpDebugPrintout ("Pre optimisation", false);
+        codeGenerator = nullptr;
+    }
+
+    void optimiseModule()
+    {
         applyOptimisationPasses();
         dumpDebugPrintout ("Post optimisation");
-        codeGenerator = nullptr;
-        return true;
+    }
+
+    /// Returns a hash of the module's current IR and string dictionary. When taken before
+    /// optimisation, this identifies the lowered program independently of the source code
+    /// that produced it, so edits which don't affect the generated code will give the same hash.
+    uint64_t getModuleContentHash()
+    {
+        auto bitcode = getBitcode();
+        choc::hash::xxHash64 hash;
+        hash.addInput (bitcode.data(), bitcode.size());
+        return hash.getHash();
     }
 
     bool generateFromBitcode (choc::span<char> bitcode)
@@ -139,6 +164,12 @@ struct LLVMCodeGenerator
     }
 
     void saveBitcodeToCache (CacheDatabaseInterface& cache, const char* key)
+    {
+        auto bitcode = getBitcode();
+        cache.store (key, bitcode.data(), bitcode.size());
+    }
+
+    ::llvm::SmallVector<char, 64> getBitcode()
     {
         ::llvm::SmallVector<char, 64> bitcode;
 
@@ -153,7 +184,7 @@ struct LLVMCodeGenerator
             ::llvm::WriteBitcodeToFile (*targetModule, s);
         }
 
-        cache.store (key, bitcode.data(), bitcode.size());
+        return bitcode;
     }
 
     void dumpDebugPrintout (const char* description, bool includeAssembly = true)
@@ -186,6 +217,7 @@ struct LLVMCodeGenerator
     static std::string getInitFunctionName()              { return "initialise"; }
     static std::string getAdvanceOneFrameFunctionName()   { return "advanceOneFrame"; }
     static std::string getAdvanceBlockFunctionName()      { return "advanceBlock"; }
+    static std::string getAdvanceToFrameFunctionName()    { return "advanceToFrame"; }
 
     // parameter variables bigger than this will be passed as a byval pointer to
     // avoid llvm choking on store operations for large arrays
@@ -229,8 +261,9 @@ struct LLVMCodeGenerator
     std::unordered_map<std::string, void*> externalFunctionPointers;
     std::unordered_map<const AST::VariableDeclaration*, ::llvm::GlobalVariable*> globalVariables;
     DuckTypedStructMappings<::llvm::StructType*, false> structTypes;
-    std::vector<std::vector<uint8_t>> gloalVariableSpace;
+    const ConstantDataSegment* constantDataSegment = nullptr;
     size_t sliceConstantIndex = 0;
+    std::unordered_map<uint32_t, ::llvm::GlobalVariable*> fftTwiddleTables;
     const bool webAssemblyMode = false;
 
     struct TypeNameList : public AST::UniqueNameList<AST::Object, TypeNameList>
@@ -736,6 +769,40 @@ struct LLVMCodeGenerator
     void addStruct (const AST::StructType&) {}
     void addAlias (const AST::Alias&, const AST::TypeBase&) {}
 
+    /// When the generated code will be run by a JIT which links to the segment's symbols,
+    /// this lets its large constants be referenced rather than emitted into the module.
+    void useConstantDataSegment (const ConstantDataSegment& segment)
+    {
+        constantDataSegment = std::addressof (segment);
+    }
+
+    const ConstantDataSegment::Block* findConstantDataBlock (const AST::ConstantValueBase& value) const
+    {
+        return constantDataSegment != nullptr ? constantDataSegment->findBlock (value) : nullptr;
+    }
+
+    ::llvm::GlobalVariable* getExternalConstantGlobal (const std::string& name, ::llvm::Type* type)
+    {
+        if (auto existing = targetModule->getNamedGlobal (name))
+            return existing;
+
+        auto global = new ::llvm::GlobalVariable (*targetModule, type, true, ::llvm::GlobalValue::ExternalLinkage, nullptr, name);
+        global->setAlignment (::llvm::Align (ConstantDataSegment::alignmentBytes));
+        return global;
+    }
+
+    bool addGlobalConstantData (const AST::VariableDeclaration& v, const AST::TypeBase& type,
+                                const AST::ConstantValueBase& value)
+    {
+        if (auto block = findConstantDataBlock (value))
+        {
+            globalVariables[std::addressof (v)] = getExternalConstantGlobal (block->symbolName, getLLVMType (type));
+            return true;
+        }
+
+        return false;
+    }
+
     void addGlobalVariable (const AST::VariableDeclaration& v, const AST::TypeBase& type,
                             std::string_view name, ValueReader initialValue)
     {
@@ -771,6 +838,7 @@ struct LLVMCodeGenerator
             if (f.isSystemInitFunction())       return getInitFunctionName();
             if (f.isMainFunction())             return getAdvanceOneFrameFunctionName();
             if (f.isSystemAdvanceFunction())    return getAdvanceBlockFunctionName();
+            if (f.isSystemAdvanceToFunction())  return getAdvanceToFrameFunctionName();
             if (f.isEventHandler)               return codeGenerator->getFunctionName (f);
 
             return std::string (f.getName());
@@ -1020,13 +1088,15 @@ struct LLVMCodeGenerator
     struct LoopStatus
     {
         Block startBlock = nullptr;
+        bool hasIndependentIterations = false;
     };
 
-    LoopStatus beginLoop()
+    LoopStatus beginLoop (bool hasIndependentIterations)
     {
         getBlockBuilder();
         LoopStatus l;
         l.startBlock = createBlock();
+        l.hasIndependentIterations = hasIndependentIterations;
         terminateWithBranch (l.startBlock, l.startBlock);
         return l;
     }
@@ -1034,7 +1104,26 @@ struct LLVMCodeGenerator
     void endLoop (LoopStatus& l)
     {
         if (currentBlock != nullptr)
+        {
+            auto lastBlock = currentBlock;
             terminateWithBranch (l.startBlock, nullptr);
+
+            if (l.hasIndependentIterations)
+                lastBlock->getTerminator()->setMetadata (::llvm::LLVMContext::MD_loop, createVectoriseLoopMetadata());
+        }
+    }
+
+    /// Asks the loop vectoriser to run a loop lane-wise even where its cost model wouldn't
+    /// normally bother. It still has to prove that this is safe, so it only adds a hint.
+    ::llvm::MDNode* createVectoriseLoopMetadata()
+    {
+        auto enable = ::llvm::MDNode::get (*context, { ::llvm::MDString::get (*context, "llvm.loop.vectorize.enable"),
+                                                       ::llvm::ConstantAsMetadata::get (::llvm::ConstantInt::getTrue (*context)) });
+
+        auto placeholder = ::llvm::MDNode::getTemporary (*context, {});
+        auto loopID = ::llvm::MDNode::getDistinct (*context, { placeholder.get(), enable });
+        loopID->replaceOperandWith (0, loopID);
+        return loopID;
     }
 
     bool addBreakFromCurrentLoop()  { return false; }
@@ -1221,6 +1310,15 @@ struct LLVMCodeGenerator
     ValueReader createConstantAggregate (const AST::ConstantAggregate& agg)
     {
         auto& type = agg.getType().skipConstAndRefModifiers();
+
+        if (agg.refersToExternalData())
+            return createExternalSlice (program.externalVariableManager.getExternalDataSymbolName (agg.getExternalData()),
+                                        type, static_cast<uint64_t> (agg.getNumElements()));
+
+        if (type.isSlice())
+            if (auto block = findConstantDataBlock (agg))
+                return createExternalSlice (block->symbolName, type, static_cast<uint64_t> (agg.getNumElements()));
+
         bool isVector = type.isVectorType();
         auto numElements = agg.getNumElements();
 
@@ -1309,6 +1407,20 @@ struct LLVMCodeGenerator
         return {};
     }
 
+    /// Creates a slice of data which lives outside the module (i.e. mapped sample data or a
+    /// large constant), declared as an external global which the JIT resolves to its address
+    ValueReader createExternalSlice (const std::string& name, const AST::TypeBase& type, uint64_t numElements)
+    {
+        auto elementType = getLLVMType (*type.getArrayOrVectorElementType());
+        auto sourceData = getExternalConstantGlobal (name, ::llvm::ArrayType::get (elementType, numElements));
+
+        ::llvm::SmallVector<::llvm::Constant*, 2> fatPointerMembers;
+        fatPointerMembers.push_back (::llvm::ConstantExpr::getPointerCast (sourceData, elementType->getPointerTo()));
+        fatPointerMembers.push_back (::llvm::ConstantInt::getSigned (getInt32Type(), static_cast<int64_t> (numElements)));
+
+        return makeReader (::llvm::ConstantStruct::get (checked_cast<::llvm::StructType> (getLLVMType (type)), fatPointerMembers), type);
+    }
+
     ValueReader createNullConstant (const AST::TypeBase& type)
     {
         return makeReader (createNullConstant (getLLVMType (type)), type);
@@ -1579,9 +1691,197 @@ struct LLVMCodeGenerator
         return {};
     }
 
+    template <typename FloatType>
+    ::llvm::Constant* createFFTTwiddleData (uint32_t fftSize)
+    {
+        std::vector<FloatType> values;
+        auto numEntries = NativeFFT::getTwiddleTableSize (fftSize);
+        values.reserve (numEntries * 2);
+
+        for (uint32_t i = 0; i < numEntries; ++i)
+        {
+            auto w = NativeFFT::getTwiddleFactor (i, fftSize);
+            values.push_back (static_cast<FloatType> (w.real()));
+            values.push_back (static_cast<FloatType> (w.imag()));
+        }
+
+        return ::llvm::ConstantDataArray::get (*context, values);
+    }
+
+    ::llvm::Constant* getFFTTwiddleTable (uint32_t fftSize, ::llvm::Type* floatType)
+    {
+        bool is64Bit = floatType->isDoubleTy();
+        auto& table = fftTwiddleTables[fftSize * 2 + (is64Bit ? 1 : 0)];
+
+        if (table == nullptr)
+        {
+            auto data = is64Bit ? createFFTTwiddleData<double> (fftSize)
+                                : createFFTTwiddleData<float> (fftSize);
+
+            table = new ::llvm::GlobalVariable (*targetModule, data->getType(), true,
+                                                ::llvm::GlobalValue::PrivateLinkage, data,
+                                                "_fft_twiddles_" + std::to_string (fftSize) + (is64Bit ? "_64" : "_32"));
+        }
+
+        return ::llvm::ConstantExpr::getPointerCast (table, floatType->getPointerTo());
+    }
+
+    /// Calls the native FFT for an array of complex values, which by this point will have
+    /// been converted to an array of structs holding a pair of floats
+    template <typename FunctionCallArg>
+    ValueReader createIntrinsic_FFT (const FunctionCallArg& arg, bool inverse, const AST::TypeBase& returnType)
+    {
+        if (webAssemblyMode || ! arg.valueReference)
+            return {};
+
+        auto arrayType = ::llvm::dyn_cast<::llvm::ArrayType> (getLLVMType (arg.paramType.skipConstAndRefModifiers()));
+
+        if (arrayType == nullptr)
+            return {};
+
+        auto complexType = ::llvm::dyn_cast<::llvm::StructType> (arrayType->getElementType());
+
+        if (complexType == nullptr || complexType->getNumElements() != 2
+             || complexType->getElementType (0) != complexType->getElementType (1))
+            return {};
+
+        auto floatType = complexType->getElementType (0);
+
+        if (! (floatType->isFloatTy() || floatType->isDoubleTy()))
+            return {};
+
+        auto fftSize = static_cast<uint32_t> (arrayType->getNumElements());
+        auto floatPointerType = floatType->getPointerTo();
+
+        auto fn = createFunction (NativeFFT::getFunctionName (floatType->isDoubleTy(), inverse),
+                                  ::llvm::Type::getVoidTy (*context),
+                                  { floatPointerType, getInt32Type(), floatPointerType });
+
+        auto& b = getBlockBuilder();
+        auto data = b.CreateBitCast (getPointer (arg.valueReference), floatPointerType);
+
+        return makeReader (b.CreateCall (fn, { data, b.getInt32 (fftSize), getFFTTwiddleTable (fftSize, floatType) }),
+                           returnType);
+    }
+
+    static bool isArrayOrVectorOf (::llvm::Type* type, ::llvm::Type* elementType, uint64_t numElements)
+    {
+        if (auto arrayType = ::llvm::dyn_cast<::llvm::ArrayType> (type))
+            return arrayType->getElementType() == elementType && arrayType->getNumElements() == numElements;
+
+        if (auto vectorType = ::llvm::dyn_cast<::llvm::FixedVectorType> (type))
+            return vectorType->getElementType() == elementType && vectorType->getNumElements() == numElements;
+
+        return false;
+    }
+
+    /// Returns a pointer to the first float in an argument which is an array or vector of the
+    /// given size, or nullptr if it's not something that the native functions can work on
+    template <typename FunctionCallArg>
+    ::llvm::Value* getFloatArrayPointer (const FunctionCallArg& arg, ::llvm::Type* floatType, uint64_t numElements)
+    {
+        if (! arg.valueReference || arg.valueReference.isVectorElement()
+             || ! isArrayOrVectorOf (getLLVMType (arg.paramType.skipConstAndRefModifiers()), floatType, numElements))
+            return nullptr;
+
+        return getBlockBuilder().CreateBitCast (getPointer (arg.valueReference), floatType->getPointerTo());
+    }
+
+    /// Calls the native matrix-vector multiply, for a matrix which is an array of rows, where
+    /// each row is an array or vector of floats
+    template <typename FunctionCallArgList>
+    ValueReader createIntrinsic_MatrixVectorMultiply (const FunctionCallArgList& argValues, bool addBias, const AST::TypeBase& returnType)
+    {
+        if (webAssemblyMode)
+            return {};
+
+        auto matrixType = ::llvm::dyn_cast<::llvm::ArrayType> (getLLVMType (argValues[0].paramType.skipConstAndRefModifiers()));
+
+        if (matrixType == nullptr)
+            return {};
+
+        auto rowType = matrixType->getElementType();
+        ::llvm::Type* floatType = nullptr;
+        uint64_t numColumns = 0;
+
+        if (auto arrayType = ::llvm::dyn_cast<::llvm::ArrayType> (rowType))
+        {
+            floatType = arrayType->getElementType();
+            numColumns = arrayType->getNumElements();
+        }
+        else if (auto vectorType = ::llvm::dyn_cast<::llvm::FixedVectorType> (rowType))
+        {
+            floatType = vectorType->getElementType();
+            numColumns = vectorType->getNumElements();
+        }
+
+        if (floatType == nullptr || ! (floatType->isFloatTy() || floatType->isDoubleTy()))
+            return {};
+
+        auto numRows = matrixType->getNumElements();
+        auto rowStride = static_cast<uint64_t> (dataLayout.getTypeAllocSize (rowType)) / static_cast<uint64_t> (dataLayout.getTypeAllocSize (floatType));
+
+        auto matrix = getFloatArrayPointer (argValues[0], rowType, numRows);
+        auto input  = getFloatArrayPointer (argValues[1], floatType, numColumns);
+        auto output = getFloatArrayPointer (argValues[addBias ? 3 : 2], floatType, numRows);
+        auto floatPointerType = floatType->getPointerTo();
+        ::llvm::Value* bias = ::llvm::ConstantPointerNull::get (floatPointerType);
+
+        if (addBias)
+            bias = getFloatArrayPointer (argValues[2], floatType, numRows);
+
+        if (matrix == nullptr || input == nullptr || bias == nullptr || output == nullptr)
+            return {};
+
+        auto& b = getBlockBuilder();
+        auto int32Type = getInt32Type();
+
+        auto fn = createFunction (NativeMatrix::getMatrixVectorMultiplyFunctionName (floatType->isDoubleTy()),
+                                  ::llvm::Type::getVoidTy (*context),
+                                  { floatPointerType, int32Type, int32Type, int32Type, floatPointerType, floatPointerType, floatPointerType });
+
+        return makeReader (b.CreateCall (fn, { b.CreateBitCast (matrix, floatPointerType),
+                                               b.getInt32 (static_cast<uint32_t> (rowStride)),
+                                               b.getInt32 (static_cast<uint32_t> (numRows)),
+                                               b.getInt32 (static_cast<uint32_t> (numColumns)),
+                                               input, bias, output }),
+                           returnType);
+    }
+
+    /// Applies tanh or sigmoid to a vector of floats by calling the native in-place version.
+    /// Scalars are left to the library functions, which LLVM can inline.
+    ValueReader createIntrinsic_Activation (::llvm::Value* value, bool isSigmoid, const AST::TypeBase& returnType)
+    {
+        auto vectorType = ::llvm::dyn_cast<::llvm::FixedVectorType> (value->getType());
+
+        if (webAssemblyMode || vectorType == nullptr)
+            return {};
+
+        auto floatType = vectorType->getElementType();
+
+        if (! (floatType->isFloatTy() || floatType->isDoubleTy()))
+            return {};
+
+        auto fn = createFunction (NativeMatrix::getActivationFunctionName (floatType->isDoubleTy(), isSigmoid),
+                                  ::llvm::Type::getVoidTy (*context),
+                                  { floatType->getPointerTo(), getInt32Type() });
+
+        auto& b = getBlockBuilder();
+        auto data = functionEntryBlockBuilder->CreateAlloca (vectorType);
+        b.CreateStore (value, data);
+        b.CreateCall (fn, { b.CreateBitCast (data, floatType->getPointerTo()), b.getInt32 (vectorType->getNumElements()) });
+        return makeReader (b.CreateLoad (vectorType, data), returnType);
+    }
+
     template <typename FunctionCallArgList>
     ValueReader createIntrinsicCall (AST::Intrinsic::Type intrinsic, FunctionCallArgList argValues, const AST::TypeBase& returnType)
     {
+        if (intrinsic == AST::Intrinsic::Type::complexFFT || intrinsic == AST::Intrinsic::Type::complexIFFT)
+            return createIntrinsic_FFT (argValues.front(), intrinsic == AST::Intrinsic::Type::complexIFFT, returnType);
+
+        if (intrinsic == AST::Intrinsic::Type::matrixVectorMultiply || intrinsic == AST::Intrinsic::Type::matrixVectorMultiplyAdd)
+            return createIntrinsic_MatrixVectorMultiply (argValues, intrinsic == AST::Intrinsic::Type::matrixVectorMultiplyAdd, returnType);
+
         ::llvm::SmallVector<::llvm::Value*, 32> args;
 
         for (auto& arg : argValues)
@@ -1613,6 +1913,8 @@ struct LLVMCodeGenerator
             case AST::Intrinsic::Type::reinterpretIntToFloat:  return createIntrinsic_reinterpretIntToFloat (args.front());
 
             case AST::Intrinsic::Type::select:        return createIntrinsic_select (args, returnType);
+            case AST::Intrinsic::Type::tanh:          return createIntrinsic_Activation (args.front(), false, returnType);
+            case AST::Intrinsic::Type::sigmoid:       return createIntrinsic_Activation (args.front(), true, returnType);
 
             case AST::Intrinsic::Type::fmod:
             case AST::Intrinsic::Type::tan:
@@ -1622,7 +1924,6 @@ struct LLVMCodeGenerator
             case AST::Intrinsic::Type::wrap:
             case AST::Intrinsic::Type::sinh:
             case AST::Intrinsic::Type::cosh:
-            case AST::Intrinsic::Type::tanh:
             case AST::Intrinsic::Type::asinh:
             case AST::Intrinsic::Type::acosh:
             case AST::Intrinsic::Type::atanh:
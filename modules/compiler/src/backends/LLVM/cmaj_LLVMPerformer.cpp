@@ -39,6 +39,8 @@
 #include "llvm/IR/Verifier.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/ExecutionEngine/Orc/CompileUtils.h"
 #include "llvm/ExecutionEngine/Orc/LLJIT.h"
 #include "llvm/ExecutionEngine/Orc/RTDyldObjectLinkingLayer.h"
 #include "llvm/ExecutionEngine/RTDyldMemoryManager.h"
@@ -83,9 +85,27 @@ static void initialiseLLVM()
 
 #if CMAJ_ENABLE_PERFORMER_LLVM
 
+/// Catches the relocatable object that the JIT emits for our module, so that it
+/// can be stored in a cache and re-loaded without running the backend again.
+struct ObjectCodeCapture  : public ::llvm::ObjectCache
+{
+    void notifyObjectCompiled (const ::llvm::Module*, ::llvm::MemoryBufferRef object) override
+    {
+        objectCode.assign (object.getBufferStart(), object.getBufferEnd());
+    }
+
+    std::unique_ptr<::llvm::MemoryBuffer> getObject (const ::llvm::Module*) override
+    {
+        return {};
+    }
+
+    std::vector<char> objectCode;
+};
+
+//==============================================================================
 struct LLJITHolder
 {
-    LLJITHolder (int optimisationLevel)
+    LLJITHolder (int optimisationLevel, ObjectCodeCapture* objectCodeCapture)
     {
         ::llvm::sys::DynamicLibrary::LoadLibraryPermanently (nullptr);
 
@@ -99,9 +119,21 @@ struct LLJITHolder
 
             machineBuilder->setCodeGenOptLevel (getCodeGenOptLevel (optimisationLevel));
 
+            targetCPU = machineBuilder->getCPU();
+            targetFeatures = machineBuilder->getFeatures().getString();
+
             ::llvm::orc::LLJITBuilder builder;
             builder.setJITTargetMachineBuilder (machineBuilder.get());
 
+            if (objectCodeCapture != nullptr)
+            {
+                builder.setCompileFunctionCreator ([objectCodeCapture] (::llvm::orc::JITTargetMachineBuilder jtmb)
+                                                     -> ::llvm::Expected<std::unique_ptr<::llvm::orc::IRCompileLayer::IRCompiler>>
+                                                   {
+                                                       return std::make_unique<::llvm::orc::ConcurrentIRCompiler> (std::move (jtmb), objectCodeCapture);
+                                                   });
+            }
+
             // Avoid the special case ObjectLinkingLayer created by lljit when it's the wrong thing to do
             if (targetTriple.isOSBinFormatMachO())
             {
@@ -123,6 +155,10 @@ struct LLJITHolder
                                     ::GetForCurrentProcess (lljit->getDataLayout().getGlobalPrefix()))
                     lljit->getMainJITDylib().addGenerator (std::move (*gen));
 
+                // These are always defined, so that code which was reloaded from a cache
+                // can link to them without the generator having registered them
+                addExternalFunctionSymbols (NativeFFT::getFunctionSymbols());
+                addExternalFunctionSymbols (NativeMatrix::getFunctionSymbols());
                 return;
             }
         }
@@ -138,6 +174,25 @@ struct LLJITHolder
         CMAJ_ASSERT (! err);
     }
 
+    bool loadObjectCode (choc::span<char> objectCode)
+    {
+        auto buffer = ::llvm::MemoryBuffer::getMemBufferCopy ({ objectCode.begin(), objectCode.size() });
+
+        if (auto err = lljit->addObjectFile (std::move (buffer)))
+        {
+            ::llvm::consumeError (std::move (err));
+            return false;
+        }
+
+        if (auto err = lljit->initialize (lljit->getMainJITDylib()))
+        {
+            ::llvm::consumeError (std::move (err));
+            return false;
+        }
+
+        return true;
+    }
+
     void addExternalFunctionSymbols (const std::unordered_map<std::string, void*>& functionPointers)
     {
         auto& processSymbols = lljit->getMainJITDylib();
@@ -171,11 +226,14 @@ struct LLJITHolder
         return nullptr;
     }
 
-    std::string getTargetTriple() const         { return lljit->getTargetTriple().normalize(); }
-    const ::llvm::DataLayout& getDataLayout()   { return lljit->getDataLayout(); }
+    std::string getTargetTriple() const             { return lljit->getTargetTriple().normalize(); }
+    const std::string& getTargetCPU() const         { return targetCPU; }
+    const std::string& getTargetFeatures() const    { return targetFeatures; }
+    const ::llvm::DataLayout& getDataLayout()       { return lljit->getDataLayout(); }
 
 private:
     std::unique_ptr<::llvm::orc::LLJIT> lljit;
+    std::string targetCPU, targetFeatures;
 
     static ::llvm::CodeGenOpt::Level getCodeGenOptLevel (int level)
     {
@@ -204,12 +262,14 @@ struct LLVMEngine
 
     EngineBase<LLVMEngine>& engine;
 
-    static std::string getEngineVersion()   { return "llvm1"; }
+    static std::string getEngineVersion()   { return "llvm2"; }
 
     static constexpr bool canUseForwardBranches = true;
     static constexpr bool usesDynamicRateAndSessionID = false;
     static constexpr bool allowTopLevelSlices = false;
     static constexpr bool supportsExternalFunctions = true;
+    static constexpr bool supportsNodeProfiling = true;
+    static constexpr bool canReferenceExternalData = true;
     static bool engineSupportsIntrinsic (AST::Intrinsic::Type) { return true; }
 
     using InitialiseFn       = void*(*)(void*, int32_t*, int32_t, double);
@@ -222,7 +282,8 @@ struct LLVMEngine
     {
         LinkedCode (LLVMEngine& llvmEngine, bool isSingleFrameOnly, double latencyToUse,
                     CacheDatabaseInterface* cache, const char* cacheKey)
-           : lljit (llvmEngine.engine.buildSettings.getOptimisationLevel()),
+           : lljit (llvmEngine.engine.buildSettings.getOptimisationLevel(),
+                    shouldCacheObjectCode (llvmEngine, cache) ? std::addressof (objectCodeCapture) : nullptr),
              latency (latencyToUse)
         {
             LLVMCodeGenerator codeGen (*llvmEngine.engine.program,
@@ -235,11 +296,48 @@ struct LLVMEngine
 
             codeGen.addNativeOverriddenFunctions (llvmEngine.engine.program->externalFunctionManager);
 
-            bool loadedFromCache = loadFromCache (codeGen, cache, cacheKey);
+            // Mapped sample data is linked by address rather than copied into the module, so
+            // the symbols must exist before any code (including cached object code) is loaded
+            auto& externalVariables = llvmEngine.engine.program->externalVariableManager;
+            externalData = externalVariables.getReferencedExternalData();
+            lljit.addExternalFunctionSymbols (externalVariables.getExternalDataSymbols());
+
+            // Large constants are kept out of the module in the same way. The segment is built
+            // from the program rather than by the code generator, because code reloaded from
+            // the cache still needs their symbols
+            constantData.addConstants (*llvmEngine.engine.program);
+            lljit.addExternalFunctionSymbols (constantData.getSymbols());
+            codeGen.useConstantDataSegment (constantData);
 
-            if (! (loadedFromCache || codeGen.generate()))
+            std::string objectCacheKey, loweredCodeCacheKey;
+            bool loadedObjectFromCache = false, loadedFromCache = false, reusedOptimisedCode = false;
+
+            if (shouldCacheObjectCode (llvmEngine, cache))
             {
-                CMAJ_ASSERT_FALSE;
+                objectCacheKey = getObjectCodeCacheKey (cacheKey, llvmEngine.engine.buildSettings.getOptimisationLevel());
+                loadedObjectFromCache = loadObjectCodeFromCache (codeGen, *cache, objectCacheKey.c_str());
+            }
+
+            if (! loadedObjectFromCache)
+            {
+                loadedFromCache = loadFromCache (codeGen, cache, cacheKey);
+
+                if (! loadedFromCache)
+                {
+                    codeGen.emitModule();
+
+                    // If the source changed but the lowered IR is identical to something we've
+                    // already optimised (e.g. after an edit to a comment, or to a part of the
+                    // program that isn't used), we can skip the optimisation passes entirely
+                    if (cache != nullptr)
+                    {
+                        loweredCodeCacheKey = getLoweredCodeCacheKey (codeGen, llvmEngine.engine.buildSettings.getOptimisationLevel());
+                        reusedOptimisedCode = loadFromCache (codeGen, cache, loweredCodeCacheKey.c_str());
+                    }
+
+                    if (! reusedOptimisedCode)
+                        codeGen.optimiseModule();
+                }
             }
 
             nativeTypeLayouts.createLayout = [&codeGen] (const AST::TypeBase& t) { return codeGen.createNativeTypeLayout (t); };
@@ -254,24 +352,45 @@ struct LLVMEngine
 
             initialiseEndpointHandlers (codeGen, llvmEngine.engine.endpointHandles);
 
-            if (cache != nullptr && ! loadedFromCache)
-                codeGen.saveBitcodeToCache (*cache, cacheKey);
+            if (! loadedObjectFromCache)
+            {
+                if (cache != nullptr && ! loadedFromCache)
+                {
+                    codeGen.saveBitcodeToCache (*cache, cacheKey);
+
+                    if (! reusedOptimisedCode)
+                        codeGen.saveBitcodeToCache (*cache, loweredCodeCacheKey.c_str());
+                }
 
-            lljit.addExternalFunctionSymbols (codeGen.externalFunctionPointers);
-            lljit.load (codeGen.takeCompiledModule());
+                lljit.addExternalFunctionSymbols (codeGen.externalFunctionPointers);
+                lljit.load (codeGen.takeCompiledModule());
+            }
 
             loadFunction (initialiseFn, LLVMCodeGenerator::getInitFunctionName());
 
             if (isSingleFrameOnly)
+            {
                 loadFunction (advanceOneFrameFn, LLVMCodeGenerator::getAdvanceOneFrameFunctionName());
+            }
             else
+            {
                 loadFunction (advanceBlockFn, LLVMCodeGenerator::getAdvanceBlockFunctionName());
+                loadFunction (advanceToFrameFn, LLVMCodeGenerator::getAdvanceToFrameFunctionName());
+            }
 
             for (auto& e : inputValues)
                 loadFunction (e.setValue, e.setValueFnName);
+
+            // The JIT compiles the module lazily on the first symbol lookup, so the object
+            // code is only available once the functions above have been resolved
+            if (! (objectCacheKey.empty() || loadedObjectFromCache))
+                saveObjectCodeToCache (*cache, objectCacheKey.c_str(), codeGen.externalFunctionPointers.empty());
         }
 
         //==============================================================================
+        ObjectCodeCapture objectCodeCapture;
+        std::vector<std::shared_ptr<const MappedAudioFile>> externalData;
+        ConstantDataSegment constantData;
         LLJITHolder lljit;
         choc::value::SimpleStringDictionary stringDictionary;
         NativeTypeLayoutCache nativeTypeLayouts;
@@ -283,6 +402,7 @@ struct LLVMEngine
         InitialiseFn        initialiseFn = {};
         AdvanceOneFrameFn   advanceOneFrameFn = {};
         AdvanceBlockFn      advanceBlockFn = {};
+        AdvanceBlockFn      advanceToFrameFn = {};
 
         //==============================================================================
         struct InputStreamEndpoint
@@ -353,6 +473,75 @@ struct LLVMEngine
             return false;
         }
 
+        static bool shouldCacheObjectCode (LLVMEngine& llvmEngine, CacheDatabaseInterface* cache)
+        {
+            auto& options = llvmEngine.engine.options;
+
+            return cache != nullptr
+                    && options.isObject()
+                    && options.hasObjectMember ("cacheObjectCode")
+                    && options["cacheObjectCode"].getWithDefault (false);
+        }
+
+        /// Object code is only valid for the exact machine it was generated for, so the
+        /// key for it needs to include the target and CPU details as well as the program
+        std::string getObjectCodeCacheKey (const char* cacheKey, int optimisationLevel) const
+        {
+            choc::hash::xxHash64 hash;
+            hash.addInput (lljit.getTargetTriple());
+            hash.addInput (lljit.getTargetCPU());
+            hash.addInput (lljit.getTargetFeatures());
+            hash.addInput (std::to_string (LLVMCodeGenerator::getOptimisationLevelWithDefault (optimisationLevel)));
+
+            return std::string (cacheKey) + "_obj_" + choc::text::createHexString (hash.getHash());
+        }
+
+        /// The key for the optimised version of a module, based on its un-optimised IR
+        /// rather than the source code that produced it
+        static std::string getLoweredCodeCacheKey (LLVMCodeGenerator& codeGen, int optimisationLevel)
+        {
+            choc::hash::xxHash64 hash (codeGen.getModuleContentHash());
+            hash.addInput (std::to_string (LLVMCodeGenerator::getOptimisationLevelWithDefault (optimisationLevel)));
+            hash.addInput (std::string (getEngineVersion()));
+
+            return "lowered_" + choc::text::createHexString (hash.getHash());
+        }
+
+        bool loadObjectCodeFromCache (LLVMCodeGenerator& codeGen, CacheDatabaseInterface& cache, const char* key)
+        {
+            if (auto cachedSize = cache.reload (key, nullptr, 0))
+            {
+                std::vector<char> loaded;
+                loaded.resize (static_cast<size_t> (cachedSize));
+
+                if (cache.reload (key, loaded.data(), cachedSize) == cachedSize)
+                {
+                    choc::span<char> objectCode (loaded);
+
+                    if (codeGen.reloadDictionary (objectCode) && ! objectCode.empty())
+                        return lljit.loadObjectCode (objectCode);
+                }
+            }
+
+            return false;
+        }
+
+        void saveObjectCodeToCache (CacheDatabaseInterface& cache, const char* key, bool canUseObjectCode)
+        {
+            // External function pointers are process-specific addresses, so a program which
+            // uses them can't be reloaded from an object file
+            if (! canUseObjectCode || objectCodeCapture.objectCode.empty())
+                return;
+
+            std::vector<char> data;
+            data.resize (sizeof (uint32_t));
+            choc::memory::writeLittleEndian (data.data(), static_cast<uint32_t> (stringDictionary.strings.size()));
+            data.insert (data.end(), stringDictionary.strings.begin(), stringDictionary.strings.end());
+            data.insert (data.end(), objectCodeCapture.objectCode.begin(), objectCodeCapture.objectCode.end());
+
+            cache.store (key, data.data(), data.size());
+        }
+
         //==============================================================================
         void initialiseEndpointHandlers (LLVMCodeGenerator& codeGen, const std::vector<EndpointInfo>& endpointArray)
         {
@@ -452,29 +641,71 @@ struct LLVMEngine
     };
 
 
+    //==============================================================================
+    /// A single block of memory holding the state and io structs for all the
+    /// instances in a performer pool. Each instance's memory starts on a boundary
+    /// of LinkedCode::alignmentBytes, which is a multiple of the cache-line size, so
+    /// neighbouring instances never share a cache line.
+    struct InstanceArena
+    {
+        InstanceArena (const LinkedCode& code, uint32_t numInstances)
+            : stateSize (roundUp (code.stateSize)),
+              instanceStride (stateSize + roundUp (code.ioSize)),
+              memory (std::max (instanceStride * numInstances, LinkedCode::alignmentBytes))
+        {
+            memory.clear();
+        }
+
+        uint8_t* getStateMemory (uint32_t index)    { return static_cast<uint8_t*> (memory.data()) + instanceStride * index; }
+        uint8_t* getIOMemory (uint32_t index)       { return getStateMemory (index) + stateSize; }
+
+        static size_t roundUp (size_t size)         { return (size + LinkedCode::alignmentBytes - 1) & ~(LinkedCode::alignmentBytes - 1); }
+
+        const size_t stateSize, instanceStride;
+        choc::AlignedMemoryBlock<LinkedCode::alignmentBytes> memory;
+    };
+
     //==============================================================================
     struct JITInstance
     {
-        JITInstance (std::shared_ptr<LinkedCode> cc, int32_t s, double f) : code (std::move (cc)), sessionID (s), frequency (f)
+        JITInstance (std::shared_ptr<LinkedCode> cc, int32_t s, double f)
+            : JITInstance (std::move (cc), s, f, {}, 0)
         {
-            stateMemory.resize (code->stateSize);
-            statePointer = static_cast<uint8_t*> (stateMemory.data());
+        }
 
-            ioMemory.resize (code->ioSize);
-            ioPointer = static_cast<uint8_t*> (ioMemory.data());
+        JITInstance (std::shared_ptr<LinkedCode> cc, int32_t s, double f,
+                     std::shared_ptr<InstanceArena> arenaToUse, uint32_t instanceIndex)
+            : code (std::move (cc)), arena (std::move (arenaToUse)), sessionID (s), frequency (f)
+        {
+            if (arena != nullptr)
+            {
+                statePointer = arena->getStateMemory (instanceIndex);
+                ioPointer = arena->getIOMemory (instanceIndex);
+            }
+            else
+            {
+                stateMemory.resize (code->stateSize);
+                statePointer = static_cast<uint8_t*> (stateMemory.data());
+
+                ioMemory.resize (code->ioSize);
+                ioPointer = static_cast<uint8_t*> (ioMemory.data());
+            }
 
             advanceOneFrameFn = code->advanceOneFrameFn;
             advanceBlockFn = code->advanceBlockFn;
+            advanceToFrameFn = code->advanceToFrameFn;
 
             reset();
         }
 
         //==============================================================================
         std::shared_ptr<LinkedCode> code;
+        std::shared_ptr<InstanceArena> arena;
         choc::AlignedMemoryBlock<LinkedCode::alignmentBytes> stateMemory, ioMemory;
 
         AdvanceOneFrameFn advanceOneFrameFn = {};
         AdvanceBlockFn    advanceBlockFn = {};
+        AdvanceBlockFn    advanceToFrameFn = {};
 
         uint8_t* statePointer = nullptr;
         uint8_t* ioPointer = nullptr;
@@ -484,8 +715,8 @@ struct LLVMEngine
         //==============================================================================
         void reset() noexcept
         {
-            stateMemory.clear();
-            ioMemory.clear();
+            if (code->stateSize != 0)  memset (statePointer, 0, code->stateSize);
+            if (code->ioSize != 0)     memset (ioPointer, 0, code->ioSize);
 
             int processorID = 0;
             code->initialiseFn (statePointer, &processorID, sessionID, frequency);
@@ -499,200 +730,198 @@ struct LLVMEngine
                 advanceBlockFn (statePointer, ioPointer, framesToAdvance);
         }
 
-        std::function<void(void*, uint32_t)> createCopyOutputValueFunction (const EndpointInfo& e)
+        bool canAdvanceToFrame() const noexcept     { return advanceToFrameFn != nullptr; }
+
+        /// Renders the frames from the current position in the block up to (but not
+        /// including) the given frame. A following call to advance() will finish the block.
+        void advanceToFrame (uint32_t frame) noexcept
+        {
+            advanceToFrameFn (statePointer, ioPointer, frame);
+        }
+
+        void initialiseOutputStreamOrValueDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
         {
             if (e.details.isStream())
             {
                 auto& info = code->getEndpointInfo (code->outputStreams, e.handle);
-                auto* source = ioPointer + info.addressOffset;
-                auto destStride = info.frameSize;
-                auto sourceStride = info.frameStride;
-
-                if (destStride == sourceStride)
-                {
-                    return [source, destStride] (void* destBuffer, uint32_t numFrames)
-                    {
-                        memcpy (destBuffer, source, destStride * numFrames);
-                        memset (source, 0, destStride * numFrames);
-                    };
-                }
-                else
-                {
-                    auto* frameLayout = info.frameLayout.get();
-
-                    return [source, destStride, sourceStride, frameLayout] (void* destBuffer, uint32_t numFrames)
-                    {
-                        auto dest = static_cast<uint8_t*> (destBuffer);
-                        auto src = source;
-
-                        for (uint32_t i = 0; i < numFrames; ++i)
-                        {
-                            frameLayout->copyNativeToPacked (dest, src);
-                            dest += destStride;
-                            src += sourceStride;
-                        }
-
-                        memset (source, 0, sourceStride * numFrames);
-                    };
-                }
+                d.address = ioPointer + info.addressOffset;
+                d.frameSize = static_cast<uint32_t> (info.frameSize);
+                d.frameStride = static_cast<uint32_t> (info.frameStride);
+                d.layout = info.frameLayout.get();
+                d.canCopyFramesDirectly = d.frameSize == d.frameStride;
+                d.copyOutput = copyOutputFrames;
             }
             else
             {
                 auto& info = code->getEndpointInfo (code->outputValues, e.handle);
-                auto* source = statePointer + info.addressOffset;
-                auto layout = info.layout.get();
-
-                return [layout, source] (void* destBuffer, uint32_t)
-                {
-                    layout->copyNativeToPacked (destBuffer, source);
-                };
+                d.address = statePointer + info.addressOffset;
+                d.layout = info.layout.get();
+                d.copyOutput = copyOutputValue;
             }
         }
 
-        std::function<void(const void*, uint32_t, uint32_t)> createSetInputStreamFramesFunction (const EndpointInfo& e)
+        static void copyOutputFrames (const EndpointDispatchRecord& d, void* destBuffer, uint32_t numFrames)
         {
-            auto& info = code->getEndpointInfo (code->inputStreams, e.handle);
-            auto* dest = ioPointer + info.addressOffset;
-            auto destStride = info.frameStride;
-            auto sourceStride = info.frameSize;
+            auto dest = static_cast<uint8_t*> (destBuffer);
+            auto src = d.address;
 
-            if (destStride == sourceStride)
+            for (uint32_t i = 0; i < numFrames; ++i)
             {
-                return [dest, destStride] (const void* sourceData, uint32_t numFrames, uint32_t numTrailingFramesToClear)
-                {
-                    auto source = static_cast<const uint8_t*> (sourceData);
-                    auto size = destStride * numFrames;
-                    memcpy (dest, source, size);
-
-                    if (numTrailingFramesToClear != 0)
-                        memset (dest + size, 0, numTrailingFramesToClear * destStride);
-                };
+                d.layout->copyNativeToPacked (dest, src);
+                dest += d.frameSize;
+                src += d.frameStride;
             }
-            else
-            {
-                auto* frameLayout = info.frameLayout.get();
 
-                return [dest, destStride, sourceStride, frameLayout] (const void* sourceData, uint32_t numFrames, uint32_t numTrailingFramesToClear)
-                {
-                    auto source = static_cast<const uint8_t*> (sourceData);
-                    auto d = dest;
+            memset (d.address, 0, d.frameStride * numFrames);
+        }
 
-                    for (uint32_t i = 0; i < numFrames; ++i)
-                    {
-                        frameLayout->copyPackedToNative (d, source);
-                        d += destStride;
-                        source += sourceStride;
-                    }
+        static void copyOutputValue (const EndpointDispatchRecord& d, void* destBuffer, uint32_t)
+        {
+            d.layout->copyNativeToPacked (destBuffer, d.address);
+        }
 
-                    if (numTrailingFramesToClear != 0)
-                        memset (d, 0, numTrailingFramesToClear * destStride);
-                };
-            }
+        void initialiseInputStreamDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
+        {
+            auto& info = code->getEndpointInfo (code->inputStreams, e.handle);
+            d.address = ioPointer + info.addressOffset;
+            d.frameSize = static_cast<uint32_t> (info.frameSize);
+            d.frameStride = static_cast<uint32_t> (info.frameStride);
+            d.layout = info.frameLayout.get();
+            d.canCopyFramesDirectly = d.frameSize == d.frameStride;
+            d.setInputFrames = setInputStreamFrames;
         }
 
-        auto createSetInputValueFunction (const EndpointInfo& e)
+        static void setInputStreamFrames (const EndpointDispatchRecord& d, const void* sourceData, uint32_t numFrames, uint32_t numTrailingFramesToClear)
         {
-            auto& info = code->getEndpointInfo (code->inputValues, e.handle);
-            auto* layout = info.layout.get();
-            auto setValueFn = info.setValue;
-            auto state = statePointer;
-            choc::AlignedMemoryBlock<16> tempBuffer (info.dataSize);
+            auto source = static_cast<const uint8_t*> (sourceData);
+            auto dest = d.address;
 
-            return [setValueFn, state, layout, tempBuffer] (const void* valueData, uint32_t numFramesToReachValue) mutable
+            for (uint32_t i = 0; i < numFrames; ++i)
             {
-                auto* buffer = tempBuffer.data();
-                layout->copyPackedToNative (buffer, valueData);
-                setValueFn (state, buffer, numFramesToReachValue);
-            };
+                d.layout->copyPackedToNative (dest, source);
+                dest += d.frameStride;
+                source += d.frameSize;
+            }
+
+            if (numTrailingFramesToClear != 0)
+                memset (dest, 0, numTrailingFramesToClear * d.frameStride);
         }
 
-        std::function<void(const void*)> createSendEventFunction (const EndpointInfo&, const AST::TypeBase& type, const AST::Function& f)
+        void initialiseInputValueDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
         {
-            auto eventType = type.toChocType();
-            auto name = AST::getEventHandlerFunctionName (f);
-            auto state = statePointer;
+            auto& info = code->getEndpointInfo (code->inputValues, e.handle);
+            d.address = statePointer;
+            d.secondaryAddress = allocateScratchSpace (info.dataSize);
+            d.layout = info.layout.get();
+            d.function = reinterpret_cast<void*> (info.setValue);
+            d.setInputValue = setInputValue;
+        }
 
-            void* call = code->lljit.findSymbol (name);
-            CMAJ_ASSERT (call != nullptr);
+        static void setInputValue (const EndpointDispatchRecord& d, const void* valueData, uint32_t numFramesToReachValue)
+        {
+            d.layout->copyPackedToNative (d.secondaryAddress, valueData);
+            reinterpret_cast<SetValueRampFn> (d.function) (d.address, d.secondaryAddress, numFramesToReachValue);
+        }
 
-            if (type.isVoid())              return [call, state] (const void*)      { using F = void(*)(void*);           reinterpret_cast<F> (call) (state); };
-            if (type.isPrimitiveInt32())    return [call, state] (const void* data) { using F = void(*)(void*, int32_t);  reinterpret_cast<F> (call) (state, *static_cast<const int32_t*>  (data)); };
-            if (type.isPrimitiveInt64())    return [call, state] (const void* data) { using F = void(*)(void*, int64_t);  reinterpret_cast<F> (call) (state, *static_cast<const int64_t*>  (data)); };
-            if (type.isPrimitiveFloat32())  return [call, state] (const void* data) { using F = void(*)(void*, float);    reinterpret_cast<F> (call) (state, *static_cast<const float*>    (data)); };
-            if (type.isPrimitiveFloat64())  return [call, state] (const void* data) { using F = void(*)(void*, double);   reinterpret_cast<F> (call) (state, *static_cast<const double*>   (data)); };
-            if (type.isPrimitiveBool())     return [call, state] (const void* data) { using F = void(*)(void*, int32_t);  reinterpret_cast<F> (call) (state, *static_cast<const int32_t*>  (data)); };
-            if (type.isPrimitiveString())   return [call, state] (const void* data) { using F = void(*)(void*, uint32_t); reinterpret_cast<F> (call) (state, *static_cast<const uint32_t*> (data)); };
+        void initialiseEventDispatch (EventDispatchRecord& d, const EndpointInfo&, const AST::TypeBase& type, const AST::Function& f)
+        {
+            d.function = code->lljit.findSymbol (AST::getEventHandlerFunctionName (f));
+            d.state = statePointer;
+            CMAJ_ASSERT (d.function != nullptr);
+
+            if (type.isVoid())              { d.send = sendVoidEvent; return; }
+            if (type.isPrimitiveInt32())    { d.send = sendPrimitiveEvent<int32_t>; return; }
+            if (type.isPrimitiveInt64())    { d.send = sendPrimitiveEvent<int64_t>; return; }
+            if (type.isPrimitiveFloat32())  { d.send = sendPrimitiveEvent<float>; return; }
+            if (type.isPrimitiveFloat64())  { d.send = sendPrimitiveEvent<double>; return; }
+            if (type.isPrimitiveBool())     { d.send = sendPrimitiveEvent<int32_t>; return; }
+            if (type.isPrimitiveString())   { d.send = sendPrimitiveEvent<uint32_t>; return; }
 
             auto& layout = *code->nativeTypeLayouts.find (type);
 
             if (layout.requiresPacking())
             {
-                choc::AlignedMemoryBlock<16> scratch (layout.getNativeSize());
-
-                return [call, state, scratch, &layout] (const void* data) mutable
-                {
-                    layout.copyPackedToNative (scratch.data(), data);
-                    using F = void(*)(void*, const void*);
-                    reinterpret_cast<F> (call) (state, scratch.data());
-                };
+                d.layout = std::addressof (layout);
+                d.scratch = allocateScratchSpace (layout.getNativeSize());
+                d.send = sendPackedEvent;
+                return;
             }
 
-            return [call, state] (const void* data)
-            {
-                using F = void(*)(void*, const void*);
-                reinterpret_cast<F> (call) (state, data);
-            };
+            d.send = sendEventByPointer;
         }
 
-        auto createGetNumOutputEventsFunction (const EndpointInfo& e)
+        static void sendVoidEvent (const EventDispatchRecord& d, const void*)
         {
-            auto& info = code->getEndpointInfo (code->outputEvents, e.handle);
-            auto* count = reinterpret_cast<uint32_t*> (statePointer + info.eventCountAddressOffset);
-            return [count] { return *count; };
+            using F = void(*)(void*);
+            reinterpret_cast<F> (d.function) (d.state);
         }
 
-        auto createResetEventCountFunction (const EndpointInfo& e)
+        template <typename ArgType>
+        static void sendPrimitiveEvent (const EventDispatchRecord& d, const void* data)
         {
-            auto& info = code->getEndpointInfo (code->outputEvents, e.handle);
-            auto* count = reinterpret_cast<uint32_t*> (statePointer + info.eventCountAddressOffset);
-            return [count] { *count = 0; };
+            using F = void(*)(void*, ArgType);
+            reinterpret_cast<F> (d.function) (d.state, *static_cast<const ArgType*> (data));
         }
 
-        auto createGetEventTypeIndexFunction (const EndpointInfo& e)
+        static void sendEventByPointer (const EventDispatchRecord& d, const void* data)
         {
-            auto& info = code->getEndpointInfo (code->outputEvents, e.handle);
-            auto* firstTypeEntry = statePointer + info.eventListStartAddressOffset + info.typeFieldOffset;
-            auto stride = info.eventListElementStride;
+            using F = void(*)(void*, const void*);
+            reinterpret_cast<F> (d.function) (d.state, data);
+        }
 
-            return [firstTypeEntry, stride] (uint32_t index)
-            {
-                return *reinterpret_cast<uint32_t*> (firstTypeEntry + (index * stride));
-            };
+        static void sendPackedEvent (const EventDispatchRecord& d, const void* data)
+        {
+            d.layout->copyPackedToNative (d.scratch, data);
+            using F = void(*)(void*, const void*);
+            reinterpret_cast<F> (d.function) (d.state, d.scratch);
         }
 
-        auto createReadOutputEventFunction (const EndpointInfo& e)
+        void initialiseOutputEventDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
         {
             auto& info = code->getEndpointInfo (code->outputEvents, e.handle);
-            auto* firstListEntry = statePointer + info.eventListStartAddressOffset;
-            auto typeFieldOffset = info.typeFieldOffset;
-            auto stride = info.eventListElementStride;
-            choc::span<LinkedCode::OutputEventEndpoint::EventTypeHandler> eventTypeHandlers (info.eventTypeHandlers);
+            d.address = statePointer + info.eventListStartAddressOffset;
+            d.secondaryAddress = statePointer + info.eventCountAddressOffset;
+            d.frameStride = static_cast<uint32_t> (info.eventListElementStride);
+            d.fieldOffset = static_cast<uint32_t> (info.typeFieldOffset);
+            d.context = const_cast<LinkedCode::OutputEventEndpoint*> (std::addressof (info));
+            d.getNumOutputEvents = getNumOutputEvents;
+            d.readOutputEvent = readOutputEvent;
+            d.resetEventCount = resetEventCount;
+        }
 
-            return [firstListEntry, stride, typeFieldOffset, eventTypeHandlers] (uint32_t index, void* dataBuffer)
-            {
-                auto eventEntry = firstListEntry + index * stride;
+        static uint32_t getNumOutputEvents (const EndpointDispatchRecord& d)
+        {
+            return *reinterpret_cast<const uint32_t*> (d.secondaryAddress);
+        }
 
-                auto frame = *reinterpret_cast<uint32_t*> (eventEntry);
-                auto type = *reinterpret_cast<uint32_t*> (eventEntry + typeFieldOffset);
+        static void resetEventCount (const EndpointDispatchRecord& d)
+        {
+            *reinterpret_cast<uint32_t*> (d.secondaryAddress) = 0;
+        }
 
-                CMAJ_ASSERT (type < eventTypeHandlers.size());
-                auto& handler = eventTypeHandlers[type];
-                handler.layout->copyNativeToPacked (dataBuffer, eventEntry + handler.offset);
+        static uint32_t readOutputEvent (const EndpointDispatchRecord& d, uint32_t index, uint32_t& typeIndex, void* dataBuffer)
+        {
+            auto& eventTypeHandlers = static_cast<const LinkedCode::OutputEventEndpoint*> (d.context)->eventTypeHandlers;
+            auto eventEntry = d.address + index * d.frameStride;
 
-                return frame;
-            };
+            auto frame = *reinterpret_cast<const uint32_t*> (eventEntry);
+            typeIndex  = *reinterpret_cast<const uint32_t*> (eventEntry + d.fieldOffset);
+
+            CMAJ_ASSERT (typeIndex < eventTypeHandlers.size());
+            auto& handler = eventTypeHandlers[typeIndex];
+            handler.layout->copyNativeToPacked (dataBuffer, eventEntry + handler.offset);
+
+            return frame;
         }
 
+        uint8_t* allocateScratchSpace (size_t size)
+        {
+            scratchBuffers.push_back (std::make_unique<choc::AlignedMemoryBlock<16>> (size));
+            return static_cast<uint8_t*> (scratchBuffers.back()->data());
+        }
+
+        std::vector<std::unique_ptr<choc::AlignedMemoryBlock<16>>> scratchBuffers;
+
         choc::value::StringDictionary& getDictionary()  { return code->stringDictionary; }
     };
 
@@ -701,6 +930,17 @@ struct LLVMEngine
         return choc::com::create<PerformerBase<JITInstance>> (code, engine)
                  .getWithIncrementedRefCount();
     }
+
+    PerformerPoolInterface* createPerformerPool (std::shared_ptr<LinkedCode> code, uint32_t numInstances)
+    {
+        auto arena = std::make_shared<InstanceArena> (*code, numInstances);
+        auto pool = choc::com::create<BasicPerformerPool<PerformerBase<JITInstance>>>();
+
+        for (uint32_t i = 0; i < numInstances; ++i)
+            pool->add (choc::com::create<PerformerBase<JITInstance>> (code, engine, arena, i));
+
+        return pool.getWithIncrementedRefCount();
+    }
 };
 
 //==============================================================================
@@ -772,7 +1012,12 @@ std::string generateAssembler (const cmaj::ProgramInterface& p,
                                  false);
 
     if (generator.generate())
+    {
+        if (targetFormat == "ir")
+            return generator.printIR();
+
         return generator.printAssembly (*targetMachine, targetFormat == "obj");
+    }
 
     return {};
 }
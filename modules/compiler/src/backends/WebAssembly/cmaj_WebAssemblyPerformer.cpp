@@ -55,6 +55,8 @@ struct WebAssemblyEngine
     static constexpr bool usesDynamicRateAndSessionID = false;
     static constexpr bool allowTopLevelSlices = false;
     static constexpr bool supportsExternalFunctions = false;
+    static constexpr bool supportsNodeProfiling = false;
+    static constexpr bool canReferenceExternalData = false;
     static bool engineSupportsIntrinsic (AST::Intrinsic::Type) { return false; }
 
     //==============================================================================
@@ -158,7 +160,33 @@ initialisePatch();
             context.evaluate (instanceName + ".advance (" + std::to_string (framesToAdvance) + ")");
         }
 
-        std::function<void(void*, uint32_t)> createCopyOutputValueFunction (const EndpointInfo& e)
+        bool canAdvanceToFrame() const      { return false; }
+        void advanceToFrame (uint32_t)      {}
+
+        /// Holds the javascript commands and temporary values that a dispatch
+        /// record needs to talk to one of the instance's endpoints
+        struct EndpointContext
+        {
+            JITInstance& owner;
+            std::string command;
+            choc::value::Type type;
+            choc::value::Value temp;
+            std::vector<choc::value::Type> dataTypes;
+            uint32_t numChannels = 0;
+        };
+
+        std::vector<std::unique_ptr<EndpointContext>> endpointContexts;
+
+        EndpointContext& createEndpointContext (std::string command)
+        {
+            endpointContexts.push_back (std::make_unique<EndpointContext> (EndpointContext { *this, std::move (command), {}, {}, {}, 0 }));
+            return *endpointContexts.back();
+        }
+
+        static EndpointContext& getContext (const EndpointDispatchRecord& d)  { return *static_cast<EndpointContext*> (d.context); }
+        static EndpointContext& getContext (const EventDispatchRecord& d)     { return *static_cast<EndpointContext*> (d.context); }
+
+        void initialiseOutputStreamOrValueDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
         {
             const auto& name = e.details.endpointID.toString();
             CMAJ_ASSERT (e.details.dataTypes.size() == 1);
@@ -178,61 +206,73 @@ initialisePatch();
                     "NAME", name,
                     "INSTANCE", instanceName));
 
-                return [this,
-                        frameType = e.details.dataTypes.front(),
-                        functionName = "returnOutputFrames_" + name] (void* destBuffer, uint32_t numFrames)
+                auto& c = createEndpointContext ("returnOutputFrames_" + name);
+                c.type = e.details.dataTypes.front();
+                d.context = std::addressof (c);
+
+                d.copyOutput = [] (const EndpointDispatchRecord& r, void* destBuffer, uint32_t numFrames)
                 {
+                    auto& ctx = getContext (r);
                     ScopedDisableAllocationTracking disableTracking;
-                    auto result = context.evaluateWithResult (functionName + "(" + std::to_string (numFrames) + ")");
-                    writeToValueWithType (destBuffer, choc::value::Type::createArray (frameType, numFrames), result);
+                    auto result = ctx.owner.context.evaluateWithResult (ctx.command + "(" + std::to_string (numFrames) + ")");
+                    writeToValueWithType (destBuffer, choc::value::Type::createArray (ctx.type, numFrames), result);
                 };
             }
             else
             {
-                return [this,
-                        command = instanceName + ".getOutputValue_" + name + "()",
-                        endpointType = e.details.dataTypes.front()] (void* destBuffer, uint32_t)
+                auto& c = createEndpointContext (instanceName + ".getOutputValue_" + name + "()");
+                c.type = e.details.dataTypes.front();
+                d.context = std::addressof (c);
+
+                d.copyOutput = [] (const EndpointDispatchRecord& r, void* destBuffer, uint32_t)
                 {
+                    auto& ctx = getContext (r);
                     ScopedDisableAllocationTracking disableTracking;
-                    auto result = context.evaluateWithResult (command);
-                    writeToValueWithType (destBuffer, endpointType, result);
+                    auto result = ctx.owner.context.evaluateWithResult (ctx.command);
+                    writeToValueWithType (destBuffer, ctx.type, result);
                 };
             }
         }
 
-        std::function<void(const void*, uint32_t, uint32_t)> createSetInputStreamFramesFunction (const EndpointInfo& e)
+        void initialiseInputStreamDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
         {
-            auto command = instanceName + ".setInputStreamFrames_" + e.details.endpointID.toString() + "([";
+            auto& c = createEndpointContext (instanceName + ".setInputStreamFrames_" + e.details.endpointID.toString() + "([");
             CMAJ_ASSERT (e.details.dataTypes.size() == 1);
             auto elementType = e.details.dataTypes.front();
-            uint32_t numChannels = 0;
 
             if (elementType.isArray() || elementType.isVector())
             {
-                numChannels = elementType.getNumElements();
+                c.numChannels = elementType.getNumElements();
                 elementType = elementType.getElementType();
             }
 
+            d.context = std::addressof (c);
+
             if (elementType.isFloat32())
             {
-                return [this, command, numChannels] (const void* sourceData, uint32_t numFrames, uint32_t numTrailingFramesToClear)
+                d.setInputFrames = [] (const EndpointDispatchRecord& r, const void* sourceData, uint32_t numFrames, uint32_t numTrailingFramesToClear)
                 {
+                    auto& ctx = getContext (r);
                     ScopedDisableAllocationTracking disableTracking;
-                    this->setInputStreamFrames<float> (command, sourceData, numChannels, numFrames, numTrailingFramesToClear);
+                    ctx.owner.setInputStreamFrames<float> (ctx.command, sourceData, ctx.numChannels, numFrames, numTrailingFramesToClear);
                 };
+
+                return;
             }
 
             if (elementType.isFloat64())
             {
-                return [this, command, numChannels] (const void* sourceData, uint32_t numFrames, uint32_t numTrailingFramesToClear)
+                d.setInputFrames = [] (const EndpointDispatchRecord& r, const void* sourceData, uint32_t numFrames, uint32_t numTrailingFramesToClear)
                 {
+                    auto& ctx = getContext (r);
                     ScopedDisableAllocationTracking disableTracking;
-                    this->setInputStreamFrames<double> (command, sourceData, numChannels, numFrames, numTrailingFramesToClear);
+                    ctx.owner.setInputStreamFrames<double> (ctx.command, sourceData, ctx.numChannels, numFrames, numTrailingFramesToClear);
                 };
+
+                return;
             }
 
             CMAJ_ASSERT_FALSE;
-            return {};
         }
 
         template <typename FloatType>
@@ -289,76 +329,66 @@ initialisePatch();
             context.evaluate (s.str());
         }
 
-        auto createSetInputValueFunction (const EndpointInfo& e)
+        void initialiseInputValueDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
         {
-            auto command = instanceName + ".setInputValue_" + e.details.endpointID.toString() + "(";
+            auto& c = createEndpointContext (instanceName + ".setInputValue_" + e.details.endpointID.toString() + "(");
             CMAJ_ASSERT (e.details.dataTypes.size() == 1);
-            auto temp = choc::value::Value (e.details.dataTypes.front());
+            c.temp = choc::value::Value (e.details.dataTypes.front());
+            d.context = std::addressof (c);
 
-            return [this, command, temp = std::move (temp)] (const void* valueData, uint32_t numFramesToReachValue) mutable
+            d.setInputValue = [] (const EndpointDispatchRecord& r, const void* valueData, uint32_t numFramesToReachValue)
             {
+                auto& ctx = getContext (r);
                 ScopedDisableAllocationTracking disableTracking;
-                memcpy (temp.getRawData(), valueData, temp.getRawDataSize());
-                context.evaluate (command + choc::json::toString (temp) + ", " + std::to_string (numFramesToReachValue) + ")");
+                memcpy (ctx.temp.getRawData(), valueData, ctx.temp.getRawDataSize());
+                ctx.owner.context.evaluate (ctx.command + choc::json::toString (ctx.temp) + ", " + std::to_string (numFramesToReachValue) + ")");
             };
         }
 
-        std::function<void(const void*)> createSendEventFunction (const EndpointInfo&, const AST::TypeBase& type, const AST::Function& f)
+        void initialiseEventDispatch (EventDispatchRecord& d, const EndpointInfo&, const AST::TypeBase& type, const AST::Function& f)
         {
-            auto eventType = type.toChocType();
-            auto command = instanceName + "." + AST::getEventHandlerFunctionName (f, "sendInputEvent_") + "(";
-            auto temp = choc::value::Value (eventType);
+            auto& c = createEndpointContext (instanceName + "." + AST::getEventHandlerFunctionName (f, "sendInputEvent_") + "(");
+            c.temp = choc::value::Value (type.toChocType());
+            d.context = std::addressof (c);
 
-            return [this, command, temp = std::move (temp)] (const void* eventData) mutable
+            d.send = [] (const EventDispatchRecord& r, const void* eventData)
             {
+                auto& ctx = getContext (r);
                 ScopedDisableAllocationTracking disableTracking;
-                memcpy (temp.getRawData(), eventData, temp.getRawDataSize());
-                context.evaluate (command + choc::json::toString (temp) + ")");
+                memcpy (ctx.temp.getRawData(), eventData, ctx.temp.getRawDataSize());
+                ctx.owner.context.evaluate (ctx.command + choc::json::toString (ctx.temp) + ")");
             };
         }
 
-        auto createGetNumOutputEventsFunction (const EndpointInfo& e)
+        void initialiseOutputEventDispatch (EndpointDispatchRecord& d, const EndpointInfo& e)
         {
-            auto command = instanceName + ".getOutputEventCount_" + e.details.endpointID.toString() + "()";
-
-            return [this, command]
-            {
-                ScopedDisableAllocationTracking disableTracking;
-                return static_cast<uint32_t> (context.evaluateWithResult (command).template getWithDefault<int32_t> (0));
-            };
-        }
+            auto& c = createEndpointContext (e.details.endpointID.toString());
+            c.dataTypes = e.details.dataTypes;
+            d.context = std::addressof (c);
 
-        auto createResetEventCountFunction (const EndpointInfo& e)
-        {
-            auto command = instanceName + ".resetOutputEventCount_" + e.details.endpointID.toString() + "()";
-            return [this, command]
+            d.getNumOutputEvents = [] (const EndpointDispatchRecord& r)
             {
+                auto& ctx = getContext (r);
                 ScopedDisableAllocationTracking disableTracking;
-                context.evaluate (command);
+                auto command = ctx.owner.instanceName + ".getOutputEventCount_" + ctx.command + "()";
+                return static_cast<uint32_t> (ctx.owner.context.evaluateWithResult (command).template getWithDefault<int32_t> (0));
             };
-        }
 
-        auto createGetEventTypeIndexFunction (const EndpointInfo& e)
-        {
-            auto command = instanceName + ".getOutputEvent_" + e.details.endpointID.toString() + "(";
-
-            return [this, command] (uint32_t index)
+            d.resetEventCount = [] (const EndpointDispatchRecord& r)
             {
+                auto& ctx = getContext (r);
                 ScopedDisableAllocationTracking disableTracking;
-                return static_cast<uint32_t> (context.evaluateWithResult (command + std::to_string (index) + ").typeIndex").template getWithDefault<int32_t> (0));
+                ctx.owner.context.evaluate (ctx.owner.instanceName + ".resetOutputEventCount_" + ctx.command + "()");
             };
-        }
-
-        auto createReadOutputEventFunction (const EndpointInfo& e)
-        {
-            auto command = instanceName + ".getOutputEvent_" + e.details.endpointID.toString() + "(";
 
-            return [this, command, dataTypes = e.details.dataTypes] (uint32_t index, void* dataBuffer)
+            d.readOutputEvent = [] (const EndpointDispatchRecord& r, uint32_t index, uint32_t& typeIndex, void* dataBuffer)
             {
+                auto& ctx = getContext (r);
                 ScopedDisableAllocationTracking disableTracking;
-                auto result = context.evaluateWithResult (command + std::to_string (index) + ")");
-                auto typeIndex = static_cast<uint32_t> (result["typeIndex"].template getWithDefault<int32_t> (0));
-                writeToValueWithType (dataBuffer, dataTypes[typeIndex], result["event"]);
+                auto result = ctx.owner.context.evaluateWithResult (ctx.owner.instanceName + ".getOutputEvent_" + ctx.command
+                                                                      + "(" + std::to_string (index) + ")");
+                typeIndex = static_cast<uint32_t> (result["typeIndex"].template getWithDefault<int32_t> (0));
+                writeToValueWithType (dataBuffer, ctx.dataTypes[typeIndex], result["event"]);
                 return static_cast<uint32_t> (result["frame"].template get<int32_t>());
             };
         }
@@ -530,6 +560,12 @@ initialisePatch();
                  .getWithIncrementedRefCount();
     }
 
+    PerformerPoolInterface* createPerformerPool (std::shared_ptr<LinkedCode> code, uint32_t numInstances)
+    {
+        // each instance lives in its own WebAssembly module, so there's no memory to share
+        return createPoolOfSeparatePerformers (*this, std::move (code), numInstances);
+    }
+
     static void writeToValueWithType (void* destData, const choc::value::Type& destType, const choc::value::ValueView& source)
     {
         auto coerced = coerceValueToType (destType, source);
@@ -0,0 +1,269 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "choc/memory/choc_xxHash.h"
+#include "../AST/cmaj_AST.h"
+
+namespace cmaj
+{
+
+//==============================================================================
+/// Holds the raw bytes of a program's large constant arrays outside its generated code.
+///
+/// Building IR constants for multi-megabyte tables is slow and memory-hungry, and the data
+/// then gets copied into every cached module. Instead, a back-end which can link to data
+/// declares each large constant as an external symbol, and the JIT resolves it to one of
+/// the blocks held here.
+///
+/// The symbol names are made from a hash of the data, so code that was reloaded from a
+/// cache links to the same blocks, and identical blocks are shared by every program in
+/// the process.
+struct ConstantDataSegment
+{
+    /// Constants smaller than this are left for the code generator to emit as normal
+    static constexpr size_t minimumSizeInBytes = 4096;
+    static constexpr size_t alignmentBytes = 64;
+
+    struct Block
+    {
+        const void* getData() const     { return data; }
+
+        std::string symbolName;
+        size_t size = 0;
+
+    private:
+        friend struct ConstantDataSegment;
+        std::vector<char> storage;
+        char* data = nullptr;
+    };
+
+    /// Finds all the large constants in a program and stores their data
+    void addConstants (AST::Program& program)
+    {
+        struct FindLargeConstants  : public AST::NonParameterisedObjectVisitor
+        {
+            using super = AST::NonParameterisedObjectVisitor;
+            using super::visit;
+
+            FindLargeConstants (ConstantDataSegment& s, AST::Allocator& a) : super (a), segment (s) {}
+
+            void visit (AST::ConstantAggregate& a) override
+            {
+                if (! segment.addConstant (a))
+                    super::visit (a);
+            }
+
+            ConstantDataSegment& segment;
+        };
+
+        FindLargeConstants (*this, program.allocator).visitObject (program.rootNamespace);
+    }
+
+    /// Returns the block that holds this constant's data, or nullptr if it wasn't stored
+    const Block* findBlock (const AST::ConstantValueBase& value) const
+    {
+        auto found = blocks.find (std::addressof (value));
+        return found != blocks.end() ? found->second.get() : nullptr;
+    }
+
+    /// Returns a map of symbol names to addresses for all the blocks that this program uses
+    std::unordered_map<std::string, void*> getSymbols() const
+    {
+        std::unordered_map<std::string, void*> symbols;
+
+        for (auto& b : blocks)
+            symbols[b.second->symbolName] = const_cast<void*> (b.second->getData());
+
+        return symbols;
+    }
+
+    size_t getNumBlocks() const     { return blocks.size(); }
+
+    /// Returns the address of the data that is currently shared under a block's symbol
+    /// name, or nullptr if no program in the process is using a block with that name.
+    static const void* findSharedData (const std::string& symbolName)
+    {
+        auto& registry = getRegistry();
+        std::lock_guard<std::mutex> l (registry.lock);
+
+        auto found = registry.activeBlocks.find (symbolName);
+
+        if (found != registry.activeBlocks.end())
+            if (auto block = found->second.lock())
+                return block->getData();
+
+        return nullptr;
+    }
+
+private:
+    std::unordered_map<const AST::ConstantValueBase*, std::shared_ptr<const Block>> blocks;
+
+    bool addConstant (const AST::ConstantAggregate& a)
+    {
+        if (a.refersToExternalData() || a.isZero())
+            return false;
+
+        auto& type = a.getType().skipConstAndRefModifiers();
+
+        if (! type.isArrayType())
+            return false;
+
+        auto& elementType = *type.getArrayOrVectorElementType();
+        auto elementSize = getPackedSize (elementType);
+        auto numElements = static_cast<size_t> (a.getNumElements());
+
+        if (elementSize == 0 || elementSize * numElements < minimumSizeInBytes)
+            return false;
+
+        std::vector<char> data;
+        data.reserve (elementSize * numElements);
+
+        for (size_t i = 0; i < numElements; ++i)
+            if (! appendPackedData (data, a.getElementValueRef (i), elementType))
+                return false;
+
+        blocks[std::addressof (a)] = getSharedBlock (std::move (data), elementType.getLayoutSignature());
+        return true;
+    }
+
+    /// Returns the size of a type if its LLVM layout has no padding, or 0 if it isn't
+    /// a type that can be stored as raw data
+    static size_t getPackedSize (const AST::TypeBase& type)
+    {
+        auto& t = type.skipConstAndRefModifiers();
+
+        if (t.isPrimitiveFloat32() || t.isPrimitiveInt32())     return 4;
+        if (t.isPrimitiveFloat64() || t.isPrimitiveInt64())     return 8;
+
+        if (t.isVectorType() || t.isFixedSizeArray())
+        {
+            auto numElements = static_cast<size_t> (t.getFixedSizeAggregateNumElements());
+
+            // vectors are padded up to a power of 2 when they're in an array
+            if (t.isVectorType() && ! choc::math::isPowerOf2 (numElements))
+                return 0;
+
+            return getPackedSize (*t.getArrayOrVectorElementType()) * numElements;
+        }
+
+        return 0;
+    }
+
+    static bool appendPackedData (std::vector<char>& data, const AST::ConstantValueBase& value, const AST::TypeBase& type)
+    {
+        auto& t = type.skipConstAndRefModifiers();
+
+        if (value.isZero())
+        {
+            data.resize (data.size() + getPackedSize (t));
+            return true;
+        }
+
+        if (t.isPrimitiveFloat32())     return appendPrimitive<float>   (data, value);
+        if (t.isPrimitiveFloat64())     return appendPrimitive<double>  (data, value);
+        if (t.isPrimitiveInt32())       return appendPrimitive<int32_t> (data, value);
+        if (t.isPrimitiveInt64())       return appendPrimitive<int64_t> (data, value);
+
+        if (auto agg = value.getAsConstantAggregate())
+        {
+            auto& elementType = *t.getArrayOrVectorElementType();
+            auto numElements = static_cast<size_t> (t.getFixedSizeAggregateNumElements());
+
+            for (size_t i = 0; i < numElements; ++i)
+                if (! appendPackedData (data, agg->getElementValueRef (i), elementType))
+                    return false;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    template <typename PrimitiveType>
+    static bool appendPrimitive (std::vector<char>& data, const AST::ConstantValueBase& value)
+    {
+        if (auto v = value.castToPrimitive<PrimitiveType>())
+        {
+            auto n = *v;
+            auto pos = data.size();
+            data.resize (pos + sizeof (n));
+            std::memcpy (data.data() + pos, std::addressof (n), sizeof (n));
+            return true;
+        }
+
+        return false;
+    }
+
+    /// Returns the process-wide block for some data, creating it if it isn't already in use
+    static std::shared_ptr<const Block> getSharedBlock (std::vector<char>&& data, const std::string& elementTypeSignature)
+    {
+        choc::hash::xxHash64 hash;
+        hash.addInput (data.data(), data.size());
+        hash.addInput (elementTypeSignature);
+
+        auto name = "_cmaj_constant_data_" + choc::text::createHexString (hash.getHash());
+
+        auto& registry = getRegistry();
+        auto& activeBlocks = registry.activeBlocks;
+        std::lock_guard<std::mutex> l (registry.lock);
+
+        if (auto existing = activeBlocks[name].lock())
+            return existing;
+
+        for (auto i = activeBlocks.begin(); i != activeBlocks.end();)
+        {
+            if (i->second.expired())
+                i = activeBlocks.erase (i);
+            else
+                ++i;
+        }
+
+        auto block = std::make_shared<Block>();
+        block->symbolName = name;
+        block->size = data.size();
+        block->storage.resize (data.size() + alignmentBytes);
+
+        auto address = reinterpret_cast<uintptr_t> (block->storage.data());
+        block->data = block->storage.data() + ((alignmentBytes - (address % alignmentBytes)) % alignmentBytes);
+        std::memcpy (block->data, data.data(), data.size());
+
+        activeBlocks[name] = block;
+        return block;
+    }
+
+    struct Registry
+    {
+        std::mutex lock;
+        std::unordered_map<std::string, std::weak_ptr<const Block>> activeBlocks;
+    };
+
+    static Registry& getRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+};
+
+}
@@ -27,6 +27,7 @@
 #include "CPlusPlus/cmaj_CPlusPlus.h"
 #include "WebAssembly/cmaj_WebAssembly.h"
 #include "LLVM/cmaj_LLVM.h"
+#include "cmaj_NodeProfiler.h"
 
 namespace cmaj
 {
@@ -67,6 +68,7 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
     std::shared_ptr<typename Implementation::LinkedCode> linkedCode;
     CompilePerformanceTimes compilePerformanceTimes;
     std::vector<EndpointInfo> endpointHandles;
+    std::vector<std::string> profiledNodeNames;
     uint32_t nextHandle = 1;
 
     //==============================================================================
@@ -97,6 +99,7 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
         linkedCode.reset();
         mainProcessor = {};
         endpointHandles.clear();
+        profiledNodeNames.clear();
         loadedProgram.reset();
         newProgram.reset();
         program.reset();
@@ -129,6 +132,16 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
         details.setMember ("inputs",  getProgram().endpointList.inputEndpointDetails.toJSON (true));
         details.setMember ("outputs", getProgram().endpointList.outputEndpointDetails.toJSON (true));
 
+        if (! profiledNodeNames.empty())
+        {
+            auto nodes = choc::value::createEmptyArray();
+
+            for (auto& name : profiledNodeNames)
+                nodes.addArrayElement (name);
+
+            details.setMember ("profiledNodes", nodes);
+        }
+
         return choc::com::createString (choc::json::toString (details, true));
     }
 
@@ -160,6 +173,7 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
             }
 
             newProgram->externalVariableManager.setExternalRequestor (requestExternalVariable, variableContext);
+            newProgram->externalVariableManager.setCanReferenceExternalData (Implementation::canReferenceExternalData);
             newProgram->externalFunctionManager.setExternalRequestor (requestExternalFunction, functionContext);
 
             transformations::runBasicResolutionPasses (*newProgram);
@@ -192,6 +206,8 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
                 throwError (Errors::noProgramLoaded());
 
             double latency = 0;
+            bool profileNodes = Implementation::supportsNodeProfiling && buildSettings.shouldProfileNodes();
+            profiledNodeNames.clear();
 
             {
                 auto pc = compilePerformanceTimes.getCounter ("compile");
@@ -204,7 +220,11 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
                                                     Implementation::supportsExternalFunctions,
                                                     Implementation::engineSupportsIntrinsic,
                                                     latency,
-                                                    [this] (const EndpointID& e) { return isEndpointActive (e); });
+                                                    [this] (const EndpointID& e) { return isEndpointActive (e); },
+                                                    profileNodes ? std::addressof (profiledNodeNames) : nullptr);
+
+                if (! profiledNodeNames.empty())
+                    loadedProgramDetailsJSON = createProgramDetails();
             }
 
             {
@@ -232,6 +252,8 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
         auto hash = getProgram().codeHash;
         hash.addInput (implementation->getEngineVersion());
         hash.addInput (BuildSettings (buildSettings).setSessionID (0).toJSON());
+        hash.addInput (getProgram().externalVariableManager.getExternalDataDescription());
+        getProgram().externalVariableManager.addExternalValuesToHash (hash);
 
         return std::string (mainProcessor->getName()) + "_" + choc::text::createHexString (hash.getHash());
     }
@@ -292,6 +314,14 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
         return {};
     }
 
+    PerformerPoolInterface* createPerformerPool (uint32_t numInstances) override
+    {
+        if (linkedCode != nullptr && numInstances != 0)
+            return implementation->createPerformerPool (linkedCode, numInstances);
+
+        return {};
+    }
+
     //==============================================================================
     const char* getAvailableCodeGenTargetTypes() override
     {
@@ -366,7 +396,8 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
                                                       true,
                                                       engineSupportsIntrinsic,
                                                       latency,
-                                                      [this] (const EndpointID& e) { return isEndpointActive (e); });
+                                                      [this] (const EndpointID& e) { return isEndpointActive (e); },
+                                                      nullptr);
 
             bool outputTypeKnown = false;
             auto optionsString = optionsJSON != nullptr ? std::string_view (optionsJSON) : std::string_view();
@@ -432,18 +463,88 @@ struct EngineBase  : public choc::com::ObjectWithAtomicRefCount<EngineInterface,
 };
 
 
+//==============================================================================
+/// A flat, POD description of how to talk to one endpoint of a JIT instance.
+/// The performer builds a table of these when it's created, so that each call
+/// is just an index into that table and a direct function call, rather than
+/// going through virtual handlers and heap-allocated std::functions.
+struct EndpointDispatchRecord
+{
+    enum class Kind : uint8_t
+    {
+        none,
+        inputStream,
+        inputValue,
+        inputEvent,
+        outputStreamOrValue,
+        outputEvent
+    };
+
+    using SetInputFramesFn      = void(*)(const EndpointDispatchRecord&, const void* frames, uint32_t numFrames, uint32_t numTrailingFramesToClear);
+    using SetInputValueFn       = void(*)(const EndpointDispatchRecord&, const void* value, uint32_t numFramesToReachValue);
+    using CopyOutputFn          = void(*)(const EndpointDispatchRecord&, void* dest, uint32_t numFrames);
+    using GetNumOutputEventsFn  = uint32_t(*)(const EndpointDispatchRecord&);
+    using ReadOutputEventFn     = uint32_t(*)(const EndpointDispatchRecord&, uint32_t index, uint32_t& typeIndex, void* dataBuffer);
+    using ResetEventCountFn     = void(*)(const EndpointDispatchRecord&);
+
+    Kind kind = Kind::none;
+
+    /// If true, stream frames have the same packed and native layout, so the
+    /// performer can copy them to/from the address below without calling the backend
+    bool canCopyFramesDirectly = false;
+
+    /// Set when a caller has been given direct access to an output stream's frames, so
+    /// the performer needs to clear them itself before each block
+    bool isAccessedDirectly = false;
+
+    uint8_t* address = nullptr;
+    uint8_t* secondaryAddress = nullptr;
+    uint32_t frameSize = 0, frameStride = 0, fieldOffset = 0;
+    uint32_t firstEventType = 0, numEventTypes = 0, outputEventQueueIndex = 0;
+    const NativeTypeLayout* layout = nullptr;
+    void* function = nullptr;
+    void* context = nullptr;
+
+    SetInputFramesFn      setInputFrames = nullptr;
+    SetInputValueFn       setInputValue = nullptr;
+    CopyOutputFn          copyOutput = nullptr;
+    GetNumOutputEventsFn  getNumOutputEvents = nullptr;
+    ReadOutputEventFn     readOutputEvent = nullptr;
+    ResetEventCountFn     resetEventCount = nullptr;
+};
+
+/// Describes how to deliver one of the data types of an input event endpoint.
+struct EventDispatchRecord
+{
+    using SendEventFn = void(*)(const EventDispatchRecord&, const void* eventData);
+
+    SendEventFn send = ignoreEvent;
+    void* function = nullptr;
+    uint8_t* state = nullptr;
+    uint8_t* scratch = nullptr;
+    const NativeTypeLayout* layout = nullptr;
+    void* context = nullptr;
+    uint32_t dataSize = 0;
+
+    static void ignoreEvent (const EventDispatchRecord&, const void*) {}
+};
+
+
 //==============================================================================
 template <typename JITInstance>
 struct PerformerBase  : public choc::com::ObjectWithAtomicRefCount<cmaj::PerformerInterface, PerformerBase<JITInstance>>
 {
-    template <typename EngineType, typename LinkedCode>
-    PerformerBase (std::shared_ptr<LinkedCode> linkedCode, const EngineType& engine)
-        : jit (linkedCode, engine.buildSettings.getSessionID(), engine.buildSettings.getFrequency()),
+    template <typename EngineType, typename LinkedCode, typename... ExtraJITArgs>
+    PerformerBase (std::shared_ptr<LinkedCode> linkedCode, const EngineType& engine, ExtraJITArgs&&... extraJITArgs)
+        : jit (linkedCode, engine.buildSettings.getSessionID(), engine.buildSettings.getFrequency(),
+               std::forward<ExtraJITArgs> (extraJITArgs)...),
           maxBlockSize (engine.buildSettings.getMaxBlockSize()),
           eventBufferSize (engine.buildSettings.getEventBufferSize()),
-          latency (linkedCode->latency)
+          latency (linkedCode->latency),
+          nodeProfiler (engine.profiledNodeNames.size())
     {
         initialiseEndpointList (engine.endpointHandles);
+        pendingEvents.initialise (eventDispatchRecords, eventBufferSize);
     }
 
     virtual ~PerformerBase() = default;
@@ -452,6 +553,8 @@ struct PerformerBase  : public choc::com::ObjectWithAtomicRefCount<cmaj::Perform
     void reset() override
     {
         jit.reset();
+        nodeProfiler.reset();
+        pendingEvents.clear();
     }
 
     void setBlockSize (uint32_t numFramesForNextBlock) override
@@ -462,40 +565,159 @@ struct PerformerBase  : public choc::com::ObjectWithAtomicRefCount<cmaj::Perform
 
     void setInputFrames (EndpointHandle handle, const void* frameData, uint32_t numFrames) override
     {
-        getEndpointHandler (handle).setInputFrames (frameData, numFrames, numFramesToDo);
+        auto& d = getDispatchRecord (handle);
+        CMAJ_ASSERT (d.kind == EndpointDispatchRecord::Kind::inputStream);
+        uint32_t numTrailingFramesToClear = 0;
+
+        if (numFrames != numFramesToDo)
+        {
+            registerXRun();
+
+            if (numFrames > numFramesToDo)
+                numFrames = numFramesToDo;
+
+            numTrailingFramesToClear = numFramesToDo - numFrames;
+        }
+
+        if (d.canCopyFramesDirectly)
+        {
+            auto size = d.frameStride * numFrames;
+            memcpy (d.address, frameData, size);
+
+            if (numTrailingFramesToClear != 0)
+                memset (d.address + size, 0, numTrailingFramesToClear * d.frameStride);
+        }
+        else
+        {
+            d.setInputFrames (d, frameData, numFrames, numTrailingFramesToClear);
+        }
     }
 
     void setInputValue (EndpointHandle handle, const void* valueData, uint32_t numFramesToReachValue) override
     {
-        getEndpointHandler (handle).setInputValue (valueData, numFramesToReachValue);
+        auto& d = getDispatchRecord (handle);
+        CMAJ_ASSERT (d.kind == EndpointDispatchRecord::Kind::inputValue);
+        d.setInputValue (d, valueData, numFramesToReachValue);
     }
 
     void addInputEvent (EndpointHandle handle, uint32_t typeIndex, const void* eventData) override
     {
-        getEndpointHandler (handle).addInputEvent (typeIndex, eventData);
+        auto& d = getDispatchRecord (handle);
+        CMAJ_ASSERT (d.kind == EndpointDispatchRecord::Kind::inputEvent && typeIndex < d.numEventTypes);
+        auto& e = eventDispatchRecords[d.firstEventType + typeIndex];
+        e.send (e, eventData);
+    }
+
+    void addInputEvents (EndpointHandle handle, const EventBatch* batch) override
+    {
+        auto& d = getDispatchRecord (handle);
+        CMAJ_ASSERT (d.kind == EndpointDispatchRecord::Kind::inputEvent);
+        auto record = static_cast<const uint8_t*> (batch->events);
+
+        for (uint32_t i = 0; i < batch->numEvents; ++i, record += batch->eventStride)
+        {
+            auto& header = *reinterpret_cast<const EventBatch::Header*> (record);
+            CMAJ_ASSERT (header.typeIndex < d.numEventTypes);
+            auto dispatchIndex = d.firstEventType + header.typeIndex;
+            auto payload = record + EventBatch::payloadOffset;
+
+            // Events for later in the block are held back and delivered by advance()
+            // when it reaches their frame, if the back-end can stop part-way through
+            if (header.frameOffset != 0 && header.frameOffset < numFramesToDo && jit.canAdvanceToFrame())
+            {
+                if (pendingEvents.add (header.frameOffset, dispatchIndex, payload, eventDispatchRecords[dispatchIndex].dataSize))
+                    continue;
+
+                registerXRun();
+            }
+
+            auto& e = eventDispatchRecords[dispatchIndex];
+            e.send (e, payload);
+        }
+    }
+
+    bool supportsEventFrameOffsets() override
+    {
+        return jit.canAdvanceToFrame();
     }
 
     void copyOutputValue (EndpointHandle handle, void* dest) override
     {
-        getEndpointHandler (handle).copyOutputValue (dest);
+        auto& d = getDispatchRecord (handle);
+        CMAJ_ASSERT (d.kind == EndpointDispatchRecord::Kind::outputStreamOrValue);
+        d.copyOutput (d, dest, 1);
     }
 
     void copyOutputFrames (EndpointHandle handle, void* dest, uint32_t numFramesToCopy) override
     {
-        getEndpointHandler (handle).copyOutputFrames (dest, numFramesToCopy);
+        auto& d = getDispatchRecord (handle);
+        CMAJ_ASSERT (d.kind == EndpointDispatchRecord::Kind::outputStreamOrValue);
+
+        if (d.canCopyFramesDirectly)
+        {
+            auto size = d.frameStride * numFramesToCopy;
+            memcpy (dest, d.address, size);
+            memset (d.address, 0, size);
+        }
+        else
+        {
+            d.copyOutput (d, dest, numFramesToCopy);
+        }
+    }
+
+    void* getStreamFrameBuffer (EndpointHandle handle) override
+    {
+        CMAJ_ASSERT (handle >= firstHandle && handle < lastHandle);
+        auto& d = dispatchRecords[handle - firstHandle];
+
+        if (! d.canCopyFramesDirectly)
+            return nullptr;
+
+        if (d.kind == EndpointDispatchRecord::Kind::outputStreamOrValue && ! d.isAccessedDirectly)
+        {
+            d.isAccessedDirectly = true;
+            directlyAccessedOutputStreams.push_back (handle - firstHandle);
+        }
+
+        return d.address;
     }
 
     void iterateOutputEvents (EndpointHandle handle, void* context, PerformerInterface::HandleOutputEventCallback handler) override
     {
-        getEndpointHandler (handle).iterateOutputEvents (context, handler);
+        auto& d = getDispatchRecord (handle);
+        CMAJ_ASSERT (d.kind == EndpointDispatchRecord::Kind::outputEvent);
+        auto& queue = outputEventQueues[d.outputEventQueueIndex];
+        auto numEvents = queue.numEvents;
+
+        for (uint32_t i = 0; i < numEvents; ++i)
+        {
+            auto& event = queue.getEvent (i);
+
+            if (! handler (context, handle, event.type, event.frame, event.data, queue.eventSizes[event.type]))
+                break;
+        }
     }
 
     void advance() override
     {
-        jit.advance (numFramesToDo);
+        for (auto index : directlyAccessedOutputStreams)
+        {
+            auto& d = dispatchRecords[index];
+            memset (d.address, 0, d.frameStride * numFramesToDo);
+        }
+
+        if (nodeProfiler.counters.empty())
+        {
+            renderBlock();
+        }
+        else
+        {
+            NodeProfiler::ScopedActivation activeProfiler (nodeProfiler);
+            renderBlock();
+        }
 
-        for (auto& e : outputEventHandlers)
-            e->moveOutputEventsToQueue();
+        for (auto index : outputEventEndpoints)
+            moveOutputEventsToQueue (dispatchRecords[index]);
     }
 
     uint32_t getMaximumBlockSize() override     { return maxBlockSize; }
@@ -504,6 +726,12 @@ struct PerformerBase  : public choc::com::ObjectWithAtomicRefCount<cmaj::Perform
     uint32_t getXRuns() override                { return xruns; }
     const char* getRuntimeError() override      { return {}; }
 
+    const NodeProfileCounter* getNodeProfileCounters (uint32_t& numNodes) override
+    {
+        numNodes = static_cast<uint32_t> (nodeProfiler.counters.size());
+        return numNodes != 0 ? nodeProfiler.counters.data() : nullptr;
+    }
+
     const char* getStringForHandle (uint32_t handle, size_t& stringLength) override
     {
         try
@@ -528,282 +756,316 @@ private:
 
     const uint32_t maxBlockSize, eventBufferSize;
     const double latency;
+    NodeProfiler nodeProfiler;
 
     //==============================================================================
-    void initialiseEndpointList (const std::vector<EndpointInfo>& endpoints)
+    /// Holds copies of the input events which have a non-zero frame offset, sorted by
+    /// their frame, until advance() reaches the point where they need to be delivered.
+    struct PendingEventList
     {
-        if (endpoints.empty())
-            return;
+        struct Event
+        {
+            uint32_t frame = 0, dispatchIndex = 0;
+            uint64_t data[1];
+        };
 
-        firstHandle = endpoints.front().handle;
-        lastHandle = firstHandle;
+        void initialise (const std::vector<EventDispatchRecord>& records, uint32_t maxNumEventsToUse)
+        {
+            size_t maxEventDataSize = 0;
 
-        for (auto& endpoint : endpoints)
+            for (auto& e : records)
+                maxEventDataSize = std::max (maxEventDataSize, static_cast<size_t> (e.dataSize));
+
+            maxNumEvents = records.empty() ? 0 : maxNumEventsToUse;
+            eventStride = ((sizeof (Event) + maxEventDataSize) + 7u) & ~7u;
+            eventSpace.resize (maxNumEvents * eventStride);
+            order.resize (maxNumEvents);
+            numEvents = 0;
+        }
+
+        bool add (uint32_t frame, uint32_t dispatchIndex, const void* data, uint32_t dataSize) noexcept
         {
-            CMAJ_ASSERT (endpoint.handle == lastHandle); // handles must be in order
-            ++lastHandle;
+            if (numEvents == maxNumEvents)
+                return false;
 
-            if (endpoint.details.isInput)
-            {
-                if (endpoint.details.isEvent())
-                    endpointHandlers.push_back (std::make_unique<InputEventHandler> (*this, endpoint));
-                else if (endpoint.details.isStream())
-                    endpointHandlers.push_back (std::make_unique<InputStreamHandler> (*this, endpoint));
-                else
-                    endpointHandlers.push_back (std::make_unique<InputValueHandler> (*this, endpoint));
-            }
-            else if (endpoint.details.isEvent())
-            {
-                auto h = std::make_unique<OutputEventHandler> (*this, endpoint);
-                outputEventHandlers.push_back (h.get());
-                endpointHandlers.push_back (std::move (h));
-            }
-            else
+            auto slot = numEvents;
+            auto& event = getEventInSlot (slot);
+            event.frame = frame;
+            event.dispatchIndex = dispatchIndex;
+            memcpy (event.data, data, dataSize);
+
+            // insert after any events for the same or earlier frames, so that
+            // events at the same frame keep the order in which they were added
+            auto index = numEvents++;
+
+            while (index > 0 && getEventInSlot (order[index - 1]).frame > frame)
             {
-                auto h = std::make_unique<OutputStreamOrValueHandler> (*this, endpoint);
-                endpointHandlers.push_back (std::move (h));
+                order[index] = order[index - 1];
+                --index;
             }
+
+            order[index] = slot;
+            return true;
         }
-    }
 
-    //==============================================================================
-    struct EndpointHandler
-    {
-        EndpointHandler() = default;
-        virtual ~EndpointHandler() = default;
+        Event& getEvent (uint32_t index) noexcept    { return getEventInSlot (order[index]); }
+        void clear() noexcept                        { numEvents = 0; }
 
-        virtual void setInputFrames (const void*, uint32_t, uint32_t)           { CMAJ_ASSERT_FALSE; }
-        virtual void setInputValue (const void*, uint32_t)                      { CMAJ_ASSERT_FALSE; }
-        virtual void addInputEvent (uint32_t, const void*)                      { CMAJ_ASSERT_FALSE; }
-        virtual void copyOutputValue (void*)                                    { CMAJ_ASSERT_FALSE; }
-        virtual void copyOutputFrames (void*, uint32_t)                         { CMAJ_ASSERT_FALSE; }
-        virtual void iterateOutputEvents (void*, PerformerInterface::HandleOutputEventCallback)  { CMAJ_ASSERT_FALSE; }
-    };
+        uint32_t numEvents = 0;
 
-    //==============================================================================
-    struct InputStreamHandler  : public EndpointHandler
-    {
-        InputStreamHandler (PerformerBase& p, const EndpointInfo& endpoint) : owner (p)
+    private:
+        uint32_t maxNumEvents = 0;
+        size_t eventStride = 0;
+        std::vector<uint8_t> eventSpace;
+        std::vector<uint32_t> order;
+
+        Event& getEventInSlot (uint32_t slot) noexcept
         {
-            setInputStreamFrames = owner.jit.createSetInputStreamFramesFunction (endpoint);
+            return *reinterpret_cast<Event*> (eventSpace.data() + eventStride * slot);
         }
+    };
 
-        void setInputFrames (const void* frameData, uint32_t numFrames, uint32_t framesForBlock) override
+    PendingEventList pendingEvents;
+
+    void renderBlock()
+    {
+        if (pendingEvents.numEvents != 0)
         {
-            if (numFrames == framesForBlock)
-            {
-                setInputStreamFrames (frameData, numFrames, 0);
-            }
-            else
+            uint32_t currentFrame = 0;
+
+            for (uint32_t i = 0; i < pendingEvents.numEvents; ++i)
             {
-                owner.registerXRun();
+                auto& event = pendingEvents.getEvent (i);
+                auto frame = std::min (event.frame, numFramesToDo);
 
-                if (numFrames > framesForBlock)
-                    numFrames = framesForBlock;
+                if (frame != currentFrame)
+                {
+                    jit.advanceToFrame (frame);
+                    currentFrame = frame;
+                }
 
-                setInputStreamFrames (frameData, numFrames, framesForBlock - numFrames);
+                auto& e = eventDispatchRecords[event.dispatchIndex];
+                e.send (e, event.data);
             }
+
+            pendingEvents.clear();
         }
 
-        PerformerBase& owner;
-        std::function<void(const void*, uint32_t, uint32_t)> setInputStreamFrames;
-    };
+        jit.advance (numFramesToDo);
+    }
 
     //==============================================================================
-    struct InputValueHandler  : public EndpointHandler
+    void initialiseEndpointList (const std::vector<EndpointInfo>& endpoints)
     {
-        InputValueHandler (PerformerBase& owner, const EndpointInfo& endpoint)
-        {
-            setInputValueFn = owner.jit.createSetInputValueFunction (endpoint);
-        }
+        if (endpoints.empty())
+            return;
 
-        void setInputValue (const void* valueData, uint32_t numFramesToReachValue) override
-        {
-            setInputValueFn (valueData, numFramesToReachValue);
-        }
+        firstHandle = endpoints.front().handle;
+        lastHandle = firstHandle;
 
-        std::function<void(const void*, uint32_t)> setInputValueFn;
-        uint32_t dataTypeSize = 0;
-    };
+        dispatchRecords.reserve (endpoints.size());
+        directlyAccessedOutputStreams.reserve (endpoints.size());
 
-    //==============================================================================
-    struct InputEventHandler : public EndpointHandler
-    {
-        InputEventHandler (PerformerBase& owner, const EndpointInfo& endpoint)
+        for (auto& endpoint : endpoints)
         {
-            for (auto& dataType : endpoint.endpoint.dataTypes)
+            CMAJ_ASSERT (endpoint.handle == lastHandle); // handles must be in order
+            ++lastHandle;
+
+            EndpointDispatchRecord d;
+
+            if (endpoint.details.isInput)
             {
-                auto& t = AST::castToRefSkippingReferences<AST::TypeBase> (dataType);
-                std::function<void(const void*)> handler;
+                if (endpoint.details.isEvent())
+                {
+                    d.kind = EndpointDispatchRecord::Kind::inputEvent;
+                    d.firstEventType = static_cast<uint32_t> (eventDispatchRecords.size());
 
-                if (auto handlerFunction = AST::findEventHandlerFunction (endpoint.endpoint, t))
-                    handler = owner.jit.createSendEventFunction (endpoint, t, *handlerFunction);
-                else
-                    handler = [] (const void*) {};
+                    for (auto& dataType : endpoint.endpoint.dataTypes)
+                    {
+                        auto& t = AST::castToRefSkippingReferences<AST::TypeBase> (dataType);
+                        EventDispatchRecord e;
+                        e.dataSize = static_cast<uint32_t> (endpoint.details.dataTypes[d.numEventTypes].getValueDataSize());
+
+                        if (auto handlerFunction = AST::findEventHandlerFunction (endpoint.endpoint, t))
+                            jit.initialiseEventDispatch (e, endpoint, t, *handlerFunction);
 
-                auto type = t.toChocType();
-                auto size = static_cast<uint32_t> (type.getValueDataSize());
+                        eventDispatchRecords.push_back (e);
+                        ++d.numEventTypes;
+                    }
+                }
+                else if (endpoint.details.isStream())
+                {
+                    d.kind = EndpointDispatchRecord::Kind::inputStream;
+                    jit.initialiseInputStreamDispatch (d, endpoint);
+                }
+                else
+                {
+                    d.kind = EndpointDispatchRecord::Kind::inputValue;
+                    jit.initialiseInputValueDispatch (d, endpoint);
+                }
+            }
+            else if (endpoint.details.isEvent())
+            {
+                d.kind = EndpointDispatchRecord::Kind::outputEvent;
+                d.outputEventQueueIndex = static_cast<uint32_t> (outputEventQueues.size());
+                jit.initialiseOutputEventDispatch (d, endpoint);
 
-                typeHandlers.push_back ({ std::move (type), size, std::move (handler) });
+                outputEventQueues.emplace_back().initialise (endpoint.details, eventBufferSize);
+                outputEventEndpoints.push_back (static_cast<uint32_t> (dispatchRecords.size()));
+            }
+            else
+            {
+                d.kind = EndpointDispatchRecord::Kind::outputStreamOrValue;
+                jit.initialiseOutputStreamOrValueDispatch (d, endpoint);
             }
-        }
 
-        void addInputEvent (uint32_t typeIndex, const void* eventData) override
-        {
-            CMAJ_ASSERT (typeIndex < typeHandlers.size());
-            typeHandlers[typeIndex].handler (eventData);
+            dispatchRecords.push_back (d);
         }
-
-        struct TypeHandler
-        {
-            choc::value::Type type;
-            uint32_t dataSize = 0;
-            std::function<void(const void*)> handler;
-        };
-
-        std::vector<TypeHandler> typeHandlers;
-    };
+    }
 
     //==============================================================================
-    struct OutputStreamOrValueHandler  : public EndpointHandler
+    struct OutputEventQueue
     {
-        OutputStreamOrValueHandler (PerformerBase& owner, const EndpointInfo& endpoint)
+        struct Event
         {
-            copyOutputValueFn = owner.jit.createCopyOutputValueFunction (endpoint);
-            isStream = endpoint.details.isStream();
-        }
+            uint32_t frame = 0, type = 0;
+            uint64_t data[1];
+        };
 
-        void copyOutputValue (void* dest) override
+        void initialise (const EndpointDetails& details, uint32_t maxNumEventsToUse)
         {
-            copyOutputValueFn (dest, 1);
+            numEvents = 0;
+            maxNumEvents = maxNumEventsToUse;
+            size_t maxEventDataSize = 0;
+
+            for (auto& t : details.dataTypes)
+            {
+                auto size = t.getValueDataSize();
+                maxEventDataSize = std::max (maxEventDataSize, size);
+                eventSizes.push_back (static_cast<uint32_t> (size));
+            }
+
+            eventStride = ((sizeof (Event) + maxEventDataSize) + 7u) & ~7u;
+            eventSpace.resize (maxNumEvents * eventStride);
         }
 
-        void copyOutputFrames (void* dest, uint32_t numFramesToCopy) override
+        Event& getEvent (size_t index) noexcept
         {
-            copyOutputValueFn (dest, numFramesToCopy);
+            return *reinterpret_cast<Event*> (eventSpace.data() + eventStride * index);
         }
 
-        uint32_t dataTypeSize = 0;
-        bool isStream = false;
+        uint32_t numEvents = 0;
+        uint32_t maxNumEvents = 0;
+
+        std::vector<uint32_t> eventSizes;
 
-        std::function<void(void*, uint32_t)> copyOutputValueFn;
+    private:
+        size_t eventStride = 0;
+        std::vector<uint8_t> eventSpace;
     };
 
-    //==============================================================================
-    struct OutputEventHandler : public EndpointHandler
+    void moveOutputEventsToQueue (const EndpointDispatchRecord& d)
     {
-        OutputEventHandler (PerformerBase& p, const EndpointInfo& endpoint)
-            : owner (p), handle (endpoint.handle)
-        {
-            getNumOutputEvents = owner.jit.createGetNumOutputEventsFunction (endpoint);
-            getEventTypeIndex  = owner.jit.createGetEventTypeIndexFunction (endpoint);
-            readOutputEvent    = owner.jit.createReadOutputEventFunction (endpoint);
-            resetEventCount    = owner.jit.createResetEventCountFunction (endpoint);
+        auto& queue = outputEventQueues[d.outputEventQueueIndex];
 
-            queue.initialise (endpoint.details, owner.eventBufferSize);
-        }
-
-        void iterateOutputEvents (void* context, PerformerInterface::HandleOutputEventCallback handler) override
+        if (auto numEvents = d.getNumOutputEvents (d))
         {
-            auto numEvents = queue.numEvents;
+            if (numEvents > queue.maxNumEvents)
+            {
+                numEvents = queue.maxNumEvents;
+                registerXRun();
+            }
 
             for (uint32_t i = 0; i < numEvents; ++i)
             {
                 auto& event = queue.getEvent (i);
-
-                if (! handler (context, handle, event.type, event.frame, event.data, queue.eventSizes[event.type]))
-                    break;
+                event.frame = d.readOutputEvent (d, i, event.type, event.data);
             }
-        }
 
-        void moveOutputEventsToQueue()
+            queue.numEvents = numEvents;
+            d.resetEventCount (d);
+        }
+        else
         {
-            CMAJ_ASSERT (getNumOutputEvents != nullptr);
+            queue.numEvents = 0;
+        }
+    }
 
-            if (auto numEvents = getNumOutputEvents())
-            {
-                if (numEvents > queue.maxNumEvents)
-                {
-                    numEvents = queue.maxNumEvents;
-                    owner.registerXRun();
-                }
+    //==============================================================================
+    std::vector<EndpointDispatchRecord> dispatchRecords;
+    std::vector<EventDispatchRecord> eventDispatchRecords;
+    std::vector<OutputEventQueue> outputEventQueues;
+    std::vector<uint32_t> outputEventEndpoints, directlyAccessedOutputStreams;
+    uint32_t firstHandle = 0, lastHandle = 0;
 
-                for (uint32_t i = 0; i < numEvents; ++i)
-                {
-                    auto& event = queue.getEvent (i);
-                    event.type  = getEventTypeIndex (i);
-                    event.frame = readOutputEvent (i, event.data);
-                }
+    const EndpointDispatchRecord& getDispatchRecord (EndpointHandle handle) const
+    {
+        CMAJ_ASSERT (handle >= firstHandle && handle < lastHandle);
+        return dispatchRecords[handle - firstHandle];
+    }
+};
 
-                queue.numEvents = numEvents;
-                resetEventCount();
-            }
-            else
-            {
-                queue.numEvents = 0;
-            }
-        }
 
-        struct OutputEventQueue
-        {
-            struct Event
-            {
-                uint32_t frame = 0, type = 0;
-                uint64_t data[1];
-            };
+//==============================================================================
+/// A basic PerformerPoolInterface implementation which holds a list of performers.
+/// Back-ends which can share memory between instances create their performers
+/// with that in mind before adding them; others can use createPoolOfSeparatePerformers().
+template <typename PerformerType>
+struct BasicPerformerPool  : public choc::com::ObjectWithAtomicRefCount<cmaj::PerformerPoolInterface, BasicPerformerPool<PerformerType>>
+{
+    BasicPerformerPool() = default;
+    virtual ~BasicPerformerPool() = default;
 
-            void initialise (const EndpointDetails& details, uint32_t maxNumEventsToUse)
-            {
-                numEvents = 0;
-                maxNumEvents = maxNumEventsToUse;
-                size_t maxEventDataSize = 0;
+    void add (choc::com::Ptr<PerformerType> p)
+    {
+        instances.push_back (std::move (p));
+    }
 
-                for (auto& t : details.dataTypes)
-                {
-                    auto size = t.getValueDataSize();
-                    maxEventDataSize = std::max (maxEventDataSize, size);
-                    eventSizes.push_back (static_cast<uint32_t> (size));
-                }
+    uint32_t getNumInstances() override
+    {
+        return static_cast<uint32_t> (instances.size());
+    }
 
-                eventStride = ((sizeof (Event) + maxEventDataSize) + 7u) & ~7u;
-                eventSpace.resize (maxNumEvents * eventStride);
-            }
+    PerformerInterface* getPerformer (uint32_t index) override
+    {
+        if (index < instances.size())
+            return instances[index].getWithIncrementedRefCount();
 
-            Event& getEvent (size_t index) noexcept
-            {
-                return *reinterpret_cast<Event*> (eventSpace.data() + eventStride * index);
-            }
+        return {};
+    }
 
-            uint32_t numEvents = 0;
-            uint32_t maxNumEvents = 0;
+    void setBlockSize (uint32_t numFramesForNextBlock) override
+    {
+        for (auto& p : instances)
+            p->setBlockSize (numFramesForNextBlock);
+    }
 
-            std::vector<uint32_t> eventSizes;
+    void advance() override
+    {
+        for (auto& p : instances)
+            p->advance();
+    }
 
-        private:
-            size_t eventStride = 0;
-            std::vector<uint8_t> eventSpace;
-        };
+private:
+    std::vector<choc::com::Ptr<PerformerType>> instances;
+};
 
-        PerformerBase& owner;
-        EndpointHandle handle;
-        OutputEventQueue queue;
+template <typename Implementation, typename LinkedCode>
+PerformerPoolInterface* createPoolOfSeparatePerformers (Implementation& implementation, std::shared_ptr<LinkedCode> code, uint32_t numInstances)
+{
+    auto pool = choc::com::create<BasicPerformerPool<PerformerInterface>>();
 
-        std::function<uint32_t()>                 getNumOutputEvents;
-        std::function<uint32_t(uint32_t)>         getEventTypeIndex;
-        std::function<uint32_t(uint32_t, void*)>  readOutputEvent;
-        std::function<void()>                     resetEventCount;
-    };
+    for (uint32_t i = 0; i < numInstances; ++i)
+    {
+        auto performer = PerformerPtr (implementation.createPerformer (code));
 
-    //==============================================================================
-    std::vector<std::unique_ptr<EndpointHandler>> endpointHandlers;
-    uint32_t firstHandle = 0, lastHandle = 0;
-    std::vector<OutputEventHandler*> outputEventHandlers;
+        if (performer.get() == nullptr)
+            return {};
 
-    EndpointHandler& getEndpointHandler (EndpointHandle handle)
-    {
-        CMAJ_ASSERT (handle >= firstHandle && handle < lastHandle);
-        return *endpointHandlers[handle - firstHandle];
+        pool->add (std::move (performer));
     }
-};
+
+    return pool.getWithIncrementedRefCount();
+}
 
 }
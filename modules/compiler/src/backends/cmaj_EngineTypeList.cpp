@@ -92,6 +92,8 @@ struct DummyEngineFactory  : public choc::com::ObjectWithAtomicRefCount<EngineFa
         static constexpr bool usesDynamicRateAndSessionID = true;
         static constexpr bool allowTopLevelSlices = false;
         static constexpr bool supportsExternalFunctions = true;
+        static constexpr bool supportsNodeProfiling = false;
+        static constexpr bool canReferenceExternalData = false;
         static bool engineSupportsIntrinsic (AST::Intrinsic::Type) { return true; }
 
         static std::string getEngineVersion()   { return "dummy"; }
@@ -100,6 +102,7 @@ struct DummyEngineFactory  : public choc::com::ObjectWithAtomicRefCount<EngineFa
         struct JITInstance { JITInstance (std::shared_ptr<LinkedCode>, int32_t, double) {} };
 
         PerformerInterface* createPerformer (std::shared_ptr<LinkedCode>) { return {}; }
+        PerformerPoolInterface* createPerformerPool (std::shared_ptr<LinkedCode>, uint32_t) { return {}; }
     };
 
     const char* getName() override      { return "dummy"; }
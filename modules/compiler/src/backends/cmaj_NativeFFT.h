@@ -0,0 +1,204 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace cmaj
+{
+
+//==============================================================================
+/// Native implementations of the complexFFT() and complexIFFT() intrinsics.
+///
+/// These work in-place on interleaved real/imaginary pairs, which is how an array of
+/// complex values is laid out once its elements have been converted to structs. The
+/// caller passes in a table of twiddle factors created with getTwiddleFactor(), which
+/// the LLVM back-end emits as a constant for each FFT size that a program uses.
+///
+/// The transform is an iterative radix-4 decimation-in-time, with a single radix-2
+/// pass first when the size is an odd power of 2. Its inner loops are written so that
+/// the compiler can vectorise them for whichever CPU the engine has been built for.
+struct NativeFFT
+{
+    /// Returns the number of complex values needed in the twiddle table for an FFT
+    static constexpr uint32_t getTwiddleTableSize (uint32_t fftSize)   { return fftSize < 4 ? 1 : (fftSize / 4) * 3; }
+
+    /// Returns the forward twiddle factor exp (-2 * pi * i * index / fftSize)
+    static std::complex<double> getTwiddleFactor (uint32_t index, uint32_t fftSize)
+    {
+        auto angle = -2.0 * 3.141592653589793238 * static_cast<double> (index) / static_cast<double> (fftSize);
+        return { std::cos (angle), std::sin (angle) };
+    }
+
+    /// Returns the symbol name that generated code should use to call one of these functions
+    static std::string getFunctionName (bool is64Bit, bool inverse)
+    {
+        return std::string ("_cmaj_") + (inverse ? "inverse" : "forward") + "FFT" + (is64Bit ? "64" : "32");
+    }
+
+    /// Returns the functions that a JIT needs to be able to link to, keyed by getFunctionName()
+    static const std::unordered_map<std::string, void*>& getFunctionSymbols()
+    {
+        static const std::unordered_map<std::string, void*> symbols
+        {
+            { getFunctionName (false, false), (void*) forwardFFT32 },
+            { getFunctionName (false, true),  (void*) inverseFFT32 },
+            { getFunctionName (true,  false), (void*) forwardFFT64 },
+            { getFunctionName (true,  true),  (void*) inverseFFT64 }
+        };
+
+        return symbols;
+    }
+
+    static void forwardFFT32 (float*  data, int32_t size, const float*  twiddles)   { perform (data, static_cast<uint32_t> (size), twiddles, false); }
+    static void inverseFFT32 (float*  data, int32_t size, const float*  twiddles)   { perform (data, static_cast<uint32_t> (size), twiddles, true); }
+    static void forwardFFT64 (double* data, int32_t size, const double* twiddles)   { perform (data, static_cast<uint32_t> (size), twiddles, false); }
+    static void inverseFFT64 (double* data, int32_t size, const double* twiddles)   { perform (data, static_cast<uint32_t> (size), twiddles, true); }
+
+    //==============================================================================
+    template <typename FloatType>
+    static void perform (FloatType* data, uint32_t size, const FloatType* twiddles, bool inverse)
+    {
+        if (size < 2)
+            return;
+
+        reorderBitReversed (data, size);
+
+        uint32_t length = 1;
+
+        if (! isPowerOf4 (size))
+        {
+            performRadix2Pass (data, size);
+            length = 2;
+        }
+
+        for (length *= 4; length <= size; length *= 4)
+        {
+            if (inverse)
+                performRadix4Pass<FloatType, true> (data, size, length, twiddles);
+            else
+                performRadix4Pass<FloatType, false> (data, size, length, twiddles);
+        }
+
+        if (inverse)
+        {
+            auto scale = static_cast<FloatType> (1) / static_cast<FloatType> (size);
+
+            for (uint32_t i = 0; i < size * 2; ++i)
+                data[i] *= scale;
+        }
+    }
+
+private:
+    static constexpr bool isPowerOf4 (uint32_t size)    { return (size & 0x55555555u) != 0; }
+
+    template <typename FloatType>
+    static void reorderBitReversed (FloatType* data, uint32_t size)
+    {
+        for (uint32_t i = 1, j = 0; i < size; ++i)
+        {
+            auto bit = size >> 1;
+
+            for (; (j & bit) != 0; bit >>= 1)
+                j ^= bit;
+
+            j ^= bit;
+
+            if (i < j)
+            {
+                std::swap (data[i * 2],     data[j * 2]);
+                std::swap (data[i * 2 + 1], data[j * 2 + 1]);
+            }
+        }
+    }
+
+    template <typename FloatType>
+    static void performRadix2Pass (FloatType* data, uint32_t size)
+    {
+        for (uint32_t i = 0; i < size * 2; i += 4)
+        {
+            auto r0 = data[i],     i0 = data[i + 1];
+            auto r1 = data[i + 2], i1 = data[i + 3];
+
+            data[i]     = r0 + r1;
+            data[i + 1] = i0 + i1;
+            data[i + 2] = r0 - r1;
+            data[i + 3] = i0 - i1;
+        }
+    }
+
+    /// Combines each group of four consecutive sub-transforms of length / 4 into one of the
+    /// given length. Because the input was bit-reversed, the quarters hold the transforms of
+    /// the elements whose indexes are 0, 2, 1 and 3 (mod 4) respectively.
+    template <typename FloatType, bool inverse>
+    static void performRadix4Pass (FloatType* data, uint32_t size, uint32_t length, const FloatType* twiddles)
+    {
+        constexpr FloatType sign = inverse ? -1 : 1;
+        auto quarter = length / 4;
+        auto stride = size / length;
+
+        for (uint32_t start = 0; start < size; start += length)
+        {
+            auto a = data + start * 2;
+            auto b = a + quarter * 2;
+            auto c = b + quarter * 2;
+            auto d = c + quarter * 2;
+
+            for (uint32_t k = 0; k < quarter; ++k)
+            {
+                auto w1 = twiddles + (k * stride) * 2;
+                auto w2 = twiddles + (k * stride * 2) * 2;
+                auto w3 = twiddles + (k * stride * 3) * 2;
+
+                auto w1r = w1[0], w1i = sign * w1[1];
+                auto w2r = w2[0], w2i = sign * w2[1];
+                auto w3r = w3[0], w3i = sign * w3[1];
+
+                auto ar = a[k * 2], ai = a[k * 2 + 1];
+                auto br = b[k * 2], bi = b[k * 2 + 1];
+                auto cr = c[k * 2], ci = c[k * 2 + 1];
+                auto dr = d[k * 2], di = d[k * 2 + 1];
+
+                auto t1r = cr * w1r - ci * w1i,  t1i = cr * w1i + ci * w1r;
+                auto t2r = br * w2r - bi * w2i,  t2i = br * w2i + bi * w2r;
+                auto t3r = dr * w3r - di * w3i,  t3i = dr * w3i + di * w3r;
+
+                auto sum02r  = ar + t2r,   sum02i  = ai + t2i;
+                auto diff02r = ar - t2r,   diff02i = ai - t2i;
+                auto sum13r  = t1r + t3r,  sum13i  = t1i + t3i;
+                auto diff13r = t1r - t3r,  diff13i = t1i - t3i;
+
+                a[k * 2]     = sum02r + sum13r;
+                a[k * 2 + 1] = sum02i + sum13i;
+                b[k * 2]     = diff02r + sign * diff13i;
+                b[k * 2 + 1] = diff02i - sign * diff13r;
+                c[k * 2]     = sum02r - sum13r;
+                c[k * 2 + 1] = sum02i - sum13i;
+                d[k * 2]     = diff02r - sign * diff13i;
+                d[k * 2 + 1] = diff02i + sign * diff13r;
+            }
+        }
+    }
+};
+
+}
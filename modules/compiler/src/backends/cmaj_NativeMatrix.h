@@ -0,0 +1,140 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+namespace cmaj
+{
+
+//==============================================================================
+/// Native implementations of the matrixVectorMultiply(), matrixVectorMultiplyAdd(),
+/// tanh() and sigmoid() intrinsics, which are what dense and recurrent neural-network
+/// layers spend most of their time in.
+///
+/// The matrix is passed as a pointer to its first row plus a row stride, so that rows
+/// which are padded vectors can be used without copying. Each dot-product is split
+/// across a set of independent accumulators, and the activations are branch-free, so
+/// that the compiler can vectorise the loops for whichever CPU the engine is built for.
+struct NativeMatrix
+{
+    /// Returns the symbol name that generated code should use to call a matrix-vector multiply
+    static std::string getMatrixVectorMultiplyFunctionName (bool is64Bit)
+    {
+        return std::string ("_cmaj_matrixVectorMultiply") + (is64Bit ? "64" : "32");
+    }
+
+    /// Returns the symbol name that generated code should use to call one of the in-place activations
+    static std::string getActivationFunctionName (bool is64Bit, bool isSigmoid)
+    {
+        return std::string ("_cmaj_") + (isSigmoid ? "sigmoid" : "tanh") + (is64Bit ? "64" : "32");
+    }
+
+    /// Returns the functions that a JIT needs to be able to link to
+    static const std::unordered_map<std::string, void*>& getFunctionSymbols()
+    {
+        static const std::unordered_map<std::string, void*> symbols
+        {
+            { getMatrixVectorMultiplyFunctionName (false), (void*) matrixVectorMultiply32 },
+            { getMatrixVectorMultiplyFunctionName (true),  (void*) matrixVectorMultiply64 },
+            { getActivationFunctionName (false, false),    (void*) tanh32 },
+            { getActivationFunctionName (false, true),     (void*) sigmoid32 },
+            { getActivationFunctionName (true,  false),    (void*) tanh64 },
+            { getActivationFunctionName (true,  true),     (void*) sigmoid64 }
+        };
+
+        return symbols;
+    }
+
+    /// Calculates output[row] = bias[row] + sum (matrix[row * rowStride + column] * input[column]).
+    /// The bias may be null, or may be the same pointer as the output, but the output must
+    /// not overlap the input or the matrix.
+    static void matrixVectorMultiply32 (const float* matrix, int32_t rowStride, int32_t numRows, int32_t numColumns,
+                                        const float* input, const float* bias, float* output)
+    {
+        multiply (matrix, rowStride, numRows, numColumns, input, bias, output);
+    }
+
+    static void matrixVectorMultiply64 (const double* matrix, int32_t rowStride, int32_t numRows, int32_t numColumns,
+                                        const double* input, const double* bias, double* output)
+    {
+        multiply (matrix, rowStride, numRows, numColumns, input, bias, output);
+    }
+
+    static void tanh32    (float*  data, int32_t size)    { for (int32_t i = 0; i < size; ++i) data[i] = fastTanh (data[i]); }
+    static void sigmoid32 (float*  data, int32_t size)    { for (int32_t i = 0; i < size; ++i) data[i] = 0.5f * fastTanh (0.5f * data[i]) + 0.5f; }
+    static void tanh64    (double* data, int32_t size)    { for (int32_t i = 0; i < size; ++i) data[i] = std::tanh (data[i]); }
+    static void sigmoid64 (double* data, int32_t size)    { for (int32_t i = 0; i < size; ++i) data[i] = 1.0 / (1.0 + std::exp (-data[i])); }
+
+    //==============================================================================
+    template <typename FloatType>
+    static void multiply (const FloatType* matrix, int32_t rowStride, int32_t numRows, int32_t numColumns,
+                          const FloatType* input, const FloatType* bias, FloatType* output)
+    {
+        constexpr int32_t numLanes = 8;
+        auto numWholeColumns = numColumns - (numColumns % numLanes);
+
+        for (int32_t row = 0; row < numRows; ++row)
+        {
+            auto rowData = matrix + row * rowStride;
+            FloatType lanes[numLanes] = {};
+
+            for (int32_t column = 0; column < numWholeColumns; column += numLanes)
+                for (int32_t lane = 0; lane < numLanes; ++lane)
+                    lanes[lane] += rowData[column + lane] * input[column + lane];
+
+            auto total = bias != nullptr ? bias[row] : FloatType();
+
+            for (int32_t column = numWholeColumns; column < numColumns; ++column)
+                total += rowData[column] * input[column];
+
+            for (auto lane : lanes)
+                total += lane;
+
+            output[row] = total;
+        }
+    }
+
+    /// The float32 rational approximation of tanh that Eigen and RTNeural use
+    static float fastTanh (float v)
+    {
+        auto x = v < -7.99881172180175781f ? -7.99881172180175781f
+                                           : (v > 7.90531110763549805f ? 7.90531110763549805f : v);
+        auto x2 = x * x;
+
+        auto p = x2 * -2.76076847742355e-16f + 2.00018790482477e-13f;
+        p = x2 * p + -8.60467152213735e-11f;
+        p = x2 * p + 5.12229709037114e-08f;
+        p = x2 * p + 1.48572235717979e-05f;
+        p = x2 * p + 6.37261928875436e-04f;
+        p = x2 * p + 4.89352455891786e-03f;
+        p = x * p;
+
+        auto q = x2 * 1.19825839466702e-06f + 1.18534705686654e-04f;
+        q = x2 * q + 2.26843463243900e-03f;
+        q = x2 * q + 4.89352518554385e-03f;
+
+        return std::abs (v) < 0.0004f ? x : p / q;
+    }
+};
+
+} // namespace cmaj
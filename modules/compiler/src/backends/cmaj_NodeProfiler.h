@@ -0,0 +1,100 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+
+#pragma once
+
+#include "../../../../include/cmajor/COM/cmaj_PerformerInterface.h"
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if (defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86)))
+ #include <intrin.h>
+#elif (defined (__x86_64__) || defined (__i386__))
+ #include <x86intrin.h>
+#endif
+
+namespace cmaj
+{
+
+//==============================================================================
+/// Collects the per-node timings for a performer whose program was built with the
+/// "profileNodes" build setting.
+///
+/// The flattened graph brackets each node's run call with calls to two external
+/// functions, which the back-end binds to nodeStarted() and nodeFinished(). These
+/// have no context argument, so they find the profiler through a thread-local
+/// pointer that the performer sets for the duration of each advance() call.
+struct NodeProfiler
+{
+    NodeProfiler (size_t numNodes) : counters (numNodes, NodeProfileCounter {}) {}
+
+    void reset()
+    {
+        std::fill (counters.begin(), counters.end(), NodeProfileCounter {});
+    }
+
+    /// Makes this the active profiler for the calling thread, restoring the
+    /// previous one when it goes out of scope.
+    struct ScopedActivation
+    {
+        ScopedActivation (NodeProfiler& p) : previous (current)   { current = std::addressof (p); }
+        ~ScopedActivation()                                       { current = previous; }
+
+        NodeProfiler* previous;
+    };
+
+    static void nodeStarted (int32_t)
+    {
+        if (auto p = current)
+            p->startTime = readCycleCounter();
+    }
+
+    static void nodeFinished (int32_t nodeIndex)
+    {
+        if (auto p = current)
+        {
+            auto& c = p->counters[static_cast<size_t> (nodeIndex)];
+            c.totalCycles += readCycleCounter() - p->startTime;
+            ++c.numCalls;
+        }
+    }
+
+    /// Reads the CPU's timestamp counter where there's a cheap way to do that, or
+    /// falls back to a nanosecond clock on other platforms.
+    static uint64_t readCycleCounter()
+    {
+       #if (defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))) || defined (__x86_64__) || defined (__i386__)
+        return static_cast<uint64_t> (__rdtsc());
+       #elif defined (__aarch64__) && ! defined (_MSC_VER)
+        uint64_t t;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (t));
+        return t;
+       #else
+        return static_cast<uint64_t> (std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now().time_since_epoch()).count());
+       #endif
+    }
+
+    std::vector<NodeProfileCounter> counters;
+    uint64_t startTime = 0;
+
+    static inline thread_local NodeProfiler* current = nullptr;
+};
+
+}
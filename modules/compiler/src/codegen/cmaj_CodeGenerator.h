@@ -56,7 +56,14 @@ struct CodeGenerator
             ValueReader initialValue = {};
 
             if (! v->isInitialisedInInit && v->isCompileTimeConstant() && v->initialValue != nullptr)
-                initialValue = createValueReader (*AST::getAsFoldedConstant (v->initialValue));
+            {
+                auto& value = *AST::getAsFoldedConstant (v->initialValue);
+
+                if (builder.addGlobalConstantData (*v, *v->getType(), value))
+                    continue;
+
+                initialValue = createValueReader (value);
+            }
 
             builder.addGlobalVariable (*v, *v->getType(), globalVariableNames.getName (*v), std::move (initialValue));
         }
@@ -525,7 +532,7 @@ private:
         auto oldLoop = currentLoop;
         currentLoop = loop;
 
-        auto status = builder.beginLoop();
+        auto status = builder.beginLoop (loop.hasIndependentIterations);
         auto& loopBody = AST::castToRef<AST::ScopeBlock> (loop.body);
 
         if (containsContinueStatement (loop))
@@ -1431,7 +1438,7 @@ private:
             auto indexVar = createTempVariableReference (context.allocator.int32Type, {}, true, "_index");
 
             auto& loop = context.allocate<AST::LoopStatement>();
-            auto loopStatus = builder.beginLoop();
+            auto loopStatus = builder.beginLoop (false);
             auto oldLoop = currentLoop;
             currentLoop = loop;
 
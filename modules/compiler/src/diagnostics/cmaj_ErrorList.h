@@ -87,6 +87,7 @@ DECL_COMPILE_ERROR (namespaceMustBeInsideNamespace,         "A namespace can onl
 DECL_COMPILE_ERROR (processorMustBeInsideNamespace,         "A processor can only be defined inside a namespace")
 DECL_COMPILE_ERROR (graphMustBeInsideNamespace,             "A graph can only be defined inside a namespace")
 DECL_COMPILE_ERROR (graphCannotContainMainOrInitFunctions,  "The main() and init() functions may only be declared inside a processor")
+DECL_COMPILE_ERROR (graphCannotContainIdleFunction,         "The isIdle() function may only be declared inside a processor")
 DECL_COMPILE_ERROR (onlyMemberFunctionsCanBeConst,          "Only struct member functions can be declared `const`")
 DECL_COMPILE_ERROR (namespaceCannotContainEndpoints,        "A namespace cannot contain endpoint declarations")
 DECL_COMPILE_ERROR (importsMustBeAtStart,                   "Import statements can only be declared at the start of a namespace")
@@ -207,6 +208,7 @@ DECL_COMPILE_ERROR (tooManyParameters,                      "Too many function p
 DECL_COMPILE_ERROR (duplicateFunction,                      "A function with matching parameters has already been defined")
 DECL_COMPILE_ERROR (functionHasParams,                      "The {0}() function must not have any parameters")
 DECL_COMPILE_ERROR (functionMustBeVoid,                     "The {0}() function must return 'void'")
+DECL_COMPILE_ERROR (functionMustReturnBool,                 "The {0}() function must return 'bool'")
 DECL_COMPILE_ERROR (cannotCallFunction,                     "The {0}() function cannot be called from user code")
 DECL_COMPILE_ERROR (cannotResolveFunctionOrCast,            "Could not resolve function or cast")
 DECL_COMPILE_ERROR (voidFunctionCannotReturnValue,          "A void function cannot return a value")
@@ -317,6 +319,7 @@ DECL_COMPILE_ERROR (advanceIsNotAMethod,                    "The advance() funct
 DECL_COMPILE_ERROR (advanceHasNoArgs,                       "The advance() function does not take any arguments")
 DECL_COMPILE_ERROR (invalidAdvanceArgumentType,             "The advance() function argument must be a node type")
 DECL_COMPILE_ERROR (advanceCannotBeCalledHere,              "The advance() function cannot be called inside this function")
+DECL_COMPILE_ERROR (idleFunctionCannotWriteOutputs,         "The isIdle() function cannot write to output endpoints")
 DECL_COMPILE_ERROR (resetWrongArguments,                    "The reset() function does not take any arguments")
 DECL_COMPILE_ERROR (paramCannotContainSlice,                "functions that call advance() do not support parameters containing slices")
 DECL_COMPILE_ERROR (endpointsCanOnlyBeUsedInMain,           "Endpoints can only be read or written by code that is called from the main() function")
@@ -128,6 +128,10 @@ namespace cmaj::passes
     {
         PassType pass (program);
         pass.throwOnErrors = throwOnErrors;
+
+        for (auto& m : program.resolvedModules.getUnmodifiedModules())
+            pass.skipObject (m);
+
         pass.visitObject (program.rootNamespace);
 
         return { pass.numReplaced, pass.numFailures };
@@ -95,6 +95,7 @@ inline void addFallbackIntrinsics (AST::Program& program,
                             case AST::Intrinsic::Type::sinh:
                             case AST::Intrinsic::Type::cosh:
                             case AST::Intrinsic::Type::tanh:
+                            case AST::Intrinsic::Type::sigmoid:
                             case AST::Intrinsic::Type::asinh:
                             case AST::Intrinsic::Type::acosh:
                             case AST::Intrinsic::Type::atanh:
@@ -102,6 +103,10 @@ inline void addFallbackIntrinsics (AST::Program& program,
                             case AST::Intrinsic::Type::acos:
                             case AST::Intrinsic::Type::atan:
                             case AST::Intrinsic::Type::atan2:
+                            case AST::Intrinsic::Type::complexFFT:
+                            case AST::Intrinsic::Type::complexIFFT:
+                            case AST::Intrinsic::Type::matrixVectorMultiply:
+                            case AST::Intrinsic::Type::matrixVectorMultiplyAdd:
                             case AST::Intrinsic::Type::unknown:
                             default:
                                 break;
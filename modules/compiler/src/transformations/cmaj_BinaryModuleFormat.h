@@ -632,5 +632,250 @@ bool isValidBinaryModuleData (const void* data, size_t size)
     return reader.readHeaderAndHash (true);
 }
 
+//==============================================================================
+/// Copies a set of modules into another allocator, producing the same result as
+/// writing them to a binary module and reading that back, but without having to
+/// encode and decode all the data.
+struct ModuleCloner
+{
+    ModuleCloner (AST::Allocator& a, ModuleCloneOrder* orderToRecord, const ModuleCloneOrder* orderToReplay)
+        : allocator (a), recordedOrder (orderToRecord), replayedOrder (orderToReplay)
+    {
+        objectsToCopy.reserve (numObjectsToReserve);
+    }
+
+    AST::ObjectRefVector<AST::ModuleBase> clone (const AST::ObjectRefVector<AST::ModuleBase>& sourceModules)
+    {
+        AST::ObjectRefVector<AST::ModuleBase> results;
+
+        for (auto& m : sourceModules)
+            results.push_back (AST::castToRef<AST::ModuleBase> (getClone (m.get(), true)));
+
+        // NB: this is deliberately not a range-based-for because
+        // the vector will grow during the loop
+        for (size_t i = 0; i < objectsToCopy.size(); ++i)
+            copyProperties (objectsToCopy[i].source, objectsToCopy[i].clone);
+
+        CMAJ_ASSERT (replayedOrder == nullptr || nextReplayedIndex == replayedOrder->indexes.size());
+        return results;
+    }
+
+    AST::Object& getClone (const AST::Object& source, bool isMainObject)
+    {
+        auto index = getIndex (objectIndexes, std::addressof (source), objectsToCopy.size());
+
+        if (index < objectsToCopy.size())
+            return objectsToCopy[index].clone;
+
+        AST::ObjectContext context { allocator, {}, nullptr };
+        auto newObject = AST::createObjectOfClassType (context, source.getObjectClassID());
+        CMAJ_ASSERT (newObject != nullptr && index == objectsToCopy.size());
+
+        objectsToCopy.push_back ({ source, *newObject });
+
+        // A parent may not be reachable through any property, so it has to be cloned
+        // here rather than after the copying has finished
+        if (! isMainObject)
+            if (auto parent = source.context.parentScope.get())
+                newObject->setParentScope (getClone (*parent, false));
+
+        return *newObject;
+    }
+
+    AST::PooledString getClone (AST::PooledString source, AST::StringPool& pool)
+    {
+        auto index = getIndex (stringIndexes, source.get().data(), clonedStrings.size());
+
+        if (index < clonedStrings.size())
+            return clonedStrings[index];
+
+        // strings must be re-pooled, because pooled strings are compared by address
+        CMAJ_ASSERT (index == clonedStrings.size());
+        clonedStrings.push_back (pool.get (source.get()));
+        return clonedStrings.back();
+    }
+
+    void copyProperties (const AST::Object& source, AST::Object& dest)
+    {
+        // the clone is the same class as the source, so its properties are in the same order
+        auto destProperties = dest.getPropertyList();
+        CMAJ_ASSERT (destProperties.size() == source.getNumProperties());
+
+        for (uint32_t i = 0; i < destProperties.size(); ++i)
+        {
+            auto sourceProperty = source.findPropertyForID (source.getPropertyID (i));
+            CMAJ_ASSERT (sourceProperty != nullptr);
+
+            if (! sourceProperty->hasDefaultValue())
+                copyProperty (destProperties[i], *sourceProperty);
+        }
+    }
+
+    void copyProperty (AST::Property& dest, const AST::Property& source)
+    {
+        if (auto p = source.getAsIntegerProperty())
+        {
+            dest.getAsIntegerProperty()->set (p->get());
+            return;
+        }
+
+        if (auto p = source.getAsFloatProperty())
+        {
+            dest.getAsFloatProperty()->set (p->get());
+            return;
+        }
+
+        if (auto p = source.getAsBoolProperty())
+        {
+            dest.getAsBoolProperty()->set (p->get());
+            return;
+        }
+
+        if (auto p = source.getAsStringProperty())
+        {
+            if (auto s = p->get(); ! s.empty())
+                dest.getAsStringProperty()->set (getClone (s, dest.getStringPool()));
+
+            return;
+        }
+
+        if (auto p = source.getAsEnumProperty())
+        {
+            dest.getAsEnumProperty()->setID (p->getID());
+            return;
+        }
+
+        if (auto p = source.getAsObjectProperty())
+        {
+            if (auto o = p->getRawPointer())
+                dest.getAsObjectProperty()->referToUnchecked (getClone (*o, false));
+
+            return;
+        }
+
+        if (auto p = source.getAsListProperty())
+        {
+            auto& list = *dest.getAsListProperty();
+            list.reserve (p->size());
+
+            for (auto& item : *p)
+            {
+                auto& property = BinaryModuleReader::createPropertyOfType (dest.owner, item->getPropertyTypeID());
+                list.add (property);
+                copyProperty (property, item);
+            }
+
+            return;
+        }
+
+        CMAJ_ASSERT_FALSE;
+    }
+
+    struct ObjectToCopy
+    {
+        const AST::Object& source;
+        AST::Object& clone;
+    };
+
+    /// Every object and string in the source is looked up at least once per reference, and
+    /// for the size of the standard library this open-addressed table is several times
+    /// quicker than a std::unordered_map. It maps addresses to (index + 1), so 0 means unused.
+    struct AddressMap
+    {
+        uint32_t& getOrCreate (const void* key)
+        {
+            if (numUsed * 2 >= slots.size())
+                grow();
+
+            auto& slot = findSlot (slots, key);
+
+            if (slot.key == nullptr)
+            {
+                slot.key = key;
+                ++numUsed;
+            }
+
+            return slot.value;
+        }
+
+    private:
+        struct Slot
+        {
+            const void* key = nullptr;
+            uint32_t value = 0;
+        };
+
+        std::vector<Slot> slots;
+        size_t numUsed = 0;
+
+        static Slot& findSlot (std::vector<Slot>& table, const void* key)
+        {
+            auto mask = table.size() - 1;
+            auto i = static_cast<size_t> ((reinterpret_cast<uintptr_t> (key) >> 3) * 0x9e3779b97f4a7c15ull) & mask;
+
+            while (table[i].key != nullptr && table[i].key != key)
+                i = (i + 1) & mask;
+
+            return table[i];
+        }
+
+        void grow()
+        {
+            std::vector<Slot> newSlots (std::max (slots.size() * 2, numObjectsToReserve));
+
+            for (auto& slot : slots)
+                if (slot.key != nullptr)
+                    findSlot (newSlots, slot.key) = slot;
+
+            slots = std::move (newSlots);
+        }
+    };
+
+    /// Returns the index of the clone of a source object or string, which will be the next new
+    /// index if it hasn't been cloned yet. When replaying, these indexes come from the recorded
+    /// order, so nothing needs to be looked up.
+    uint32_t getIndex (AddressMap& indexes, const void* source, size_t numCloned)
+    {
+        if (replayedOrder != nullptr)
+        {
+            CMAJ_ASSERT (nextReplayedIndex < replayedOrder->indexes.size());
+            return replayedOrder->indexes[nextReplayedIndex++];
+        }
+
+        auto& indexPlusOne = indexes.getOrCreate (source);
+
+        if (indexPlusOne == 0)
+            indexPlusOne = static_cast<uint32_t> (numCloned + 1);
+
+        if (recordedOrder != nullptr)
+            recordedOrder->indexes.push_back (indexPlusOne - 1);
+
+        return indexPlusOne - 1;
+    }
+
+    AST::Allocator& allocator;
+    ModuleCloneOrder* recordedOrder;
+    const ModuleCloneOrder* replayedOrder;
+    size_t nextReplayedIndex = 0;
+    AddressMap objectIndexes, stringIndexes;
+    std::vector<ObjectToCopy> objectsToCopy;
+    std::vector<AST::PooledString> clonedStrings;
+};
+
+AST::ObjectRefVector<AST::ModuleBase> cloneModules (AST::Allocator& allocator, const AST::ObjectRefVector<AST::ModuleBase>& sourceModules,
+                                                    const ModuleCloneOrder* order)
+{
+    ModuleCloner cloner (allocator, nullptr, order);
+    return cloner.clone (sourceModules);
+}
+
+ModuleCloneOrder getModuleCloneOrder (const AST::ObjectRefVector<AST::ModuleBase>& sourceModules)
+{
+    ModuleCloneOrder order;
+    AST::Allocator scratchAllocator;
+    ModuleCloner cloner (scratchAllocator, std::addressof (order), nullptr);
+    cloner.clone (sourceModules);
+    return order;
+}
 
 } // namespace cmaj::transformations
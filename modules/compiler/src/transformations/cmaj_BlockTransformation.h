@@ -183,22 +183,23 @@ inline AST::ProcessorBase& createBlockTransformProcessor (AST::ProcessorBase& or
                                                               frequencyParam));
     }
 
-    // _advance function definition
+    // _advanceTo function definition: this renders the frames from the current position
+    // up to the given frame, so that a caller can deliver events part-way through a block
+    // by calling it once for each section, with the same io data
+    auto& advanceTo = AST::createExportedFunction (blockProcessor,
+                                                   blockProcessor.context.allocator.voidType,
+                                                   blockProcessor.getStrings().systemAdvanceToFunctionName);
     {
-        auto& advance = AST::createExportedFunction (blockProcessor,
-                                                     blockProcessor.context.allocator.voidType,
-                                                     blockProcessor.getStrings().systemAdvanceFunctionName);
+        auto stateParam  = AST::addFunctionParameter (advanceTo, stateType, advanceTo.getStrings()._state, true, false);
+        auto ioParam     = AST::addFunctionParameter (advanceTo, ioType,    advanceTo.getStrings()._io, true, false);
+        auto framesParam = AST::addFunctionParameter (advanceTo, blockProcessor.context.allocator.int32Type, advanceTo.getStrings()._frames, false, false);
 
-        auto stateParam  = AST::addFunctionParameter (advance, stateType, advance.getStrings()._state, true, false);
-        auto ioParam     = AST::addFunctionParameter (advance, ioType,    advance.getStrings()._io, true, false);
-        auto framesParam = AST::addFunctionParameter (advance, blockProcessor.context.allocator.int32Type, advance.getStrings()._frames, false, false);
-
-        auto& mainBlock = *advance.getMainBlock();
+        auto& mainBlock = *advanceTo.getMainBlock();
 
         auto& currentFrame = AST::createGetStructMember (blockProcessor, stateParam,
                                                          EventHandlerUtilities::getCurrentFrameStateMemberName());
 
-        auto& loop = advance.allocateChild<AST::LoopStatement>();
+        auto& loop = advanceTo.allocateChild<AST::LoopStatement>();
         auto& loopBlock = loop.allocateChild<AST::ScopeBlock>();
 
         loop.body.referTo (loopBlock);
@@ -265,6 +266,24 @@ inline AST::ProcessorBase& createBlockTransformProcessor (AST::ProcessorBase& or
 
         loopBlock.addStatement (AST::createPreInc (loopBlock.context, currentFrame));
         mainBlock.addStatement (loop);
+    }
+
+    // _advance function definition
+    {
+        auto& advance = AST::createExportedFunction (blockProcessor,
+                                                     blockProcessor.context.allocator.voidType,
+                                                     blockProcessor.getStrings().systemAdvanceFunctionName);
+
+        auto stateParam  = AST::addFunctionParameter (advance, stateType, advance.getStrings()._state, true, false);
+        auto ioParam     = AST::addFunctionParameter (advance, ioType,    advance.getStrings()._io, true, false);
+        auto framesParam = AST::addFunctionParameter (advance, blockProcessor.context.allocator.int32Type, advance.getStrings()._frames, false, false);
+
+        auto& mainBlock = *advance.getMainBlock();
+
+        auto& currentFrame = AST::createGetStructMember (blockProcessor, stateParam,
+                                                         EventHandlerUtilities::getCurrentFrameStateMemberName());
+
+        mainBlock.addStatement (AST::createFunctionCall (mainBlock.context, advanceTo, stateParam, ioParam, framesParam));
 
         for (auto output : blockProcessor.getOutputEndpoints (true))
             if (output->isValue())
@@ -181,13 +181,13 @@ struct MoveStateVariablesToStruct  : public AST::NonParameterisedObjectVisitor
         if (f.isSystemInitFunction() || f.isEventHandler)
             getOrCreateFunctionStateParameter (f);
 
-        // main() requires state and io variable
-        if (f.isMainFunction())
+        // main() and isIdle() require state and io variable, so the graph can call them the same way
+        if (f.isMainFunction() || f.isIdleFunction())
         {
             auto& stateParam = getOrCreateFunctionStateParameter (f);
             getOrCreateFunctionIOParameter (f);
 
-            if (isTopLevelProcessor)
+            if (isTopLevelProcessor && f.isMainFunction())
             {
                 auto& updateRampsBlock = f.allocateChild<AST::ScopeBlock>();
                 ValueStreamUtilities::addUpdateRampsCall (processor, updateRampsBlock, stateParam);
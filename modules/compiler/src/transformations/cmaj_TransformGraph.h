@@ -332,6 +332,17 @@ struct FlattenGraph
             return *i->second;
         }
 
+        //==============================================================================
+        /// When profiling is enabled, each node's run call is bracketed by calls to a pair of
+        /// external functions which the engine implements natively to read the cycle counter.
+        void enableNodeProfiling (std::vector<std::string>& nodeNames)
+        {
+            auto& rootNamespace = graph.getRootNamespace();
+            profileNodeStarted  = createProfilingHook (rootNamespace, graph.getStrings().profileNodeStartedFunctionName);
+            profileNodeFinished = createProfilingHook (rootNamespace, graph.getStrings().profileNodeFinishedFunctionName);
+            profiledNodeNames = std::addressof (nodeNames);
+        }
+
     private:
         AST::Function& getOrCreateEventHandlerFunction (AST::ProcessorBase& processor,
                                                         AST::EndpointInstance& endpointInstance,
@@ -790,12 +801,15 @@ struct FlattenGraph
             block->addStatement (streamWrite);
         }
 
-        void addLoop (ptr<AST::ScopeBlock> block, int arraySize, std::function<void(AST::ScopeBlock&, AST::ValueBase&)> populateLoop, bool unroll = false)
+        /// Returns the loop that was created, or nullptr if it was unrolled
+        ptr<AST::LoopStatement> addLoop (ptr<AST::ScopeBlock> block, int arraySize, std::function<void(AST::ScopeBlock&, AST::ValueBase&)> populateLoop, bool unroll = false)
         {
             if (unroll || arraySize <= 4)
             {
                 for (int i = 0; i < arraySize; i++)
                     populateLoop (*block, block->context.allocator.createConstant (i));
+
+                return {};
             }
             else
             {
@@ -811,6 +825,7 @@ struct FlattenGraph
 
                 populateLoop (loopBlock, AST::createVariableReference (block, index));
                 block->addStatement (loop);
+                return loop;
             }
         }
 
@@ -819,30 +834,86 @@ struct FlattenGraph
             if (auto processorMainFunction = node.getProcessorType()->findMainFunction())
             {
                 auto& instanceInfo = getInfoForNode (node);
+                auto profileIndex = getProfiledNodeIndex (node);
+                auto idleFunction = node.getProcessorType()->findIdleFunction();
+
+                if (profileIndex)
+                    addProfilingHookCall (block, *profileNodeStarted, *profileIndex);
 
                 if (auto arraySize = node.getArraySize())
                 {
-                    addLoop (block, *arraySize, [&] (AST::ScopeBlock& loopBlock, AST::ValueBase& index)
+                    auto loop = addLoop (block, *arraySize, [&] (AST::ScopeBlock& loopBlock, AST::ValueBase& index)
                     {
-                        addRunCall (loopBlock,
-                                    processorMainFunction,
-                                    AST::createGetElement (block, instanceInfo.stateVariable, index),
-                                    AST::createGetElement (block, instanceInfo.ioVariable, index));
+                        addRunCall (loopBlock, processorMainFunction, idleFunction,
+                                    [&] () -> AST::ValueBase& { return AST::createGetElement (block, instanceInfo.stateVariable, index); },
+                                    [&] () -> AST::ValueBase& { return AST::createGetElement (block, instanceInfo.ioVariable, index); });
                     });
+
+                    // Each instance only touches its own state and io, so the instances can be
+                    // run lane-wise rather than one after another
+                    if (loop != nullptr)
+                        loop->hasIndependentIterations = true;
                 }
                 else
                 {
-                    addRunCall (block, processorMainFunction,
-                                instanceInfo.stateVariable, instanceInfo.ioVariable);
+                    addRunCall (block, processorMainFunction, idleFunction,
+                                [&] () -> AST::ValueBase& { return instanceInfo.stateVariable; },
+                                [&] () -> AST::ValueBase& { return instanceInfo.ioVariable; });
                 }
+
+                if (profileIndex)
+                    addProfilingHookCall (block, *profileNodeFinished, *profileIndex);
+            }
+        }
+
+        /// If the processor has an isIdle() function, its main() is only called when isIdle() returns
+        /// false. Because the io variable is cleared before each frame, a skipped node's outputs are silent.
+        static void addRunCall (ptr<AST::ScopeBlock> block, ptr<AST::Function> mainFunction, ptr<AST::Function> idleFunction,
+                                const std::function<AST::ValueBase&()>& getStateVariable,
+                                const std::function<AST::ValueBase&()>& getIOVariable)
+        {
+            auto& functionCall = AST::createFunctionCall (block, *mainFunction, getStateVariable(), getIOVariable());
+
+            if (idleFunction == nullptr)
+            {
+                block->addStatement (functionCall);
+                return;
             }
+
+            auto& isIdleCall = AST::createFunctionCall (block, *idleFunction, getStateVariable(), getIOVariable());
+            block->addStatement (AST::createIfStatement (block->context, AST::createLogicalNot (block->context, isIdleCall), functionCall));
         }
 
-        static void addRunCall (ptr<AST::ScopeBlock> block, ptr<AST::Function> mainFunction,
-                                AST::ValueBase& stateVariable, AST::ValueBase& ioVariable)
+        static AST::Function& createProfilingHook (AST::Namespace& ns, AST::PooledString name)
         {
-            auto& functionCall = AST::createFunctionCall (block, *mainFunction, stateVariable, ioVariable);
-            block->addStatement (functionCall);
+            auto& f = ns.allocateChild<AST::Function>();
+            f.name = name;
+            f.isExternal = true;
+            f.returnType.referTo (ns.context.allocator.voidType);
+            AST::addFunctionParameter (f, ns.context.allocator.int32Type, ns.getStrings().index);
+            ns.functions.addReference (f);
+            return f;
+        }
+
+        std::optional<int32_t> getProfiledNodeIndex (const AST::GraphNode& node)
+        {
+            if (profiledNodeNames == nullptr || isDelayNode (node))
+                return {};
+
+            auto name = std::string (node.getName());
+
+            for (size_t i = 0; i < profiledNodeNames->size(); ++i)
+                if ((*profiledNodeNames)[i] == name)
+                    return static_cast<int32_t> (i);
+
+            profiledNodeNames->push_back (name);
+            return static_cast<int32_t> (profiledNodeNames->size() - 1);
+        }
+
+        static void addProfilingHookCall (ptr<AST::ScopeBlock> block, AST::Function& hook, int32_t nodeIndex)
+        {
+            auto& index = block->context.allocator.createConstantInt32 (nodeIndex);
+            block->addStatement (AST::createFunctionCall (block, hook, index));
         }
 
         static ptr<AST::TypeBase> getStateStruct (AST::ProcessorBase& processor, std::optional<int> arraySize)
@@ -879,12 +950,18 @@ struct FlattenGraph
         std::unordered_map<const AST::GraphNode*, std::unique_ptr<InstanceInfo>> nodeInstanceInfoMap;
         std::vector<const AST::GraphNode*> nodesToRender, delayNodes;
         ptr<AST::ScopeBlock> processorGraphOutput;
+        ptr<AST::Function> profileNodeStarted, profileNodeFinished;
+        std::vector<std::string>* profiledNodeNames = nullptr;
     };
 
-    static void flattenGraph (AST::Graph& graph, ProcessorInfo::GetInfo getInfo, uint32_t eventBufferSize, bool isTopLevelProcessor)
+    static void flattenGraph (AST::Graph& graph, ProcessorInfo::GetInfo getInfo, uint32_t eventBufferSize, bool isTopLevelProcessor,
+                              std::vector<std::string>* profiledNodeNames)
     {
         Renderer renderer (graph, getInfo);
 
+        if (profiledNodeNames != nullptr)
+            renderer.enableNodeProfiling (*profiledNodeNames);
+
         for (auto& i : graph.nodes)
             if (auto node = AST::castTo<AST::GraphNode> (i))
                 renderer.addNode (*node, false);
@@ -1004,7 +1081,8 @@ struct FlattenGraph
 inline void flatten (AST::Program& program, AST::ProcessorBase& processor,
                      bool isTopLevelProcessor, ProcessorInfo::GetInfo getInfo,
                      uint32_t eventBufferSize,
-                     bool useForwardBranch)
+                     bool useForwardBranch,
+                     std::vector<std::string>* profiledNodeNames)
 {
     // First ensure all nodes are flattened
     for (auto& n : processor.nodes)
@@ -1023,7 +1101,7 @@ inline void flatten (AST::Program& program, AST::ProcessorBase& processor,
                                           clone.context.allocator.createInt32Type(), {});
             }
 
-            flatten (program, *node->getProcessorType(), false, getInfo, eventBufferSize, useForwardBranch);
+            flatten (program, *node->getProcessorType(), false, getInfo, eventBufferSize, useForwardBranch, nullptr);
 
             original.findParentNamespace()->subModules.removeObject (original);
         }
@@ -1031,7 +1109,7 @@ inline void flatten (AST::Program& program, AST::ProcessorBase& processor,
 
     if (auto graph = processor.getAsGraph())
     {
-        FlattenGraph::flattenGraph (*graph, getInfo, eventBufferSize, isTopLevelProcessor);
+        FlattenGraph::flattenGraph (*graph, getInfo, eventBufferSize, isTopLevelProcessor, profiledNodeNames);
     }
     else
     {
@@ -1044,17 +1122,21 @@ inline void flatten (AST::Program& program, AST::ProcessorBase& processor,
     }
 }
 
+/// If profiledNodeNames is non-null, the run calls of the main graph's nodes are wrapped in
+/// profiling hooks, and the names of the nodes are added to the vector in the order of the
+/// indexes that the hooks are given.
 inline void flattenGraph (AST::Program& program,
                           uint32_t maxBlockSize,
                           uint32_t eventBufferSize,
-                          bool useForwardBranch)
+                          bool useForwardBranch,
+                          std::vector<std::string>* profiledNodeNames)
 {
     ProcessorInfoManager processorInfoManager;
 
     bool isBlockProcessor = maxBlockSize > 1;
 
     flatten (program, program.getMainProcessor(), ! isBlockProcessor,
-             processorInfoManager.getProcessorInfo(), eventBufferSize, useForwardBranch);
+             processorInfoManager.getProcessorInfo(), eventBufferSize, useForwardBranch, profiledNodeNames);
 
     if (isBlockProcessor)
     {
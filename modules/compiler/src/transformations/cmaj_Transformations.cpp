@@ -61,6 +61,10 @@
 namespace cmaj::transformations
 {
 
+/// Runs complete rounds of the resolution passes until a round makes no changes. Some
+/// passes modify the program without counting it as a change, so stopping part-way
+/// through a round isn't safe. Each pass skips any modules that the program still
+/// holds in the resolved state that they were added in (see Program::resolvedModules).
 static void runResolutionPasses (AST::Program& program, bool throwOnErrors)
 {
     for (;;)
@@ -114,10 +118,13 @@ void prepareForCodeGen (AST::Program& program,
                         bool allowExternalFunctions,
                         const std::function<bool(AST::Intrinsic::Type)>& engineSupportsIntrinsic,
                         double& resultLatency,
-                        const std::function<bool(const EndpointID&)>& isEndpointActive)
+                        const std::function<bool(const EndpointID&)>& isEndpointActive,
+                        std::vector<std::string>* profiledNodeNames)
 {
     CMAJ_ASSERT (buildSettings.getMaxBlockSize() != 0 && buildSettings.getEventBufferSize() != 0);
 
+    // the transformations from here on can modify any module in place
+    program.resolvedModules.clear();
     cloneGraphNodes (program);
 
     auto processorReplacementState = replaceProcessorProperties (program, buildSettings.getMaxFrequency(), buildSettings.getFrequency(), useDynamicSampleRate);
@@ -148,13 +155,14 @@ void prepareForCodeGen (AST::Program& program,
     inlineAllCallsWhichAdvance (program);
     createSystemInitFunctions (program, processorReplacementState.sessionIDVariable, processorReplacementState.frequencyVariable);
     convertLargeConstantsToGlobals (program);
-    flattenGraph (program, buildSettings.getMaxBlockSize(), buildSettings.getEventBufferSize(), useForwardBranchesForAdvance);
+    flattenGraph (program, buildSettings.getMaxBlockSize(), buildSettings.getEventBufferSize(), useForwardBranchesForAdvance, profiledNodeNames);
 }
 
 void prepareForGraphGen (AST::Program& program,
                          double frequency,
                          uint64_t stackSizeLimit)
 {
+    program.resolvedModules.clear();
     cloneGraphNodes (program);
     replaceProcessorProperties (program, frequency, frequency, false);
     runFullResolutionAndChecks (program, stackSizeLimit, true, true);
@@ -29,7 +29,9 @@ namespace cmaj::transformations
 
     /// After resolving the program, this does a full validity check, flattens any graphs and
     /// runs transformations to lower its structure to a simpler subset of the AST that's
-    /// suitable for the code generator to use
+    /// suitable for the code generator to use.
+    /// If profiledNodeNames is non-null, the main graph's nodes are instrumented with profiling
+    /// hooks, and their names are returned in the vector.
     void prepareForCodeGen (AST::Program&,
                             const BuildSettings&,
                             bool useForwardBranchesForAdvance,
@@ -38,7 +40,8 @@ namespace cmaj::transformations
                             bool allowExternalFunctions,
                             const std::function<bool(AST::Intrinsic::Type)>& engineSupportsIntrinsic,
                             double& resultLatency,
-                            const std::function<bool(const EndpointID&)>& isEndpointActive);
+                            const std::function<bool(const EndpointID&)>& isEndpointActive,
+                            std::vector<std::string>* profiledNodeNames);
 
     // Run passes for graph generation
     void prepareForGraphGen (AST::Program&,
@@ -64,4 +67,21 @@ namespace cmaj::transformations
 
     /// Checks whether this seems to be a valid chunk of module data
     bool isValidBinaryModuleData (const void*, size_t);
+
+    /// The order in which cloneModules() reaches the objects and strings in a set of modules.
+    /// Cloning the same, unmodified modules always reaches them in that order, so passing one of
+    /// these to later calls saves them from having to look up each object that they meet.
+    struct ModuleCloneOrder
+    {
+        std::vector<uint32_t> indexes;
+    };
+
+    /// Makes a copy of some top-level modules (and everything they refer to) in another allocator.
+    /// The source objects are only ever read, so a set of modules which is never modified can
+    /// safely be cloned into many programs from several threads at once.
+    AST::ObjectRefVector<AST::ModuleBase> cloneModules (AST::Allocator&, const AST::ObjectRefVector<AST::ModuleBase>&,
+                                                        const ModuleCloneOrder* = nullptr);
+
+    /// Records the order to pass to cloneModules() for a set of modules that won't be modified.
+    ModuleCloneOrder getModuleCloneOrder (const AST::ObjectRefVector<AST::ModuleBase>&);
 }
@@ -0,0 +1,128 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#include "choc/platform/choc_Platform.h"
+#include "cmaj_MappedAudioFile.h"
+
+#include <mutex>
+#include <unordered_map>
+
+#if CHOC_WINDOWS
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+namespace cmaj
+{
+
+MappedAudioFile::~MappedAudioFile()
+{
+   #if CHOC_WINDOWS
+    if (mappedData != nullptr)      UnmapViewOfFile (mappedData);
+    if (mappingHandle != nullptr)   CloseHandle (mappingHandle);
+    if (fileHandle != nullptr)      CloseHandle (fileHandle);
+   #else
+    if (mappedData != nullptr)
+        munmap (const_cast<void*> (mappedData), mappedSize);
+   #endif
+}
+
+std::shared_ptr<const MappedAudioFile> MappedAudioFile::open (const std::string& path)
+{
+    static std::mutex lock;
+    static std::unordered_map<std::string, std::weak_ptr<const MappedAudioFile>> openFiles;
+
+    std::lock_guard<decltype(lock)> l (lock);
+
+    if (auto existing = openFiles[path].lock())
+        return existing;
+
+    std::shared_ptr<MappedAudioFile> file (new MappedAudioFile());
+
+    if (! file->map (path))
+        return {};
+
+    openFiles[path] = file;
+    return file;
+}
+
+bool MappedAudioFile::map (const std::string& filePath)
+{
+   #if CHOC_WINDOWS
+    auto handle = CreateFileW (std::filesystem::path (filePath).wstring().c_str(), GENERIC_READ, FILE_SHARE_READ,
+                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return false;
+
+    fileHandle = handle;
+    LARGE_INTEGER fileSize;
+
+    if (! GetFileSizeEx (handle, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG> (headerSize))
+        return false;
+
+    mappingHandle = CreateFileMappingW (handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mappingHandle == nullptr)
+        return false;
+
+    mappedSize = static_cast<size_t> (fileSize.QuadPart);
+    mappedData = MapViewOfFile (mappingHandle, FILE_MAP_READ, 0, 0, 0);
+   #else
+    auto fd = ::open (filePath.c_str(), O_RDONLY);
+
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+
+    if (fstat (fd, &info) != 0 || info.st_size < static_cast<off_t> (headerSize))
+    {
+        ::close (fd);
+        return false;
+    }
+
+    mappedSize = static_cast<size_t> (info.st_size);
+    auto data = mmap (nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close (fd);
+    mappedData = data != MAP_FAILED ? data : nullptr;
+   #endif
+
+    if (mappedData == nullptr)
+        return false;
+
+    auto header = readHeader (filePath, mappedData, mappedSize);
+
+    if (! header)
+        return false;
+
+    static_cast<AudioCacheFile&> (*this) = std::move (*header);
+    return true;
+}
+
+}
@@ -0,0 +1,61 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#pragma once
+
+#include "../../../../include/cmajor/API/cmaj_ExternalVariables.h"
+
+#include <memory>
+#include <string>
+
+namespace cmaj
+{
+
+//==============================================================================
+/**
+    A read-only memory-mapping of an AudioCacheFile.
+
+    Because the data is mapped rather than read, pages are only loaded when the running
+    program touches them, so a large sample library costs very little memory until it's
+    actually played. All the users of a given file share the same mapping, which stays
+    open until the last of them lets go of it.
+
+    The platform-specific mapping code lives in cmaj_MappedAudioFile.cpp, so that none of
+    the OS headers it needs leak into the rest of the compiler.
+*/
+struct MappedAudioFile  : public AudioCacheFile
+{
+    ~MappedAudioFile();
+
+    /// Maps a file that was created by AudioCacheFile::write(), returning nullptr if it
+    /// can't be opened or isn't valid.
+    static std::shared_ptr<const MappedAudioFile> open (const std::string& path);
+
+    const float* getFrameData() const       { return reinterpret_cast<const float*> (static_cast<const char*> (mappedData) + headerSize); }
+
+private:
+    const void* mappedData = nullptr;
+    size_t mappedSize = 0;
+    void* fileHandle = nullptr;     // only used on Windows
+    void* mappingHandle = nullptr;  // only used on Windows
+
+    MappedAudioFile() = default;
+    bool map (const std::string&);
+};
+
+}
@@ -586,6 +586,15 @@ namespace cmaj::validation
                     throwError (f, Errors::functionHasParams (f.getName()));
             }
 
+            if (f.isIdleFunction() && f.getParentModule().isProcessorBase())
+            {
+                if (f.getParentModule().isGraph())
+                    throwError (f, Errors::graphCannotContainIdleFunction());
+
+                if (! getAsTypeOrThrowError (f.returnType).isPrimitiveBool())
+                    throwError (f, Errors::functionMustReturnBool (f.getName()));
+            }
+
             DuplicateNameChecker nameChecker;
 
             for (auto& param : f.iterateParameters())
@@ -1773,6 +1782,22 @@ namespace cmaj::validation
             {
                 auto& info = AST::FunctionInfoGenerator::getInfo (f);
 
+                // isIdle() may read its inputs, but as it's only a query, it can't advance or write to any outputs
+                if (f.isIdleFunction())
+                {
+                    if (info.advanceCall != nullptr)
+                        throwError (info.advanceCall, Errors::advanceCannotBeCalledHere());
+
+                    if (info.writeStreamCall != nullptr)
+                        throwError (info.writeStreamCall, Errors::idleFunctionCannotWriteOutputs());
+
+                    if (info.writeEventCall != nullptr)
+                        throwError (info.writeEventCall, Errors::idleFunctionCannotWriteOutputs());
+
+                    if (info.writeValueCall != nullptr)
+                        throwError (info.writeValueCall, Errors::idleFunctionCannotWriteOutputs());
+                }
+
                 if (info.isOnlyCalledFromMain())
                 {
                     if (f.isMainFunction() && info.advanceCall == nullptr)
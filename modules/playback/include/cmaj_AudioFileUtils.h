@@ -28,4 +28,50 @@ choc::audio::AudioFileFormatList getAudioFormatListForReading();
 std::unique_ptr<choc::audio::AudioFileReader> createFileReader (const std::string& name);
 std::unique_ptr<choc::audio::AudioFileWriter> createFileWriter (const std::string& name, double sampleRate, uint32_t channelCount);
 
+//==============================================================================
+/// Wraps an AudioFileReader so that the file is decoded on a background thread,
+/// which runs ahead of the caller into a ring of large chunks. The file has to be
+/// read sequentially from its start, and unless the caller catches up with the
+/// decoder, each read is just a copy from memory.
+struct ReadAheadAudioFileReader
+{
+    ReadAheadAudioFileReader (std::unique_ptr<choc::audio::AudioFileReader>,
+                              uint32_t framesPerChunk = 65536, uint32_t numChunks = 4);
+    ~ReadAheadAudioFileReader();
+
+    const choc::audio::AudioFileProperties& getProperties() const;
+
+    /// Fills the buffer with the next block of frames, padding it with silence if the
+    /// end of the file is reached. If the buffer's channel count differs from the
+    /// file's, any extra channels are cleared. Returns false if the file couldn't be read.
+    bool readNextFrames (choc::buffer::ChannelArrayView<float>);
+
+private:
+    struct Pimpl;
+    std::unique_ptr<Pimpl> pimpl;
+};
+
+//==============================================================================
+/// Wraps an AudioFileWriter so that appending frames just copies them into a ring
+/// of large chunks, which a background thread encodes and writes behind the caller.
+struct WriteBehindAudioFileWriter
+{
+    WriteBehindAudioFileWriter (std::unique_ptr<choc::audio::AudioFileWriter>, uint32_t numChannels,
+                                uint32_t framesPerChunk = 65536, uint32_t numChunks = 4);
+
+    /// The destructor calls finish() if it hasn't already been called
+    ~WriteBehindAudioFileWriter();
+
+    /// Returns false if the writer has failed or has been finished.
+    bool appendFrames (choc::buffer::ChannelArrayView<const float>);
+
+    /// Waits for all the frames appended so far to be written, and closes the file.
+    /// Returns false if any of the writes failed.
+    bool finish();
+
+private:
+    struct Pimpl;
+    std::unique_ptr<Pimpl> pimpl;
+};
+
 }
@@ -19,6 +19,8 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
+#include <memory>
 
 #include "../../compiler/include/cmaj_ErrorHandling.h"
 #include "choc/audio/choc_AudioMIDIBlockDispatcher.h"
@@ -60,6 +62,10 @@ struct AudioDeviceOptions
                        std::vector<uint32_t>& midiMessageTimes)> provideInput;
     std::function<bool(choc::buffer::ChannelArrayView<const float> audioOutput)> handleOutput;
 
+    /// If this is more than 1, a MultiClientAudioMIDIPlayer will render its clients in
+    /// parallel, using this many threads including the audio thread.
+    uint32_t numClientRenderThreads = 0;
+
     using CreateAudioPlayerFn = std::function<std::shared_ptr<AudioMIDIPlayer>(const AudioDeviceOptions&)>;
     CreateAudioPlayerFn createPlayer;
 };
@@ -96,6 +102,10 @@ std::unique_ptr<AudioMIDIPlayer> createRenderingPlayer (const AudioDeviceOptions
 
 
 //==============================================================================
+/// Lets a set of callbacks share one AudioMIDIPlayer, mixing all their outputs.
+///
+/// Adding or removing a callback swaps in a new list of clients, so the audio thread
+/// never has to take a lock to use it.
 struct MultiClientAudioMIDIPlayer  : private AudioMIDICallback
 {
     MultiClientAudioMIDIPlayer (const AudioDeviceOptions&);
@@ -108,10 +118,23 @@ struct MultiClientAudioMIDIPlayer  : private AudioMIDICallback
     std::function<void(double)> onSampleRateUpdated;
 
 private:
-    std::vector<AudioMIDICallback*> clients;
+    struct ClientList;
+    struct ClientListReader;
+    struct RenderThreadPool;
+    struct Semaphore;
+
+    std::mutex clientListLock;
+    std::atomic<ClientList*> activeClients { nullptr };
+    std::atomic<ClientList*> listInUseForAudio { nullptr }, listInUseForMIDI { nullptr };
+    std::atomic<ClientList*> retiredList { nullptr };
+    std::unique_ptr<Semaphore> retiredListReleased;
+    std::unique_ptr<RenderThreadPool> renderThreads;
+    std::atomic_flag midiOutputLock = ATOMIC_FLAG_INIT;
     double currentRate = 0;
     HandleMIDIOutEventFn currentMIDIFn;
 
+    void updateClientList (const std::function<void(std::vector<AudioMIDICallback*>&)>&);
+
     void prepareToStart (double sampleRate, HandleMIDIOutEventFn) override;
     void addIncomingMIDIEvent (const void* data, uint32_t size) override;
     void process (choc::buffer::ChannelArrayView<const float> input,
@@ -121,6 +121,12 @@ struct PerformerAllocationCheckWrapper  : public choc::com::ObjectWithAtomicRefC
         target->addInputEvent (endpoint, typeIndex, eventData);
     }
 
+    void addInputEvents (EndpointHandle endpoint, const EventBatch* batch) override
+    {
+        ScopedAllocationTracker allocationTracker;
+        target->addInputEvents (endpoint, batch);
+    }
+
     void copyOutputValue (EndpointHandle h, void* dest) override
     {
         ScopedAllocationTracker allocationTracker;
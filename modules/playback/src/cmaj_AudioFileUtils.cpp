@@ -19,12 +19,32 @@
 #include "../../compiler/include/cmaj_ErrorHandling.h"
 #include "../include/cmaj_AudioFileUtils.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 #ifdef __EMSCRIPTEN__
 namespace cmaj::audio_utils
 {
 choc::audio::AudioFileFormatList getAudioFormatListForReading()                                       { return {}; }
 std::unique_ptr<choc::audio::AudioFileReader> createFileReader (const std::string&)                   { return {}; }
 std::unique_ptr<choc::audio::AudioFileWriter> createFileWriter (const std::string&, double, uint32_t) { return {}; }
+
+// There are no threads or files to stream from in a browser, so these just fail
+struct ReadAheadAudioFileReader::Pimpl   { choc::audio::AudioFileProperties properties; };
+struct WriteBehindAudioFileWriter::Pimpl {};
+
+ReadAheadAudioFileReader::ReadAheadAudioFileReader (std::unique_ptr<choc::audio::AudioFileReader>, uint32_t, uint32_t) : pimpl (std::make_unique<Pimpl>()) {}
+ReadAheadAudioFileReader::~ReadAheadAudioFileReader() = default;
+const choc::audio::AudioFileProperties& ReadAheadAudioFileReader::getProperties() const   { return pimpl->properties; }
+bool ReadAheadAudioFileReader::readNextFrames (choc::buffer::ChannelArrayView<float>)     { return false; }
+
+WriteBehindAudioFileWriter::WriteBehindAudioFileWriter (std::unique_ptr<choc::audio::AudioFileWriter>, uint32_t, uint32_t, uint32_t) : pimpl (std::make_unique<Pimpl>()) {}
+WriteBehindAudioFileWriter::~WriteBehindAudioFileWriter() = default;
+bool WriteBehindAudioFileWriter::appendFrames (choc::buffer::ChannelArrayView<const float>)  { return false; }
+bool WriteBehindAudioFileWriter::finish()                                                    { return false; }
 }
 
 #else
@@ -64,6 +84,288 @@ std::unique_ptr<choc::audio::AudioFileWriter> createFileWriter (const std::strin
     return wav.createWriter (name, props);
 }
 
+//==============================================================================
+/// A ring of chunks passed from one producer thread to one consumer thread. The
+/// counters are atomic, so neither side takes a lock unless it has to wait for
+/// the other one to catch up.
+struct AudioChunkRing
+{
+    AudioChunkRing (uint32_t numChannels, uint32_t framesPerChunk, uint32_t numChunks)
+    {
+        chunks.reserve (numChunks);
+
+        for (uint32_t i = 0; i < numChunks; ++i)
+            chunks.push_back ({ choc::buffer::ChannelArrayBuffer<float> (numChannels, framesPerChunk), 0 });
+    }
+
+    struct Chunk
+    {
+        choc::buffer::ChannelArrayBuffer<float> frames;
+        uint32_t numFrames = 0;
+    };
+
+    /// Blocks until there's a free chunk, or returns nullptr if the ring has been stopped
+    Chunk* waitForChunkToWrite()
+    {
+        waitFor ([this] { return numWritten - numRead < chunks.size(); });
+        return stopped ? nullptr : std::addressof (getChunk (numWritten));
+    }
+
+    void finishedWritingChunk()
+    {
+        ++numWritten;
+        notify();
+    }
+
+    /// Blocks until there's a chunk to read, or returns nullptr if there won't be any more
+    Chunk* waitForChunkToRead()
+    {
+        waitFor ([this] { return numRead < numWritten || finishedWriting; });
+        return numRead < numWritten && ! stopped ? std::addressof (getChunk (numRead)) : nullptr;
+    }
+
+    void finishedReadingChunk()
+    {
+        ++numRead;
+        notify();
+    }
+
+    /// Called by the producer when it has no more chunks to write
+    void setFinishedWriting()
+    {
+        finishedWriting = true;
+        notify();
+    }
+
+    /// Makes both sides give up waiting
+    void stop()
+    {
+        stopped = true;
+        notify();
+    }
+
+private:
+    std::vector<Chunk> chunks;
+    std::atomic<uint64_t> numWritten { 0 }, numRead { 0 };
+    std::atomic<bool> finishedWriting { false }, stopped { false };
+    std::mutex lock;
+    std::condition_variable condition;
+
+    Chunk& getChunk (uint64_t index)    { return chunks[static_cast<size_t> (index % chunks.size())]; }
+
+    template <typename Predicate>
+    void waitFor (Predicate&& isReady)
+    {
+        if (isReady() || stopped)
+            return;
+
+        std::unique_lock<std::mutex> l (lock);
+        condition.wait (l, [&] { return isReady() || stopped; });
+    }
+
+    void notify()
+    {
+        // taking the lock here means a waiter can't miss the change between testing its
+        // condition and going to sleep
+        { std::lock_guard<std::mutex> l (lock); }
+        condition.notify_all();
+    }
+};
+
+//==============================================================================
+struct ReadAheadAudioFileReader::Pimpl
+{
+    Pimpl (std::unique_ptr<choc::audio::AudioFileReader> r, uint32_t framesPerChunk, uint32_t numChunks)
+        : reader (std::move (r)),
+          properties (reader->getProperties()),
+          ring (properties.numChannels, framesPerChunk, numChunks),
+          decodeThread ([this] { decode(); })
+    {
+    }
+
+    ~Pimpl()
+    {
+        ring.stop();
+        decodeThread.join();
+    }
+
+    void decode()
+    {
+        for (uint64_t frame = 0; frame < properties.numFrames;)
+        {
+            auto chunk = ring.waitForChunkToWrite();
+
+            if (chunk == nullptr)
+                return;
+
+            auto numFrames = static_cast<uint32_t> (std::min (static_cast<uint64_t> (chunk->frames.getNumFrames()),
+                                                              properties.numFrames - frame));
+
+            if (! reader->readFrames (frame, chunk->frames.getView().getStart (numFrames)))
+            {
+                failed = true;
+                break;
+            }
+
+            chunk->numFrames = numFrames;
+            ring.finishedWritingChunk();
+            frame += numFrames;
+        }
+
+        ring.setFinishedWriting();
+    }
+
+    bool readNextFrames (choc::buffer::ChannelArrayView<float> dest)
+    {
+        auto numFrames = dest.getNumFrames();
+
+        for (uint32_t done = 0; done < numFrames;)
+        {
+            auto chunk = ring.waitForChunkToRead();
+
+            if (chunk == nullptr)
+            {
+                dest.getFrameRange ({ done, numFrames }).clear();
+                return ! failed;
+            }
+
+            auto numToCopy = std::min (numFrames - done, chunk->numFrames - positionInChunk);
+
+            choc::buffer::copyIntersectionAndClearOutside (dest.getFrameRange ({ done, done + numToCopy }),
+                                                           chunk->frames.getView().getFrameRange ({ positionInChunk, positionInChunk + numToCopy }));
+            done += numToCopy;
+            positionInChunk += numToCopy;
+
+            if (positionInChunk == chunk->numFrames)
+            {
+                positionInChunk = 0;
+                ring.finishedReadingChunk();
+            }
+        }
+
+        return true;
+    }
+
+    std::unique_ptr<choc::audio::AudioFileReader> reader;
+    const choc::audio::AudioFileProperties properties;
+    AudioChunkRing ring;
+    uint32_t positionInChunk = 0;
+    std::atomic<bool> failed { false };
+    std::thread decodeThread;
+};
+
+ReadAheadAudioFileReader::ReadAheadAudioFileReader (std::unique_ptr<choc::audio::AudioFileReader> reader,
+                                                    uint32_t framesPerChunk, uint32_t numChunks)
+{
+    CMAJ_ASSERT (reader != nullptr && framesPerChunk != 0 && numChunks != 0);
+    pimpl = std::make_unique<Pimpl> (std::move (reader), framesPerChunk, numChunks);
+}
+
+ReadAheadAudioFileReader::~ReadAheadAudioFileReader() = default;
+
+const choc::audio::AudioFileProperties& ReadAheadAudioFileReader::getProperties() const     { return pimpl->properties; }
+bool ReadAheadAudioFileReader::readNextFrames (choc::buffer::ChannelArrayView<float> dest)  { return pimpl->readNextFrames (dest); }
+
+//==============================================================================
+struct WriteBehindAudioFileWriter::Pimpl
+{
+    Pimpl (std::unique_ptr<choc::audio::AudioFileWriter> w, uint32_t numChannels, uint32_t framesPerChunk, uint32_t numChunks)
+        : writer (std::move (w)),
+          ring (numChannels, framesPerChunk, numChunks),
+          encodeThread ([this] { encode(); })
+    {
+    }
+
+    ~Pimpl()
+    {
+        finish();
+    }
+
+    void encode()
+    {
+        while (auto chunk = ring.waitForChunkToRead())
+        {
+            if (! failed && ! writer->appendFrames (chunk->frames.getView().getStart (chunk->numFrames)))
+                failed = true;
+
+            ring.finishedReadingChunk();
+        }
+    }
+
+    bool appendFrames (choc::buffer::ChannelArrayView<const float> source)
+    {
+        if (failed || ! encodeThread.joinable())
+            return false;
+
+        auto numFrames = source.getNumFrames();
+
+        for (uint32_t done = 0; done < numFrames;)
+        {
+            if (currentChunk == nullptr)
+            {
+                currentChunk = ring.waitForChunkToWrite();
+
+                if (currentChunk == nullptr)
+                    return false;
+
+                currentChunk->numFrames = 0;
+            }
+
+            auto start = currentChunk->numFrames;
+            auto numToCopy = std::min (numFrames - done, currentChunk->frames.getNumFrames() - start);
+
+            choc::buffer::copyIntersectionAndClearOutside (currentChunk->frames.getView().getFrameRange ({ start, start + numToCopy }),
+                                                           source.getFrameRange ({ done, done + numToCopy }));
+            done += numToCopy;
+            currentChunk->numFrames += numToCopy;
+
+            if (currentChunk->numFrames == currentChunk->frames.getNumFrames())
+            {
+                currentChunk = nullptr;
+                ring.finishedWritingChunk();
+            }
+        }
+
+        return true;
+    }
+
+    bool finish()
+    {
+        if (encodeThread.joinable())
+        {
+            if (currentChunk != nullptr && currentChunk->numFrames != 0)
+                ring.finishedWritingChunk();
+
+            currentChunk = nullptr;
+            ring.setFinishedWriting();
+            encodeThread.join();
+
+            // deleting the writer is what completes the file
+            writer.reset();
+        }
+
+        return ! failed;
+    }
+
+    std::unique_ptr<choc::audio::AudioFileWriter> writer;
+    AudioChunkRing ring;
+    AudioChunkRing::Chunk* currentChunk = nullptr;
+    std::atomic<bool> failed { false };
+    std::thread encodeThread;
+};
+
+WriteBehindAudioFileWriter::WriteBehindAudioFileWriter (std::unique_ptr<choc::audio::AudioFileWriter> writer, uint32_t numChannels,
+                                                        uint32_t framesPerChunk, uint32_t numChunks)
+{
+    CMAJ_ASSERT (writer != nullptr && framesPerChunk != 0 && numChunks != 0);
+    pimpl = std::make_unique<Pimpl> (std::move (writer), numChannels, framesPerChunk, numChunks);
+}
+
+WriteBehindAudioFileWriter::~WriteBehindAudioFileWriter() = default;
+
+bool WriteBehindAudioFileWriter::appendFrames (choc::buffer::ChannelArrayView<const float> source)  { return pimpl->appendFrames (source); }
+bool WriteBehindAudioFileWriter::finish()                                                            { return pimpl->finish(); }
+
 }
 
 #endif
@@ -17,9 +17,38 @@
 //  DISCLAIMED.
 
 #include <thread>
+#include <condition_variable>
+#include <chrono>
 
+#include "choc/platform/choc_Platform.h"
 #include "../include/cmaj_AudioPlayer.h"
 
+#if CHOC_WINDOWS
+ #ifndef WIN32_LEAN_AND_MEAN
+  #define WIN32_LEAN_AND_MEAN
+ #endif
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+ #include <climits>
+#elif CHOC_APPLE
+ #include <pthread.h>
+ #include <dispatch/dispatch.h>
+ #include <mach/mach.h>
+ #include <mach/thread_policy.h>
+#else
+ #include <cerrno>
+ #include <pthread.h>
+ #include <semaphore.h>
+#endif
+
+#if defined (_M_X64) || defined (_M_IX86)
+ #include <intrin.h>
+#elif defined (__x86_64__) || defined (__i386__)
+ #include <immintrin.h>
+#endif
+
 
 namespace cmaj::audio_utils
 {
@@ -70,6 +99,15 @@ struct RenderingPlayer  : public AudioMIDIPlayer
         midiMessages.reserve (512);
         midiMessageTimes.reserve (512);
 
+        {
+            const std::lock_guard<decltype(startLock)> lock (startLock);
+
+            if (callback == nullptr)
+                return;
+
+            callback->prepareToStart (options.sampleRate, [] (uint32_t, choc::midi::ShortMessage) {});
+        }
+
         for (;;)
         {
             audioInput.clear();
@@ -88,8 +126,6 @@ struct RenderingPlayer  : public AudioMIDIPlayer
                 return;
             }
 
-            callback->prepareToStart (options.sampleRate, [] (uint32_t, choc::midi::ShortMessage) {});
-
             CMAJ_ASSERT (midiMessages.size() == midiMessageTimes.size());
 
             if (auto totalNumMIDIMessages = static_cast<uint32_t> (midiMessages.size()))
@@ -167,6 +203,293 @@ std::unique_ptr<AudioMIDIPlayer> createDummyPlayer (const AudioDeviceOptions& op
     return std::make_unique<DummyPlayer> (options);
 }
 
+//==============================================================================
+struct MultiClientAudioMIDIPlayer::ClientList
+{
+    ClientList (std::vector<AudioMIDICallback*> c, uint32_t numChannels, uint32_t maxFramesPerBlock, bool needsOutputBuffers)
+        : clients (std::move (c))
+    {
+        if (needsOutputBuffers && clients.size() > 1)
+            for (size_t i = 0; i < clients.size(); ++i)
+                outputBuffers.emplace_back (numChannels, maxFramesPerBlock);
+    }
+
+    bool canRenderInParallel (choc::buffer::ChannelArrayView<float> output) const
+    {
+        return ! outputBuffers.empty()
+                && outputBuffers.front().getNumChannels() == output.getNumChannels()
+                && outputBuffers.front().getNumFrames() >= output.getNumFrames();
+    }
+
+    std::vector<AudioMIDICallback*> clients;
+
+    /// When rendering in parallel, each client renders into its own buffer, and these are then mixed
+    std::vector<choc::buffer::ChannelArrayBuffer<float>> outputBuffers;
+};
+
+//==============================================================================
+/// Called on each turn of a busy-wait loop. This tells the CPU that the thread is spinning,
+/// so that it backs off a little and gives more of the core to a hyper-threaded sibling,
+/// which may well be the thread that's being waited for.
+static inline void pauseWhileSpinning() noexcept
+{
+   #if defined (_M_X64) || defined (_M_IX86) || defined (__x86_64__) || defined (__i386__)
+    _mm_pause();
+   #elif defined (_M_ARM64)
+    __yield();
+   #elif defined (__aarch64__) || defined (__arm__)
+    __asm__ __volatile__ ("yield");
+   #endif
+}
+
+//==============================================================================
+/// A counting semaphore. Signalling it never blocks, so the audio thread can use it to
+/// wake up a thread that's waiting for it.
+struct MultiClientAudioMIDIPlayer::Semaphore
+{
+   #if CHOC_WINDOWS
+    Semaphore()     : handle (CreateSemaphoreW (nullptr, 0, LONG_MAX, nullptr)) {}
+    ~Semaphore()    { CloseHandle (handle); }
+
+    void signal()   { ReleaseSemaphore (handle, 1, nullptr); }
+    void wait()     { WaitForSingleObject (handle, INFINITE); }
+
+    HANDLE handle;
+   #elif CHOC_APPLE
+    Semaphore()     : semaphore (dispatch_semaphore_create (0)) {}
+    ~Semaphore()    { dispatch_release (semaphore); }
+
+    void signal()   { dispatch_semaphore_signal (semaphore); }
+    void wait()     { dispatch_semaphore_wait (semaphore, DISPATCH_TIME_FOREVER); }
+
+    dispatch_semaphore_t semaphore;
+   #else
+    Semaphore()     { sem_init (std::addressof (semaphore), 0, 0); }
+    ~Semaphore()    { sem_destroy (std::addressof (semaphore)); }
+
+    void signal()   { sem_post (std::addressof (semaphore)); }
+    void wait()     { while (sem_wait (std::addressof (semaphore)) != 0 && errno == EINTR) {} }
+
+    sem_t semaphore;
+   #endif
+};
+
+//==============================================================================
+/// Gets hold of the current client list for the duration of a callback. Each thread that
+/// reads the list has its own slot where it marks the list as being in use, so that
+/// updateClientList() knows when it's safe to delete an old one, without the reader
+/// needing to lock anything. If a reader lets go of the list that updateClientList() is
+/// waiting to delete, it signals the semaphore that it's waiting on.
+struct MultiClientAudioMIDIPlayer::ClientListReader
+{
+    ClientListReader (MultiClientAudioMIDIPlayer& p, std::atomic<ClientList*>& slot) : owner (p), inUse (slot)
+    {
+        for (;;)
+        {
+            list = owner.activeClients.load();
+            inUse.store (list);
+
+            if (owner.activeClients.load() == list)
+                break;
+
+            release();
+        }
+    }
+
+    ~ClientListReader()
+    {
+        release();
+    }
+
+    void release()
+    {
+        if (inUse.exchange (nullptr) == owner.retiredList.load())
+            owner.retiredListReleased->signal();
+    }
+
+    MultiClientAudioMIDIPlayer& owner;
+    std::atomic<ClientList*>& inUse;
+    ClientList* list = nullptr;
+};
+
+//==============================================================================
+/// Renders a list of clients in parallel. The audio thread takes jobs alongside the worker
+/// threads, so it never has to wait for a worker to wake up - at most, it waits for jobs
+/// that a worker has already started to finish. So that a worker can't be pre-empted in
+/// the middle of one of those jobs by anything that the audio thread itself wouldn't be,
+/// the workers are given the same scheduling priority as the audio thread.
+struct MultiClientAudioMIDIPlayer::RenderThreadPool
+{
+    RenderThreadPool (uint32_t numWorkers)
+    {
+        for (uint32_t i = 0; i < numWorkers; ++i)
+            workers.emplace_back ([this] { runWorker(); });
+    }
+
+    ~RenderThreadPool()
+    {
+        {
+            const std::lock_guard<decltype(wakeUpLock)> lock (wakeUpLock);
+            shouldExit = true;
+        }
+
+        wakeUp.notify_all();
+
+        for (auto& w : workers)
+            w.join();
+    }
+
+    void render (ClientList& list, choc::buffer::ChannelArrayView<const float> input, uint32_t numFrames)
+    {
+        // This only makes system calls on the first block, or if the device switches threads
+        if (auto callingThread = std::this_thread::get_id(); callingThread != audioThreadID)
+        {
+            audioThreadID = callingThread;
+
+            for (auto& w : workers)
+                copyCurrentThreadPriority (w);
+        }
+
+        auto numClients = static_cast<uint32_t> (list.clients.size());
+        auto thisGeneration = ++currentGeneration;
+
+        currentList = std::addressof (list);
+        currentInput = input;
+        currentNumFrames = numFrames;
+        numJobs.store (numClients, std::memory_order_relaxed);
+        numJobsDone.store (0, std::memory_order_relaxed);
+        jobCounter.store (static_cast<uint64_t> (thisGeneration) << 32, std::memory_order_release);
+
+        generation.store (thisGeneration, std::memory_order_release);
+        wakeUp.notify_all();
+
+        runJobs (thisGeneration);
+
+        // Any jobs that are left have already been claimed by workers, so there's nothing
+        // more that this thread can render while it waits for them
+        while (numJobsDone.load (std::memory_order_acquire) < numClients)
+            pauseWhileSpinning();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex wakeUpLock;
+    std::condition_variable wakeUp;
+    bool shouldExit = false;
+
+    std::atomic<uint32_t> generation { 0 }, numJobs { 0 }, numJobsDone { 0 };
+    std::atomic<uint64_t> jobCounter { 0 };  // generation in the top 32 bits, next job index in the bottom 32
+    uint32_t currentGeneration = 0;
+    std::thread::id audioThreadID;
+
+    // These are only written by the audio thread while no jobs are available
+    ClientList* currentList = nullptr;
+    choc::buffer::ChannelArrayView<const float> currentInput;
+    uint32_t currentNumFrames = 0;
+
+    void runWorker()
+    {
+        uint32_t lastGeneration = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<decltype(wakeUpLock)> lock (wakeUpLock);
+                wakeUp.wait (lock, [&] { return shouldExit || generation.load (std::memory_order_acquire) != lastGeneration; });
+
+                if (shouldExit)
+                    return;
+            }
+
+            // If the audio thread's notification arrives just before we start waiting, this worker
+            // misses that block, and the other threads pick up its share of the jobs
+            lastGeneration = generation.load (std::memory_order_acquire);
+            runJobs (lastGeneration);
+        }
+    }
+
+    void runJobs (uint32_t jobGeneration)
+    {
+        uint32_t index;
+
+        while (claimJob (jobGeneration, index))
+        {
+            auto& list = *currentList;
+            list.clients[index]->process (currentInput,
+                                          list.outputBuffers[index].getFrameRange ({ 0, currentNumFrames }),
+                                          true);
+
+            numJobsDone.fetch_add (1, std::memory_order_release);
+        }
+    }
+
+    static void copyCurrentThreadPriority (std::thread& target)
+    {
+       #if CHOC_WINDOWS
+        SetThreadPriority (target.native_handle(), GetThreadPriority (GetCurrentThread()));
+       #else
+        #if CHOC_APPLE
+         // CoreAudio threads use a time-constraint policy, which the pthread priority doesn't capture
+         thread_time_constraint_policy_data_t timeConstraints;
+         mach_msg_type_number_t count = THREAD_TIME_CONSTRAINT_POLICY_COUNT;
+         boolean_t isDefault = false;
+
+         if (thread_policy_get (pthread_mach_thread_np (pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+                                reinterpret_cast<thread_policy_t> (std::addressof (timeConstraints)),
+                                std::addressof (count), std::addressof (isDefault)) == KERN_SUCCESS
+              && ! isDefault)
+         {
+             thread_policy_set (pthread_mach_thread_np (target.native_handle()), THREAD_TIME_CONSTRAINT_POLICY,
+                                reinterpret_cast<thread_policy_t> (std::addressof (timeConstraints)),
+                                THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+             return;
+         }
+        #endif
+
+        int policy = 0;
+        sched_param param {};
+
+        if (pthread_getschedparam (pthread_self(), std::addressof (policy), std::addressof (param)) == 0)
+            pthread_setschedparam (target.native_handle(), policy, std::addressof (param));
+       #endif
+    }
+
+    bool claimJob (uint32_t jobGeneration, uint32_t& index)
+    {
+        auto current = jobCounter.load (std::memory_order_acquire);
+
+        for (;;)
+        {
+            if (static_cast<uint32_t> (current >> 32) != jobGeneration)
+                return false;
+
+            index = static_cast<uint32_t> (current);
+
+            if (index >= numJobs.load (std::memory_order_relaxed))
+                return false;
+
+            if (jobCounter.compare_exchange_weak (current, current + 1, std::memory_order_acq_rel))
+                return true;
+        }
+    }
+};
+
+//==============================================================================
+// This is kept as a simple loop over contiguous samples so that the compiler can vectorise it
+static void addToOutput (choc::buffer::ChannelArrayView<float> dest, choc::buffer::ChannelArrayView<float> source)
+{
+    auto numFrames = dest.getNumFrames();
+
+    for (uint32_t chan = 0; chan < dest.getNumChannels(); ++chan)
+    {
+        auto d = dest.getChannel (chan).data.data;
+        auto s = source.getChannel (chan).data.data;
+
+        for (uint32_t i = 0; i < numFrames; ++i)
+            d[i] += s[i];
+    }
+}
+
 //==============================================================================
 MultiClientAudioMIDIPlayer::MultiClientAudioMIDIPlayer (const AudioDeviceOptions& options)
     : player (options.createPlayer (options))
@@ -177,25 +500,67 @@ MultiClientAudioMIDIPlayer::MultiClientAudioMIDIPlayer (const AudioDeviceOptions
     };
 
     CMAJ_ASSERT (player != nullptr);
+
+    if (options.numClientRenderThreads > 1)
+        renderThreads = std::make_unique<RenderThreadPool> (options.numClientRenderThreads - 1);
+
+    retiredListReleased = std::make_unique<Semaphore>();
+    activeClients = new ClientList ({}, 0, 0, false);
 }
 
-MultiClientAudioMIDIPlayer::~MultiClientAudioMIDIPlayer() = default;
+MultiClientAudioMIDIPlayer::~MultiClientAudioMIDIPlayer()
+{
+    player->stop();
+    renderThreads.reset();
+    delete activeClients.load();
+}
+
+void MultiClientAudioMIDIPlayer::updateClientList (const std::function<void(std::vector<AudioMIDICallback*>&)>& update)
+{
+    static constexpr uint32_t defaultMaxFramesPerBlock = 2048;
+
+    auto clients = activeClients.load()->clients;
+    update (clients);
+
+    // The new list and all its buffers are allocated before it's published, so the
+    // audio thread never has to allocate anything
+    auto& options = player->options;
+    auto newList = new ClientList (std::move (clients), options.outputChannelCount,
+                                   options.blockSize != 0 ? options.blockSize : defaultMaxFramesPerBlock,
+                                   renderThreads != nullptr);
+
+    auto oldList = activeClients.exchange (newList);
+
+    // Any reader which still holds the old list will signal when it lets go of it. A signal
+    // may also be left over from a previous update, so this re-checks after each wake-up
+    retiredList.store (oldList);
+
+    while (listInUseForAudio.load() == oldList || listInUseForMIDI.load() == oldList)
+        retiredListReleased->wait();
+
+    retiredList.store (nullptr);
+    delete oldList;
+}
 
 void MultiClientAudioMIDIPlayer::addCallback (AudioMIDICallback& c)
 {
     bool needToStart = false;
 
     {
-        const std::lock_guard<decltype(player->callbackLock)> lock (player->callbackLock);
+        const std::lock_guard<decltype(clientListLock)> lock (clientListLock);
 
-        if (std::find (clients.begin(), clients.end(), std::addressof (c)) == clients.end())
+        updateClientList ([&] (std::vector<AudioMIDICallback*>& clients)
         {
-            needToStart = clients.empty();
-            clients.push_back (std::addressof (c));
+            if (std::find (clients.begin(), clients.end(), std::addressof (c)) == clients.end())
+            {
+                needToStart = clients.empty();
 
-            if (! needToStart && currentRate != 0)
-                c.prepareToStart (currentRate, currentMIDIFn);
-        }
+                if (! needToStart && currentRate != 0)
+                    c.prepareToStart (currentRate, currentMIDIFn);
+
+                clients.push_back (std::addressof (c));
+            }
+        });
     }
 
     if (needToStart)
@@ -207,17 +572,22 @@ void MultiClientAudioMIDIPlayer::removeCallback (AudioMIDICallback& c)
     bool needToStop = false;
 
     {
-        const std::lock_guard<decltype(player->callbackLock)> lock (player->callbackLock);
+        const std::lock_guard<decltype(clientListLock)> lock (clientListLock);
 
-        if (auto i = std::find (clients.begin(), clients.end(), std::addressof (c)); i != clients.end())
-            clients.erase (i);
+        updateClientList ([&] (std::vector<AudioMIDICallback*>& clients)
+        {
+            if (auto i = std::find (clients.begin(), clients.end(), std::addressof (c)); i != clients.end())
+                clients.erase (i);
 
-        needToStop = clients.empty();
+            needToStop = clients.empty();
+        });
     }
 
     if (needToStop)
     {
         player->stop();
+
+        const std::lock_guard<decltype(clientListLock)> lock (clientListLock);
         currentRate = 0;
         currentMIDIFn = {};
     }
@@ -225,16 +595,37 @@ void MultiClientAudioMIDIPlayer::removeCallback (AudioMIDICallback& c)
 
 void MultiClientAudioMIDIPlayer::prepareToStart (double sampleRate, choc::audio::AudioMIDIBlockDispatcher::HandleMIDIMessageFn handleOutgoingMIDI)
 {
+    // When clients are rendered in parallel, more than one of them may send MIDI at once
+    if (renderThreads != nullptr && handleOutgoingMIDI != nullptr)
+    {
+        handleOutgoingMIDI = [this, send = std::move (handleOutgoingMIDI)] (uint32_t frame, choc::midi::ShortMessage message)
+        {
+            while (midiOutputLock.test_and_set (std::memory_order_acquire))
+                pauseWhileSpinning();
+
+            send (frame, message);
+            midiOutputLock.clear (std::memory_order_release);
+        };
+    }
+
+    const std::lock_guard<decltype(clientListLock)> lock (clientListLock);
+
     currentRate = sampleRate;
     currentMIDIFn = handleOutgoingMIDI;
 
-    for (auto c : clients)
+    // the device may have changed its block size or channel count, so the clients' output buffers need updating
+    if (renderThreads != nullptr)
+        updateClientList ([] (std::vector<AudioMIDICallback*>&) {});
+
+    for (auto c : activeClients.load()->clients)
         c->prepareToStart (sampleRate, handleOutgoingMIDI);
 }
 
 void MultiClientAudioMIDIPlayer::addIncomingMIDIEvent (const void* data, uint32_t size)
 {
-    for (auto c : clients)
+    ClientListReader reader (*this, listInUseForMIDI);
+
+    for (auto c : reader.list->clients)
         c->addIncomingMIDIEvent (data, size);
 }
 
@@ -242,15 +633,34 @@ void MultiClientAudioMIDIPlayer::process (choc::buffer::ChannelArrayView<const f
                                           choc::buffer::ChannelArrayView<float> output,
                                           bool replaceOutput)
 {
-    if (clients.empty())
+    ClientListReader reader (*this, listInUseForAudio);
+    auto& list = *reader.list;
+    auto numClients = list.clients.size();
+
+    if (numClients == 0)
     {
         if (replaceOutput)
             output.clear();
     }
+    else if (renderThreads != nullptr && list.canRenderInParallel (output))
+    {
+        auto numFrames = output.getNumFrames();
+        renderThreads->render (list, input, numFrames);
+
+        for (size_t i = 0; i < numClients; ++i)
+        {
+            auto clientOutput = list.outputBuffers[i].getFrameRange ({ 0, numFrames });
+
+            if (replaceOutput && i == 0)
+                copy (output, clientOutput);
+            else
+                addToOutput (output, clientOutput);
+        }
+    }
     else
     {
-        for (size_t i = 0; i < clients.size(); ++i)
-            clients[i]->process (input, output, replaceOutput && i == 0);
+        for (size_t i = 0; i < numClients; ++i)
+            list.clients[i]->process (input, output, replaceOutput && i == 0);
     }
 }
 
@@ -19,6 +19,7 @@
 #include <future>
 #include <iomanip>
 #include <optional>
+#include <thread>
 
 #include "../../compiler/include/cmaj_ErrorHandling.h"
 #include "../include/cmaj_ScriptEngine.h"
@@ -72,6 +73,23 @@ namespace cmaj::test
                        bool runDisabled, const choc::value::Value& engineOptions,
                        std::string testScriptPath);
 
+        void printHeader (std::ostream& console) const
+        {
+            console << thickDivider << std::endl
+                    << "Running: " << std::filesystem::path (filename).filename().string() << "   (" << filename << ")" << std::endl
+                    << std::endl;
+        }
+
+        std::chrono::duration<double> getTotalTime() const
+        {
+            std::chrono::duration<double> total {};
+
+            for (auto& test : tests)
+                total += test.time;
+
+            return total;
+        }
+
         bool needsResaving() const
         {
             for (auto& test : tests)
@@ -128,7 +146,6 @@ namespace cmaj::test
             {
                 auto endTime = std::chrono::steady_clock::now();
                 time = (endTime - startTime);
-                suite.time += time;
 
                 if (needsNewLine)
                     newline();
@@ -185,7 +202,7 @@ namespace cmaj::test
             TestSuite& suite;
             TestSection section;
             std::vector<std::string> log, passed, failed, disabled, unsupported, errorReports;
-            std::chrono::duration<double> time;
+            std::chrono::duration<double> time {};
 
         private:
             std::ostream* console = nullptr;
@@ -237,7 +254,6 @@ namespace cmaj::test
         //==============================================================================
         std::string filename, userScript, globalSource;
         std::atomic<int> passed { 0 }, failed { 0 }, disabled { 0 }, unsupported { 0 };
-        std::chrono::duration<double> time;
         std::vector<TestCase> tests;
 
     private:
@@ -302,40 +318,6 @@ namespace cmaj::test
         }
     };
 
-    //==============================================================================
-    struct ThreadPool
-    {
-        ThreadPool (uint32_t threads) : availableThreads (threads)
-        {}
-
-        void acquire()
-        {
-            std::unique_lock<std::mutex> lock (mutex);
-            cv.wait (lock, [this] { return availableThreads != 0; });
-            availableThreads--;
-        }
-
-        void release()
-        {
-            std::unique_lock<std::mutex> lock (mutex);
-            availableThreads++;
-            cv.notify_one();
-        }
-
-    private:
-        std::mutex mutex;
-        std::condition_variable cv;
-        uint32_t availableThreads;
-    };
-
-    struct ThreadAllocator
-    {
-        ThreadAllocator (ThreadPool& p) : pool (p)    { pool.acquire(); }
-        ~ThreadAllocator()                            { pool.release(); }
-
-        ThreadPool& pool;
-    };
-
     //==============================================================================
     struct TestResult
     {
@@ -357,7 +339,7 @@ namespace cmaj::test
             failed += s.failed;
             disabled += s.disabled;
             unsupported += s.unsupported;
-            time += s.time;
+            time += s.getTotalTime();
         }
 
         int passed = 0;
@@ -366,7 +348,7 @@ namespace cmaj::test
         int unsupported = 0;
         int files = 0;
         size_t total = 0;
-        std::chrono::duration<double> time;
+        std::chrono::duration<double> time {};
 
         bool noFailures() const
         {
@@ -416,7 +398,7 @@ namespace cmaj::test
                     << "\" errors=\"" << ts->failed
                     << "\" name=\"" << ts->filename
                     << "\" tests=\"" << ts->tests.size()
-                    << "\" time=\"" << ts->time.count() << "\">" << std::endl;
+                    << "\" time=\"" << ts->getTotalTime().count() << "\">" << std::endl;
 
                 for (auto& t : ts->tests)
                 {
@@ -447,10 +429,9 @@ namespace cmaj::test
     {
         TestJavascriptEngine (cmaj::BuildSettings buildSettings,
                               TestSuite& suite,
-                              std::ostream& out,
                               const choc::value::Value& engineOptions,
                               std::string testScriptPathToUse)
-           : testFile (suite.filename), output (out),
+           : testFile (suite.filename),
              defaultEngineOptions (engineOptions), testScriptPath (std::move (testScriptPathToUse))
         {
             javascriptEngine = std::make_shared<javascript::JavascriptEngine> (buildSettings.setFrequency (44100),
@@ -498,6 +479,7 @@ namespace cmaj::test
                                                             "lineNum", test.section.lineNum);
 
             currentTest = std::addressof (test);
+            output = con;
             test.start (con);
 
             DiagnosticMessageList errors;
@@ -512,6 +494,7 @@ namespace cmaj::test
 
             test.end();
             currentTest = nullptr;
+            output = nullptr;
         }
 
         std::shared_ptr<javascript::JavascriptEngine> javascriptEngine;
@@ -519,7 +502,7 @@ namespace cmaj::test
     private:
         //==============================================================================
         std::filesystem::path testFile;
-        std::ostream& output;
+        std::ostream* output = nullptr;
         TestSuite::TestCase* currentTest = nullptr;
         choc::value::Value currentSectionInfo, defaultEngineOptions;
 
@@ -655,17 +638,17 @@ namespace cmaj::test
             CMAJ_ASSERT (currentTest != nullptr);
             auto errorText = args.get<std::string> (0);
 
-            if (! errorText.empty())
+            if (! errorText.empty() && output != nullptr)
             {
                 try
                 {
                     auto lineNum = currentTest->section.lineNum + std::stol (errorText);
                     errorText = errorText.substr (errorText.find (":"));
-                    output << testFile << ":" << lineNum << errorText << std::endl;
+                    *output << testFile << ":" << lineNum << errorText << std::endl;
                 }
                 catch (std::invalid_argument&)
                 {
-                    output << testFile << ":" << errorText << std::endl;
+                    *output << testFile << ":" << errorText << std::endl;
                 }
             }
 
@@ -980,11 +963,9 @@ function getEngineName()                             { return _getEngineName();
                                      bool runDisabled, const choc::value::Value& engineOptions,
                                      std::string testScriptPath)
     {
-        console << thickDivider << std::endl
-                << "Running: " << std::filesystem::path (filename).filename().string() << "   (" << filename << ")" << std::endl
-                << std::endl;
+        printHeader (console);
 
-        TestJavascriptEngine testEngine (buildSettings, *this, console, engineOptions, testScriptPath);
+        TestJavascriptEngine testEngine (buildSettings, *this, engineOptions, testScriptPath);
 
         for (auto& test : tests)
         {
@@ -995,6 +976,105 @@ function getEngineName()                             { return _getEngineName();
         }
     }
 
+    //==============================================================================
+    /// Runs the individual test cases from a set of suites on a pool of worker threads.
+    /// Whenever a worker is idle it takes the next case that hasn't been started, so a
+    /// single large file gets spread across all the threads rather than running on one.
+    /// Each worker keeps its javascript engine alive while it's running cases from the
+    /// same suite, and the output of each case is captured separately so that the caller
+    /// can print the results in their original order.
+    struct TestCaseScheduler
+    {
+        TestCaseScheduler (const std::vector<std::unique_ptr<TestSuite>>& testSuites,
+                           uint32_t numThreads,
+                           const cmaj::BuildSettings& buildSettingsToUse,
+                           bool shouldRunDisabled,
+                           const choc::value::Value& engineOptionsToUse,
+                           std::string testScriptPathToUse)
+            : buildSettings (buildSettingsToUse), runDisabled (shouldRunDisabled),
+              engineOptions (engineOptionsToUse), testScriptPath (std::move (testScriptPathToUse))
+        {
+            for (auto& suite : testSuites)
+                for (auto& test : suite->tests)
+                    items.push_back (std::make_unique<WorkItem> (*suite, test));
+
+            auto numWorkers = std::min (static_cast<size_t> (numThreads), items.size());
+
+            for (size_t i = 0; i < numWorkers; ++i)
+                workers.emplace_back ([this] { runWorker(); });
+        }
+
+        ~TestCaseScheduler()
+        {
+            shouldStop = true;
+
+            for (auto& w : workers)
+                w.join();
+        }
+
+        size_t getNumTestCases() const                      { return items.size(); }
+
+        /// Returns the future which will provide the console output of the test case
+        /// with this index, in the order that the suites and their tests were given
+        std::future<std::string>& getResult (size_t index)  { return items[index]->output; }
+
+    private:
+        struct WorkItem
+        {
+            WorkItem (TestSuite& s, TestSuite::TestCase& t) : suite (s), test (t), output (result.get_future()) {}
+
+            TestSuite& suite;
+            TestSuite::TestCase& test;
+            std::promise<std::string> result;
+            std::future<std::string> output;
+        };
+
+        const cmaj::BuildSettings& buildSettings;
+        const bool runDisabled;
+        const choc::value::Value& engineOptions;
+        const std::string testScriptPath;
+
+        std::vector<std::unique_ptr<WorkItem>> items;
+        std::atomic<size_t> nextItem { 0 };
+        std::atomic<bool> shouldStop { false };
+        std::vector<std::thread> workers;
+
+        void runWorker()
+        {
+            std::unique_ptr<TestJavascriptEngine> engine;
+            const TestSuite* engineSuite = nullptr;
+
+            while (! shouldStop)
+            {
+                auto index = nextItem++;
+
+                if (index >= items.size())
+                    break;
+
+                auto& item = *items[index];
+
+                try
+                {
+                    if (engineSuite != std::addressof (item.suite))
+                    {
+                        engine.reset();
+                        engineSuite = nullptr;
+                        engine = std::make_unique<TestJavascriptEngine> (buildSettings, item.suite, engineOptions, testScriptPath);
+                        engineSuite = std::addressof (item.suite);
+                    }
+
+                    std::ostringstream testOutput;
+                    engine->runTest (std::addressof (testOutput), item.test, runDisabled);
+                    item.result.set_value (testOutput.str());
+                }
+                catch (...)
+                {
+                    item.result.set_exception (std::current_exception());
+                }
+            }
+        }
+    };
+
     //==============================================================================
     static void runSuites (const std::vector<std::unique_ptr<TestSuite>>& testSuites,
                            const cmaj::BuildSettings& buildSettings,
@@ -1009,46 +1089,8 @@ function getEngineName()                             { return _getEngineName();
     {
         if (threadLimit > 1 && ! testToRun.has_value())
         {
-            ThreadPool pool (threadLimit);
-
-            std::vector<std::future<std::string>> futures;
-            size_t totalNumTests = 0;
-
-            if (testSuites.size() == 1)
-            {
-                auto& suite = *testSuites.front();
-
-                for (int testIndex = 0; testIndex < (int) suite.tests.size(); ++testIndex)
-                {
-                    futures.emplace_back (std::async (std::launch::async,
-                                                      [&suite, testIndex, &pool, &buildSettings,
-                                                       runDisabled, &engineOptions, testScriptPath] () -> std::string
-                                                      {
-                                                          ThreadAllocator allocateThread (pool);
-                                                          std::ostringstream testOutput;
-                                                          suite.runTests (testOutput, buildSettings, testIndex + 1, runDisabled, engineOptions, testScriptPath);
-                                                          return testOutput.str();
-                                                      }));
-
-                    ++totalNumTests;
-                }
-            }
-            else
-            {
-                for (auto& suite : testSuites)
-                {
-                    futures.emplace_back (std::async (std::launch::async,
-                                                      [&] () -> std::string
-                                                      {
-                                                          ThreadAllocator allocateThread (pool);
-                                                          std::ostringstream testOutput;
-                                                          suite->runTests (testOutput, buildSettings, {}, runDisabled, engineOptions, testScriptPath);
-                                                          return testOutput.str();
-                                                      }));
-
-                    totalNumTests += suite->tests.size();
-                }
-            }
+            TestCaseScheduler scheduler (testSuites, threadLimit, buildSettings, runDisabled, engineOptions, testScriptPath);
+            auto totalNumTests = scheduler.getNumTestCases();
 
             if (showProgressBar)
             {
@@ -1056,8 +1098,18 @@ function getEngineName()                             { return _getEngineName();
 
                 auto printBar = [&]
                 {
-                    auto totalResults = TestResult::getTotal (testSuites);
-                    auto percentage = (totalResults.getNumComplete() * 100) / totalNumTests;
+                    // only the atomic counters are read here, as the tests may still be running
+                    int passed = 0, failed = 0;
+                    size_t numComplete = 0;
+
+                    for (auto& suite : testSuites)
+                    {
+                        passed += suite->passed;
+                        failed += suite->failed;
+                        numComplete += static_cast<size_t> (suite->passed + suite->failed + suite->disabled + suite->unsupported);
+                    }
+
+                    auto percentage = totalNumTests == 0 ? 100 : (numComplete * 100) / totalNumTests;
 
                     if (lastPercentage != percentage)
                     {
@@ -1069,18 +1121,18 @@ function getEngineName()                             { return _getEngineName();
                         std::cout << "\x1b[1000DRunning tests:  "
                                     << std::string (barSize, '#') << std::string (barLength - barSize, '.')
                                     << "  " << percentage << "%  "
-                                    << "  pass: " << totalResults.passed
-                                    << "  fail: " << totalResults.failed
+                                    << "  pass: " << passed
+                                    << "  fail: " << failed
                                     << "  "
                                     << std::flush;
                     }
                 };
 
-                for (auto& f : futures)
+                for (size_t i = 0; i < totalNumTests; ++i)
                 {
                     for (;;)
                     {
-                        if (f.wait_for (std::chrono::milliseconds (100)) == std::future_status::ready)
+                        if (scheduler.getResult (i).wait_for (std::chrono::milliseconds (100)) == std::future_status::ready)
                             break;
 
                         printBar();
@@ -1092,12 +1144,21 @@ function getEngineName()                             { return _getEngineName();
             }
             else
             {
-                for (auto& f : futures)
-                {
-                    f.wait();
+                size_t index = 0;
 
+                for (auto& suite : testSuites)
+                {
                     if (! printOnlyErrors)
-                        output << f.get();
+                        suite->printHeader (output);
+
+                    for (size_t i = 0; i < suite->tests.size(); ++i)
+                    {
+                        auto& result = scheduler.getResult (index++);
+                        result.wait();
+
+                        if (! printOnlyErrors)
+                            output << result.get();
+                    }
                 }
             }
         }
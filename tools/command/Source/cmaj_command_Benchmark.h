@@ -0,0 +1,391 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#pragma once
+
+#include "../../../include/cmajor/API/cmaj_Engine.h"
+#include "../../../include/cmajor/helpers/cmaj_PatchManifest.h"
+#include "../../../include/cmajor/helpers/cmaj_InMemoryCacheDatabase.h"
+
+#if (defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86)))
+ #include <intrin.h>
+ #define CMAJ_BENCHMARK_HAS_CYCLE_COUNTER 1
+#elif (defined (__x86_64__) || defined (__i386__))
+ #include <x86intrin.h>
+ #define CMAJ_BENCHMARK_HAS_CYCLE_COUNTER 1
+#else
+ #define CMAJ_BENCHMARK_HAS_CYCLE_COUNTER 0
+#endif
+
+namespace cmaj::benchmark
+{
+
+//==============================================================================
+struct BenchmarkOptions
+{
+    void parseArguments (choc::ArgumentList& args)
+    {
+        if (auto rate = args.removeIntValue<uint32_t> ("--rate"))
+            frequency = *rate;
+
+        if (auto size = args.removeIntValue<uint32_t> ("--blockSize"))
+            blockSize = *size;
+
+        if (auto n = args.removeIntValue<uint32_t> ("--blocks"))
+            numBlocks = *n;
+
+        if (auto n = args.removeIntValue<uint32_t> ("--iterations"))
+            buildIterations = std::max (1u, *n);
+
+        if (auto output = args.removeValueFor ("--output"))
+            outputFile = *output;
+
+        auto files = args.getAllAsExistingFiles();
+
+        if (files.size() != 1 || files[0].extension() != ".cmajorpatch")
+            throw std::runtime_error ("Expected a .cmajorpatch file");
+
+        patchFile = files[0];
+    }
+
+    std::filesystem::path patchFile;
+    std::string outputFile;
+    uint32_t frequency = 44100, blockSize = 512, numBlocks = 2000, buildIterations = 3;
+};
+
+//==============================================================================
+inline uint64_t readCycleCounter()
+{
+   #if CMAJ_BENCHMARK_HAS_CYCLE_COUNTER
+    return static_cast<uint64_t> (__rdtsc());
+   #else
+    return 0;
+   #endif
+}
+
+template <typename Fn>
+double timeInMilliseconds (Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start).count();
+}
+
+inline double getPercentile (const std::vector<double>& sortedValues, double percentile)
+{
+    if (sortedValues.empty())
+        return 0;
+
+    auto index = static_cast<size_t> (percentile * static_cast<double> (sortedValues.size() - 1) + 0.5);
+    return sortedValues[std::min (index, sortedValues.size() - 1)];
+}
+
+inline double getMedian (std::vector<double> values)
+{
+    std::sort (values.begin(), values.end());
+    return getPercentile (values, 0.5);
+}
+
+//==============================================================================
+struct Benchmark
+{
+    Benchmark (const BenchmarkOptions& o, const choc::value::Value& engineOptionsToUse, const BuildSettings& settings)
+        : options (o), engineOptions (engineOptionsToUse), buildSettings (settings)
+    {
+        if (engineOptions.isObject() && engineOptions.hasObjectMember ("engine"))
+            engineType = engineOptions["engine"].getString();
+
+        buildSettings.setFrequency (options.frequency)
+                     .setMaxBlockSize (options.blockSize);
+
+        manifest.initialiseWithFile (options.patchFile);
+    }
+
+    choc::value::Value run()
+    {
+        // this needs to come first, so that it sees the first program that the process loads
+        auto standardLibraryTimes = measureStandardLibraryLoading();
+
+        // the caches just keep everything in memory, so that cold and warm builds can
+        // be compared without touching the filesystem
+        auto cache = choc::com::create<InMemoryCacheDatabase>();
+        std::vector<double> coldParse, coldLoad, coldLink, warmParse, warmLoad, warmLink;
+
+        for (uint32_t i = 0; i < options.buildIterations; ++i)
+        {
+            auto emptyCache = choc::com::create<InMemoryCacheDatabase>();
+            build (emptyCache.get(), coldParse, coldLoad, coldLink);
+        }
+
+        // prime the shared cache once, then time the builds which can use it
+        build (cache.get(), warmParse, warmLoad, warmLink);
+        warmParse.clear(); warmLoad.clear(); warmLink.clear();
+
+        for (uint32_t i = 0; i < options.buildIterations; ++i)
+            build (cache.get(), warmParse, warmLoad, warmLink);
+
+        auto buildTimes = [] (const std::vector<double>& parse, const std::vector<double>& load, const std::vector<double>& link)
+        {
+            return choc::json::create ("parseMs", getMedian (parse),
+                                       "loadMs",  getMedian (load),
+                                       "linkMs",  getMedian (link));
+        };
+
+        return choc::json::create ("patch",          options.patchFile.string(),
+                                   "cmajorVersion",  std::string (Library::getVersion()),
+                                   "engine",         engineType.empty() ? std::string ("llvm") : engineType,
+                                   "frequency",      static_cast<int32_t> (options.frequency),
+                                   "blockSize",      static_cast<int32_t> (options.blockSize),
+                                   "build",          choc::json::create ("cold", buildTimes (coldParse, coldLoad, coldLink),
+                                                                         "warm", buildTimes (warmParse, warmLoad, warmLink)),
+                                   "standardLibrary", standardLibraryTimes,
+                                   "render",         measureRendering (cache.get()));
+    }
+
+private:
+    const BenchmarkOptions& options;
+    choc::value::Value engineOptions;
+    BuildSettings buildSettings;
+    std::string engineType;
+    PatchManifest manifest;
+
+    Engine createEngine()
+    {
+        auto engine = Engine::create (engineType, &engineOptions);
+
+        if (! engine)
+            throw std::runtime_error ("Couldn't create an engine of type '" + engineType + "'");
+
+        auto settings = buildSettings;
+
+        if (! manifest.mainProcessor.empty())
+            settings.setMainProcessor (manifest.mainProcessor);
+
+        engine.setBuildSettings (settings);
+        return engine;
+    }
+
+    static void checkMessages (const DiagnosticMessageList& messages)
+    {
+        if (messages.hasErrors())
+            throw std::runtime_error (messages.toString());
+    }
+
+    void build (CacheDatabaseInterface* cache, std::vector<double>& parseTimes,
+                  std::vector<double>& loadTimes, std::vector<double>& linkTimes)
+    {
+        DiagnosticMessageList messages;
+        Program program;
+        auto engine = createEngine();
+
+        parseTimes.push_back (timeInMilliseconds ([&] { manifest.addSourceFilesToProgram (program, messages, [] {}); }));
+        checkMessages (messages);
+
+        loadTimes.push_back (timeInMilliseconds ([&] { engine.load (messages, program, manifest.createExternalResolverFunction(), {}); }));
+        checkMessages (messages);
+
+        linkTimes.push_back (timeInMilliseconds ([&] { engine.link (messages, cache); }));
+        checkMessages (messages);
+    }
+
+    /// Loading a trivial program is dominated by giving it a copy of the standard library
+    /// and resolving it. The first load in a process also has to create the shared copy that
+    /// later programs are cloned from, so the difference between the first and later loads
+    /// shows how much each subsequent engine saves.
+    choc::value::Value measureStandardLibraryLoading()
+    {
+        std::vector<double> loadTimes;
+
+        for (uint32_t i = 0; i <= options.buildIterations; ++i)
+        {
+            DiagnosticMessageList messages;
+            Program program;
+            program.parse (messages, "", "processor Minimal { output stream float out; void main() { loop advance(); } }");
+            checkMessages (messages);
+
+            auto engine = Engine::create (engineType, &engineOptions);
+
+            if (! engine)
+                throw std::runtime_error ("Couldn't create an engine of type '" + engineType + "'");
+
+            engine.setBuildSettings (BuildSettings (buildSettings).setMainProcessor ("Minimal"));
+
+            loadTimes.push_back (timeInMilliseconds ([&] { engine.load (messages, program, {}, {}); }));
+            checkMessages (messages);
+        }
+
+        auto firstLoad = loadTimes.front();
+        loadTimes.erase (loadTimes.begin());
+
+        return choc::json::create ("firstLoadMs", firstLoad,
+                                   "loadMs",      getMedian (loadTimes));
+    }
+
+    struct StreamBuffer
+    {
+        EndpointHandle handle;
+        std::vector<uint8_t> data;
+    };
+
+    choc::value::Value measureRendering (CacheDatabaseInterface* cache)
+    {
+        DiagnosticMessageList messages;
+        Program program;
+        auto engine = createEngine();
+
+        manifest.addSourceFilesToProgram (program, messages, [] {});
+        engine.load (messages, program, manifest.createExternalResolverFunction(), {});
+        checkMessages (messages);
+
+        std::vector<StreamBuffer> inputs, outputs;
+
+        auto addStreams = [&] (const EndpointDetailsList& endpoints, std::vector<StreamBuffer>& buffers)
+        {
+            for (auto& e : endpoints)
+                if (e.isStream())
+                    buffers.push_back ({ engine.getEndpointHandle (e.endpointID),
+                                         std::vector<uint8_t> (e.dataTypes.front().getValueDataSize() * options.blockSize) });
+        };
+
+        addStreams (engine.getInputEndpoints(), inputs);
+        addStreams (engine.getOutputEndpoints(), outputs);
+
+        engine.link (messages, cache);
+        checkMessages (messages);
+
+        auto performer = engine.createPerformer();
+
+        if (! performer)
+            throw std::runtime_error ("Failed to create a performer");
+
+        performer.setBlockSize (options.blockSize);
+
+        auto renderBlock = [&]
+        {
+            for (auto& i : inputs)
+                performer.setInputFrames (i.handle, i.data.data(), options.blockSize);
+
+            performer.advance();
+
+            for (auto& o : outputs)
+                performer.copyOutputFrames (o.handle, o.data.data(), options.blockSize);
+        };
+
+        // warm up the caches and branch predictors before measuring
+        for (uint32_t i = 0; i < std::min (100u, options.numBlocks); ++i)
+            renderBlock();
+
+        std::vector<double> blockTimes;
+        blockTimes.reserve (options.numBlocks);
+        uint64_t totalCycles = 0;
+        double totalMicroseconds = 0;
+
+        auto warmUpNodeCounters = performer.getNodeProfileCounters();
+        std::vector<NodeProfileCounter> nodeCountersBefore (warmUpNodeCounters.begin(), warmUpNodeCounters.end());
+
+        for (uint32_t i = 0; i < options.numBlocks; ++i)
+        {
+            auto startCycles = readCycleCounter();
+            auto microseconds = timeInMilliseconds (renderBlock) * 1000.0;
+            totalCycles += readCycleCounter() - startCycles;
+            totalMicroseconds += microseconds;
+            blockTimes.push_back (microseconds);
+        }
+
+        std::sort (blockTimes.begin(), blockTimes.end());
+
+        auto totalFrames = static_cast<double> (options.numBlocks) * options.blockSize;
+        auto blockDurationMicroseconds = 1.0e6 * options.blockSize / options.frequency;
+        auto p99 = getPercentile (blockTimes, 0.99);
+
+        auto result = choc::json::create ("numBlocks",              static_cast<int32_t> (options.numBlocks),
+                                          "blockTimeMicroseconds",  choc::json::create ("p50",  getPercentile (blockTimes, 0.5),
+                                                                                        "p99",  p99,
+                                                                                        "max",  blockTimes.empty() ? 0.0 : blockTimes.back(),
+                                                                                        "mean", totalMicroseconds / std::max (1u, options.numBlocks)),
+                                          "framesPerSecond",        totalMicroseconds > 0 ? totalFrames * 1.0e6 / totalMicroseconds : 0.0,
+                                          "realtimeLoadAtP99",      p99 / blockDurationMicroseconds,
+                                          "xruns",                  static_cast<int32_t> (performer.getXRuns()));
+
+        if (CMAJ_BENCHMARK_HAS_CYCLE_COUNTER && totalFrames > 0)
+            result.addMember ("cyclesPerFrame", static_cast<double> (totalCycles) / totalFrames);
+
+        if (auto nodeCounters = performer.getNodeProfileCounters(); ! nodeCounters.empty())
+            result.addMember ("nodes", getNodeBreakdown (engine.getProgramDetails()["profiledNodes"], nodeCountersBefore, nodeCounters));
+
+        return result;
+    }
+
+    /// When the patch was built with the profileNodes option, this lists the cycles used by
+    /// each node of the main graph during the measured blocks, busiest first.
+    static choc::value::Value getNodeBreakdown (const choc::value::ValueView& nodeNames,
+                                                const std::vector<NodeProfileCounter>& before,
+                                                choc::span<const NodeProfileCounter> after)
+    {
+        struct NodeCycles
+        {
+            std::string name;
+            uint64_t cycles, frames;
+        };
+
+        std::vector<NodeCycles> nodes;
+        uint64_t totalCycles = 0;
+
+        for (size_t i = 0; i < after.size(); ++i)
+        {
+            auto startCycles = i < before.size() ? before[i].totalCycles : 0;
+            auto startFrames = i < before.size() ? before[i].numCalls : 0;
+
+            nodes.push_back ({ nodeNames.isArray() && i < nodeNames.size() ? nodeNames[static_cast<uint32_t> (i)].toString() : std::string(),
+                               after[i].totalCycles - startCycles,
+                               after[i].numCalls - startFrames });
+
+            totalCycles += nodes.back().cycles;
+        }
+
+        std::sort (nodes.begin(), nodes.end(), [] (const NodeCycles& a, const NodeCycles& b) { return a.cycles > b.cycles; });
+
+        auto result = choc::value::createEmptyArray();
+
+        for (auto& n : nodes)
+            result.addArrayElement (choc::json::create ("name",           n.name,
+                                                        "cyclesPerFrame", n.frames != 0 ? static_cast<double> (n.cycles) / static_cast<double> (n.frames) : 0.0,
+                                                        "proportion",     totalCycles != 0 ? static_cast<double> (n.cycles) / static_cast<double> (totalCycles) : 0.0));
+
+        return result;
+    }
+};
+
+} // namespace cmaj::benchmark
+
+//==============================================================================
+inline void runBenchmark (choc::ArgumentList& args,
+                          const choc::value::Value& engineOptions,
+                          cmaj::BuildSettings& buildSettings)
+{
+    cmaj::benchmark::BenchmarkOptions options;
+    options.parseArguments (args);
+
+    auto results = cmaj::benchmark::Benchmark (options, engineOptions, buildSettings).run();
+    auto json = choc::json::toString (results, true);
+
+    if (options.outputFile.empty())
+        std::cout << json << std::endl;
+    else
+        choc::file::replaceFileWithContent (options.outputFile, json);
+}
@@ -31,6 +31,12 @@ struct RenderOptions
         if (args.size() == 0)
             throw std::runtime_error ("Expected a filename to play");
 
+        if (auto batch = args.removeExistingFileIfPresent ("--batch"))
+            batchFile = batch->string();
+
+        if (auto threads = args.removeIntValue<uint32_t> ("--threads"))
+            numThreads = *threads;
+
         if (auto input = args.removeExistingFileIfPresent ("--input"))
             inputAudioFile = input->string();
 
@@ -56,7 +62,8 @@ struct RenderOptions
         else
             audioOptions.blockSize = 512;
 
-        outputAudioFile = args.removeExistingFile ("--output").string();
+        if (batchFile.empty())
+            outputAudioFile = args.removeExistingFile ("--output").string();
 
         auto files = args.getAllAsExistingFiles();
 
@@ -66,9 +73,10 @@ struct RenderOptions
         patchFile = files[0].string();
     }
 
-    std::string patchFile, inputAudioFile, inputMIDIFile, outputAudioFile;
+    std::string patchFile, inputAudioFile, inputMIDIFile, outputAudioFile, batchFile;
     cmaj::audio_utils::AudioDeviceOptions audioOptions;
     uint64_t framesToRender = 0;
+    uint32_t numThreads = 0;
 };
 
 
@@ -86,11 +94,13 @@ struct RenderState
 
         if (! options.inputAudioFile.empty())
         {
-            reader = cmaj::audio_utils::createFileReader (options.inputAudioFile);
+            auto fileReader = cmaj::audio_utils::createFileReader (options.inputAudioFile);
 
-            if (reader == nullptr)
+            if (fileReader == nullptr)
                 throw std::runtime_error ("Couldn't open input file");
 
+            reader = std::make_unique<cmaj::audio_utils::ReadAheadAudioFileReader> (std::move (fileReader));
+
             auto numFrames = reader->getProperties().numFrames;
             auto numChannels = reader->getProperties().numChannels;
 
@@ -132,12 +142,15 @@ struct RenderState
 
         sampleRate = static_cast<double> (audioOptions.sampleRate);
 
-        writer = cmaj::audio_utils::createFileWriter (options.outputAudioFile, sampleRate,
-                                                      audioOptions.outputChannelCount);
+        auto fileWriter = cmaj::audio_utils::createFileWriter (options.outputAudioFile, sampleRate,
+                                                               audioOptions.outputChannelCount);
 
-        if (writer == nullptr)
+        if (fileWriter == nullptr)
             throw std::runtime_error ("Couldn't open output file");
 
+        writer = std::make_unique<cmaj::audio_utils::WriteBehindAudioFileWriter> (std::move (fileWriter),
+                                                                                  audioOptions.outputChannelCount);
+
         audioOptions.provideInput = [this] (choc::buffer::ChannelArrayView<float> audioInput,
                                             std::vector<choc::midi::ShortMessage>& midiMessages,
                                             std::vector<uint32_t>& midiMessageTimes) -> bool
@@ -180,7 +193,7 @@ struct RenderState
 
         if (reader != nullptr)
         {
-            if (! reader->readFrames (framesRendered, audioInput))
+            if (! reader->readNextFrames (audioInput))
             {
                 std::cerr << "Failed to read from audio input" << std::endl;
                 stopped = true;
@@ -226,6 +239,13 @@ struct RenderState
     {
         while (! stopped)
             std::this_thread::sleep_for (std::chrono::milliseconds (10));
+
+        // The render thread may still be appending its last block, so it has to be
+        // stopped before the file can be finished
+        patchPlayer.stopPlayback();
+
+        if (! writer->finish())
+            throw std::runtime_error ("Failed to write to audio output");
     }
 
     std::atomic<bool> stopped { true };
@@ -234,20 +254,460 @@ struct RenderState
 
     cmaj::PatchPlayer patchPlayer;
 
-    std::unique_ptr<choc::audio::AudioFileReader> reader;
-    std::unique_ptr<choc::audio::AudioFileWriter> writer;
+    // The file i/o happens on background threads, so the render loop only copies to and from memory
+    std::unique_ptr<cmaj::audio_utils::ReadAheadAudioFileReader> reader;
+    std::unique_ptr<cmaj::audio_utils::WriteBehindAudioFileWriter> writer;
 
     choc::midi::Sequence inputMIDI;
     choc::midi::Sequence::Iterator inputMIDIIterator { inputMIDI };
 };
 
 
+//==============================================================================
+/// One entry from a batch manifest. Any relative paths are resolved against the
+/// folder containing the manifest.
+struct BatchRenderJob
+{
+    std::string inputAudioFile, inputMIDIFile, outputAudioFile;
+    choc::value::Value parameters;
+    uint64_t framesToRender = 0;
+};
+
+/// A batch manifest is a JSON array of objects, each of which can contain the
+/// properties "input", "midi", "parameters", "length" and (required) "output".
+inline std::vector<BatchRenderJob> loadBatchManifest (const std::string& manifestFile)
+{
+    auto json = choc::json::parse (choc::file::loadFileAsString (manifestFile));
+
+    if (! json.isArray())
+        throw std::runtime_error ("Expected the batch manifest to contain an array of jobs");
+
+    auto folder = std::filesystem::path (manifestFile).parent_path();
+
+    auto getPath = [&] (const choc::value::ValueView& job, std::string_view name) -> std::string
+    {
+        if (! job.hasObjectMember (name))
+            return {};
+
+        auto path = std::filesystem::path (std::string (job[name].getString()));
+        return (path.is_absolute() ? path : folder / path).string();
+    };
+
+    std::vector<BatchRenderJob> jobs;
+
+    for (uint32_t i = 0; i < json.size(); ++i)
+    {
+        auto job = json[i];
+
+        if (! job.isObject())
+            throw std::runtime_error ("Expected each job in the batch manifest to be an object");
+
+        BatchRenderJob newJob;
+        newJob.inputAudioFile  = getPath (job, "input");
+        newJob.inputMIDIFile   = getPath (job, "midi");
+        newJob.outputAudioFile = getPath (job, "output");
+
+        if (newJob.outputAudioFile.empty())
+            throw std::runtime_error ("Job " + std::to_string (i + 1) + " in the batch manifest has no output file");
+
+        if (job.hasObjectMember ("parameters"))
+            newJob.parameters = choc::value::Value (job["parameters"]);
+
+        if (job.hasObjectMember ("length"))
+        {
+            auto length = job["length"].getWithDefault<int64_t> (0);
+
+            if (length < 0)
+                throw std::runtime_error ("Illegal length");
+
+            newJob.framesToRender = static_cast<uint64_t> (length);
+        }
+
+        jobs.push_back (std::move (newJob));
+    }
+
+    return jobs;
+}
+
+//==============================================================================
+/// Renders a list of jobs through a patch as fast as possible. The patch is only
+/// built and linked once, and each worker thread then uses its own performer
+/// instance, which is reset between jobs, so there's no realtime device or
+/// pacing involved.
+struct BatchRenderer
+{
+    BatchRenderer (const RenderOptions& o,
+                   const choc::value::Value& engineOptionsToUse,
+                   const cmaj::BuildSettings& settings)
+        : options (o), engineOptions (engineOptionsToUse), buildSettings (settings)
+    {
+        jobs = loadBatchManifest (options.batchFile);
+
+        if (jobs.empty())
+            throw std::runtime_error ("The batch manifest doesn't contain any jobs");
+
+        if (engineOptions.isObject() && engineOptions.hasObjectMember ("engine"))
+            engineType = engineOptions["engine"].getString();
+
+        sampleRate = options.audioOptions.sampleRate;
+
+        // All the jobs share one linked program, so they all have to use the same rate.
+        // If none was given, take it from the first job that has an input file
+        if (sampleRate == 0)
+        {
+            for (auto& job : jobs)
+            {
+                if (! job.inputAudioFile.empty())
+                {
+                    if (auto reader = cmaj::audio_utils::createFileReader (job.inputAudioFile))
+                        sampleRate = static_cast<uint32_t> (reader->getProperties().sampleRate);
+
+                    break;
+                }
+            }
+        }
+
+        if (sampleRate == 0)
+            throw std::runtime_error ("If no input files are provided, use --rate=<rate> to specify the sample-rate");
+
+        blockSize = options.audioOptions.blockSize;
+        numOutputChannels = options.audioOptions.outputChannelCount;
+    }
+
+    void run()
+    {
+        std::cout << "Building: " << options.patchFile << std::endl;
+
+        buildEngine();
+
+        auto numThreads = options.numThreads != 0 ? options.numThreads
+                                                  : std::max (1u, std::thread::hardware_concurrency());
+        numThreads = std::min (numThreads, static_cast<uint32_t> (jobs.size()));
+
+        // The performers are all created up-front on this thread, so that the
+        // workers only ever touch their own instance
+        std::vector<std::unique_ptr<cmaj::AudioMIDIPerformer>> performers;
+
+        for (uint32_t i = 0; i < numThreads; ++i)
+            performers.push_back (createPerformer());
+
+        std::cout << "Rendering " << jobs.size() << " jobs using " << numThreads << " threads" << std::endl;
+
+        auto startTime = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+
+        for (auto& p : performers)
+            workers.emplace_back ([this, performer = p.get()] { renderJobs (*performer); });
+
+        for (auto& w : workers)
+            w.join();
+
+        auto seconds = std::chrono::duration<double> (std::chrono::steady_clock::now() - startTime).count();
+        auto secondsRendered = static_cast<double> (totalFramesRendered.load()) / sampleRate;
+
+        std::cout << "Rendered " << (jobs.size() - numFailedJobs) << " jobs (" << secondsRendered << " seconds of audio) in "
+                  << seconds << " seconds" << std::endl;
+
+        if (numFailedJobs != 0)
+            throw std::runtime_error (std::to_string (numFailedJobs.load()) + " of " + std::to_string (jobs.size()) + " jobs failed");
+    }
+
+private:
+    const RenderOptions& options;
+    choc::value::Value engineOptions;
+    cmaj::BuildSettings buildSettings;
+    std::string engineType;
+    std::vector<BatchRenderJob> jobs;
+
+    cmaj::Engine engine;
+    cmaj::EndpointDetailsList inputEndpoints, outputEndpoints;
+    uint32_t sampleRate = 0, blockSize = 0, numInputChannels = 0, numOutputChannels = 0;
+
+    std::atomic<size_t> nextJob { 0 };
+    std::atomic<uint32_t> numFailedJobs { 0 };
+    std::atomic<uint64_t> totalFramesRendered { 0 };
+    std::mutex logLock;
+
+    static constexpr uint32_t eventFIFOSize = 65536;
+    static constexpr uint32_t parameterTimeoutMilliseconds = 1000;
+
+    void buildEngine()
+    {
+        cmaj::PatchManifest manifest;
+        manifest.initialiseWithFile (options.patchFile);
+
+        engine = cmaj::Engine::create (engineType, &engineOptions);
+
+        if (! engine)
+            throw std::runtime_error ("Couldn't create an engine of type '" + engineType + "'");
+
+        auto settings = buildSettings;
+        settings.setFrequency (sampleRate)
+                .setMaxBlockSize (blockSize);
+
+        if (! manifest.mainProcessor.empty())
+            settings.setMainProcessor (manifest.mainProcessor);
+
+        engine.setBuildSettings (settings);
+
+        cmaj::DiagnosticMessageList messages;
+        cmaj::Program program;
+
+        if (! manifest.addSourceFilesToProgram (program, messages, [] {})
+             || ! engine.load (messages, program, manifest.createExternalResolverFunction(), {})
+             || ! engine.link (messages))
+            throw std::runtime_error (messages.toString());
+
+        inputEndpoints = engine.getInputEndpoints();
+        outputEndpoints = engine.getOutputEndpoints();
+
+        for (auto& e : inputEndpoints)
+            numInputChannels += e.getNumAudioChannels();
+    }
+
+    /// Uses the same channel layout as a patch being played through an audio device
+    std::unique_ptr<cmaj::AudioMIDIPerformer> createPerformer()
+    {
+        cmaj::AudioMIDIPerformer::Builder builder (engine, eventFIFOSize);
+        uint32_t inputChanIndex = 0, outputChanIndex = 0, totalOutputChans = 0;
+
+        for (auto& e : inputEndpoints)
+        {
+            if (auto numChans = e.getNumAudioChannels())
+            {
+                std::vector<uint32_t> inChans, endpointChans;
+
+                for (uint32_t i = 0; i < numChans; ++i)
+                {
+                    endpointChans.push_back (i);
+                    inChans.push_back (inputChanIndex++);
+                }
+
+                builder.connectAudioInputTo (inChans, e, endpointChans, {});
+            }
+            else if (e.isMIDI())
+            {
+                builder.connectMIDIInputTo (e);
+            }
+        }
+
+        for (auto& e : outputEndpoints)
+            totalOutputChans += e.getNumAudioChannels();
+
+        for (auto& e : outputEndpoints)
+        {
+            if (auto numChans = e.getNumAudioChannels())
+            {
+                std::vector<uint32_t> outChans, endpointChans;
+
+                // Handle mono -> stereo as a special case
+                if (totalOutputChans == 1 && numOutputChannels > 1)
+                {
+                    outChans = { 0, 1 };
+                    endpointChans = { 0, 0 };
+                }
+                else
+                {
+                    for (uint32_t i = 0; i < numChans && outputChanIndex < numOutputChannels; ++i)
+                    {
+                        endpointChans.push_back (i);
+                        outChans.push_back (outputChanIndex++);
+                    }
+                }
+
+                builder.connectAudioOutputTo (e, endpointChans, outChans, {});
+            }
+        }
+
+        auto performer = builder.createPerformer();
+
+        if (! performer->prepareToStart())
+            throw std::runtime_error ("Failed to create a performer");
+
+        return performer;
+    }
+
+    void renderJobs (cmaj::AudioMIDIPerformer& performer)
+    {
+        for (;;)
+        {
+            auto jobIndex = nextJob++;
+
+            if (jobIndex >= jobs.size())
+                return;
+
+            auto& job = jobs[jobIndex];
+
+            try
+            {
+                renderJob (performer, job);
+
+                std::lock_guard<std::mutex> lock (logLock);
+                std::cout << "Rendered: " << job.outputAudioFile << std::endl;
+            }
+            catch (const std::exception& e)
+            {
+                ++numFailedJobs;
+
+                std::lock_guard<std::mutex> lock (logLock);
+                std::cerr << "Failed to render " << job.outputAudioFile << ": " << e.what() << std::endl;
+            }
+        }
+    }
+
+    void renderJob (cmaj::AudioMIDIPerformer& performer, const BatchRenderJob& job)
+    {
+        std::unique_ptr<cmaj::audio_utils::ReadAheadAudioFileReader> reader;
+        auto framesToRender = job.framesToRender;
+
+        if (! job.inputAudioFile.empty())
+        {
+            auto fileReader = cmaj::audio_utils::createFileReader (job.inputAudioFile);
+
+            if (fileReader == nullptr)
+                throw std::runtime_error ("Couldn't open input file");
+
+            if (static_cast<uint32_t> (fileReader->getProperties().sampleRate) != sampleRate)
+                throw std::runtime_error ("The input file's sample-rate doesn't match the rate of the batch");
+
+            reader = std::make_unique<cmaj::audio_utils::ReadAheadAudioFileReader> (std::move (fileReader));
+
+            if (framesToRender == 0)
+                framesToRender = reader->getProperties().numFrames;
+        }
+
+        choc::midi::Sequence inputMIDI;
+
+        if (! job.inputMIDIFile.empty())
+        {
+            auto content = choc::file::loadFileAsString (job.inputMIDIFile);
+
+            choc::midi::File midi;
+            midi.load (content.data(), content.size());
+            inputMIDI = midi.toSequence();
+
+            if (framesToRender == 0 && ! inputMIDI.events.empty())
+                framesToRender = static_cast<uint64_t> (inputMIDI.events.back().timeStamp * sampleRate);
+        }
+
+        if (framesToRender == 0)
+            throw std::runtime_error ("Jobs with no input file must specify a length");
+
+        auto fileWriter = cmaj::audio_utils::createFileWriter (job.outputAudioFile, sampleRate, numOutputChannels);
+
+        if (fileWriter == nullptr)
+            throw std::runtime_error ("Couldn't open output file");
+
+        cmaj::audio_utils::WriteBehindAudioFileWriter writer (std::move (fileWriter), numOutputChannels);
+
+        performer.performer.reset();
+        applyParameters (performer, job.parameters);
+
+        choc::buffer::ChannelArrayBuffer<float> inputBuffer (numInputChannels, blockSize),
+                                                outputBuffer (numOutputChannels, blockSize);
+
+        inputBuffer.clear();
+
+        choc::midi::Sequence::Iterator midiIterator { inputMIDI };
+        std::vector<choc::midi::ShortMessage> midiMessages;
+        std::vector<int> midiMessageTimes;
+
+        for (uint64_t frame = 0; frame < framesToRender;)
+        {
+            auto numFrames = static_cast<choc::buffer::FrameCount> (std::min (static_cast<uint64_t> (blockSize), framesToRender - frame));
+            auto input = inputBuffer.getView().getStart (numFrames);
+            auto output = outputBuffer.getView().getStart (numFrames);
+
+            if (reader != nullptr && ! reader->readNextFrames (input))
+                throw std::runtime_error ("Failed to read from audio input");
+
+            midiMessages.clear();
+            midiMessageTimes.clear();
+
+            for (auto& midiEvent : midiIterator.readNextEvents (numFrames / static_cast<double> (sampleRate)))
+            {
+                if (midiEvent.message.isShortMessage())
+                {
+                    auto time = static_cast<int> (midiEvent.timeStamp * sampleRate - static_cast<double> (frame));
+                    midiMessages.push_back (midiEvent.message.getShortMessage());
+                    midiMessageTimes.push_back (std::clamp (time, 0, static_cast<int> (numFrames) - 1));
+                }
+            }
+
+            performer.processWithTimeStampedMIDI (input, output,
+                                                  midiMessages.data(), midiMessageTimes.data(),
+                                                  static_cast<uint32_t> (midiMessages.size()),
+                                                  [] (uint32_t, choc::midi::ShortMessage) {}, true);
+
+            if (! writer.appendFrames (output))
+                throw std::runtime_error ("Failed to write to audio output");
+
+            frame += numFrames;
+        }
+
+        if (! writer.finish())
+            throw std::runtime_error ("Failed to write to audio output");
+
+        totalFramesRendered += framesToRender;
+    }
+
+    /// Every parameter is set, either to the job's value or its default, so that
+    /// nothing leaks through from whichever job the performer rendered previously.
+    void applyParameters (cmaj::AudioMIDIPerformer& performer, const choc::value::Value& values)
+    {
+        for (auto& e : inputEndpoints)
+        {
+            if (e.isParameter())
+            {
+                cmaj::PatchParameterProperties properties (e);
+                auto id = e.endpointID.toString();
+                auto value = values.isObject() && values.hasObjectMember (id)
+                                ? properties.snapAndConstrainValue (properties.parseValue (values[id]))
+                                : properties.defaultValue;
+
+                if (! performer.postEventOrValue (e.endpointID, choc::value::createFloat32 (value), 0, parameterTimeoutMilliseconds))
+                    throw std::runtime_error ("Failed to set parameter " + id);
+            }
+        }
+
+        if (values.isObject())
+        {
+            for (uint32_t i = 0; i < values.size(); ++i)
+            {
+                auto member = values.getObjectMemberAt (i);
+                auto endpoint = findInputEndpoint (member.name);
+
+                if (endpoint == nullptr)
+                    throw std::runtime_error ("Unknown endpoint " + std::string (member.name));
+
+                // values for anything that isn't a parameter are passed through as-is
+                if (! endpoint->isParameter()
+                     && ! performer.postEventOrValue (endpoint->endpointID, member.value, 0, parameterTimeoutMilliseconds))
+                    throw std::runtime_error ("Failed to send a value to " + std::string (member.name));
+            }
+        }
+    }
+
+    const cmaj::EndpointDetails* findInputEndpoint (std::string_view endpointID) const
+    {
+        for (auto& e : inputEndpoints)
+            if (e.endpointID.toString() == endpointID)
+                return std::addressof (e);
+
+        return {};
+    }
+};
+
+
 //==============================================================================
 void render (choc::ArgumentList& args, const choc::value::Value& engineOptions, cmaj::BuildSettings& buildSettings)
 {
     RenderOptions options;
     options.parseArguments (args);
 
+    if (! options.batchFile.empty())
+        return BatchRenderer (options, engineOptions, buildSettings).run();
+
     choc::messageloop::initialise();
 
     std::optional<std::exception> exceptionThrown;
@@ -28,6 +28,7 @@
 #include "cmaj_command_Render.h"
 #include "cmaj_command_CreatePatch.h"
 #include "cmaj_command_RunTests.h"
+#include "cmaj_command_Benchmark.h"
 #include "cmaj_RtAudioPlayer.h"
 
 void runUnitTests (choc::ArgumentList&, const choc::value::Value&, cmaj::BuildSettings&);
@@ -70,6 +71,7 @@ cmaj <command> [options]    Runs the given command. Options can include the foll
     --debug                 Turn on debug output from the performer
     --sessionID=n           Set the session id to the given value
     --eventBufferSize=n     Set the max number of events per buffer
+    --profileNodes          Instrument the main graph's nodes to report their CPU usage
     --engine=<type>         Use the specified engine - e.g. llvm, webview, cpp
     --simd                  WASM generation uses SIMD/non-SIMD at runtime (default)
     --no-simd               WASM generation does not emit SIMD
@@ -94,12 +96,14 @@ cmaj play file [opts]       Plays a .cmajorpatch, or executes a .js javascript f
                             any errors that are found, and exits
     --rate=<rate>           Use the specified sample rate
     --block-size=<size>     Request the given block size
+    --render-threads=n      Render multiple patches in parallel using n threads
 
 cmaj server [opts] dir      Run cmaj as an http service, serving the patches within the given
                             directory. Connect to the server using a browser to the http address
                             given
 
     --address=<addr>:<port> Serve from the specified address, defaults to 127.0.0.1:51000
+    --render-threads=n      Render the patches of different sessions in parallel using n threads
 
 cmaj test [opts] <files>    Runs one or more .cmajtest scripts, and print the aggregate results
                             for the tests. See the documentation for writing tests for more info.
@@ -120,6 +124,22 @@ cmaj render [opts] <file>   Renders the given file or patch
     --output=<file>         Write the output to the given file
     --input=<file>          Use input from the given file
     --midi=<file>           Use input MIDI data from the given file
+    --batch=<file>          Render all the jobs listed in the given JSON file, building the patch
+                            only once. Each job is an object with an "output" file, and optional
+                            "input", "midi", "length" and "parameters" properties
+    --threads=n             The number of jobs to render in parallel when using --batch, defaults
+                            to the available cores
+
+cmaj benchmark [opts] <file>
+                            Measures the build times and rendering performance of a patch,
+                            and prints the results as JSON. If --profileNodes is used, the
+                            results include a breakdown of the cycles used by each node
+
+    --rate=<rate>           Use the specified sample rate (default 44100)
+    --blockSize=<size>      Render in the given block size (default 512)
+    --blocks=n              The number of blocks to time (default 2000)
+    --iterations=n          How many cold and warm builds to time (default 3)
+    --output=<file>         Write the JSON results to the given file
 
 cmaj generate [opts] <file> Generates some code from the given file or patch
 
@@ -169,6 +189,9 @@ static cmaj::BuildSettings parseBuildArgs (choc::ArgumentList& args)
     if (auto bufferSize = args.removeIntValue<uint32_t> ("--eventBufferSize"))
         buildSettings.setEventBufferSize (*bufferSize);
 
+    if (args.removeIfFound ("--profileNodes"))
+        buildSettings.setProfileNodes (true);
+
     return buildSettings;
 }
 
@@ -189,6 +212,8 @@ static cmaj::audio_utils::AudioDeviceOptions parseAudioDeviceArgs (choc::Argumen
     options.outputDeviceName = args.removeValueFor ("--output-device", {});
     options.inputDeviceName  = args.removeValueFor ("--input-device", {});
 
+    options.numClientRenderThreads = args.removeIntValue<uint32_t> ("--render-threads", 0);
+
     options.createPlayer = cmaj::RtAudioMIDIPlayer::create;
 
     return options;
@@ -252,6 +277,7 @@ static void performCommandLineTask (choc::ArgumentList& args)
     if (isCommand (args, "generate"))  return generate (args, engine, buildSettings);
     if (isCommand (args, "render"))    return render (args, engine, buildSettings);
     if (isCommand (args, "test"))      return runTests (args, engine, buildSettings);
+    if (isCommand (args, "benchmark")) return runBenchmark (args, engine, buildSettings);
     if (isCommand (args, "create"))    return createPatch (args);
     if (isCommand (args, "unit-test")) return runUnitTests (args, engine, buildSettings);
 
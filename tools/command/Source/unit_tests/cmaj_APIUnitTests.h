@@ -18,8 +18,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <map>
+#include <sstream>
 #include "cmajor/API/cmaj_Engine.h"
+#include "../../../../modules/compiler/src/backends/cmaj_ConstantDataSegment.h"
 
 namespace cmaj::api_tests
 {
@@ -291,6 +294,380 @@ namespace cmaj::api_tests
         CHOC_EXPECT_EQ (value, int32_t {2});
     }
 
+    static void checkEventBatch (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkEventBatch)
+
+        auto engine = cmaj::Engine::create ({});
+
+        cmaj::Program program;
+        cmaj::DiagnosticMessageList messages;
+
+        const auto source = R"(
+            processor P
+            {
+                input event (int32, float32) in;
+                output event int32 out;
+
+                event in (int32 i)      { out <- i * 2; }
+                event in (float32 f)    { out <- int32 (f) * 10; }
+
+                void main()  { loop advance(); }
+            }
+        )";
+        program.parse (messages, "", source);
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        CHOC_EXPECT_TRUE (engine.load (messages, program, {}, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        const auto inHandle = engine.getEndpointHandle ("in");
+        const auto outHandle = engine.getEndpointHandle ("out");
+
+        engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                      .setMaxBlockSize (1));
+
+        CHOC_EXPECT_TRUE (engine.link (messages, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+        auto performer = engine.createPerformer();
+        CHOC_EXPECT_TRUE (performer);
+
+        struct Record
+        {
+            cmaj::EventBatch::Header header;
+            union { int32_t i; float f; } value;
+            uint32_t padding;
+        };
+
+        Record records[3];
+        records[0] = { { 0, 0 }, {}, 0 };  records[0].value.i = 1;
+        records[1] = { { 1, 0 }, {}, 0 };  records[1].value.f = 2.0f;
+        records[2] = { { 0, 0 }, {}, 0 };  records[2].value.i = 3;
+
+        performer.setBlockSize (1);
+        performer.addInputEvents (inHandle, cmaj::EventBatch { records, 3, static_cast<uint32_t> (sizeof (Record)) });
+        performer.advance();
+
+        std::vector<int32_t> results;
+
+        performer.iterateOutputEvents (outHandle, [&] (auto, uint32_t, uint32_t, const void* data, uint32_t)
+        {
+            results.push_back (*reinterpret_cast<const int32_t*> (data));
+            return true;
+        });
+
+        CHOC_EXPECT_TRUE (results == std::vector<int32_t> { 2, 20, 6 });
+    }
+
+    static void checkEventFrameOffsets (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkEventFrameOffsets)
+
+        auto engine = cmaj::Engine::create ({});
+
+        cmaj::Program program;
+        cmaj::DiagnosticMessageList messages;
+
+        const auto source = R"(
+            processor P
+            {
+                input event int32 in;
+                output stream int32 out;
+
+                int32 current;
+
+                event in (int32 i)   { current = i; }
+
+                void main()  { loop { out <- current; advance(); } }
+            }
+        )";
+        program.parse (messages, "", source);
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        CHOC_EXPECT_TRUE (engine.load (messages, program, {}, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        const auto inHandle = engine.getEndpointHandle ("in");
+        const auto outHandle = engine.getEndpointHandle ("out");
+
+        engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                      .setMaxBlockSize (8));
+
+        CHOC_EXPECT_TRUE (engine.link (messages, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+        auto performer = engine.createPerformer();
+        CHOC_EXPECT_TRUE (performer);
+        CHOC_EXPECT_TRUE (performer.supportsEventFrameOffsets());
+
+        struct Record
+        {
+            cmaj::EventBatch::Header header;
+            int32_t value;
+            uint32_t padding;
+        };
+
+        auto renderBlock = [&] (std::vector<Record> records)
+        {
+            performer.setBlockSize (8);
+            performer.addInputEvents (inHandle, cmaj::EventBatch { records.data(), static_cast<uint32_t> (records.size()),
+                                                                   static_cast<uint32_t> (sizeof (Record)) });
+            performer.advance();
+
+            std::vector<int32_t> output (8);
+            performer.copyOutputFrames (outHandle, output.data(), 8);
+            return output;
+        };
+
+        // the events are given out of order, to check that they get sorted
+        CHOC_EXPECT_TRUE (renderBlock ({ { { 0, 6 }, 7, 0 }, { { 0, 3 }, 5, 0 } }) == std::vector<int32_t> { 0, 0, 0, 5, 5, 5, 7, 7 });
+        CHOC_EXPECT_TRUE (renderBlock ({ { { 0, 0 }, 1, 0 }, { { 0, 7 }, 2, 0 } }) == std::vector<int32_t> { 1, 1, 1, 1, 1, 1, 1, 2 });
+        CHOC_EXPECT_TRUE (renderBlock ({}) == std::vector<int32_t> (8, 2));
+    }
+
+    static void checkDirectStreamAccess (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkDirectStreamAccess)
+
+        auto engine = cmaj::Engine::create ("llvm");
+
+        cmaj::Program program;
+        cmaj::DiagnosticMessageList messages;
+
+        const auto source = R"(
+            processor P
+            {
+                input stream float in;
+                output stream float out;
+
+                void main()
+                {
+                    loop
+                    {
+                        out <- in * 2.0f;
+                        advance();
+                    }
+                }
+            }
+        )";
+        program.parse (messages, "", source);
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        CHOC_EXPECT_TRUE (engine.load (messages, program, {}, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        const auto inHandle = engine.getEndpointHandle ("in");
+        const auto outHandle = engine.getEndpointHandle ("out");
+
+        engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                      .setMaxBlockSize (8));
+
+        CHOC_EXPECT_TRUE (engine.link (messages, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+        auto performer = engine.createPerformer();
+        CHOC_EXPECT_TRUE (performer);
+
+        auto input = performer.getStreamFrameBuffer<float> (inHandle, 1, 8);
+        auto output = performer.getStreamFrameBuffer<float> (outHandle, 1, 8);
+        CHOC_EXPECT_TRUE (input.data.data != nullptr);
+        CHOC_EXPECT_TRUE (output.data.data != nullptr);
+
+        performer.setBlockSize (8);
+
+        for (int block = 0; block < 2; ++block)
+        {
+            for (uint32_t i = 0; i < 8; ++i)
+                input.getSample (0, i) = float (i + block);
+
+            performer.advance();
+
+            // output frames must be cleared between blocks, not accumulated
+            for (uint32_t i = 0; i < 8; ++i)
+                CHOC_EXPECT_NEAR (float (i + block) * 2.0f, output.getSample (0, i), 0.0001);
+        }
+    }
+
+    static void checkPerformerPool (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkPerformerPool)
+
+        auto engine = cmaj::Engine::create ("llvm");
+
+        cmaj::Program program;
+        cmaj::DiagnosticMessageList messages;
+
+        const auto source = R"(
+            processor P
+            {
+                input value float in;
+                output stream float out;
+
+                float total;
+
+                void main()
+                {
+                    loop
+                    {
+                        total += in;
+                        out <- total;
+                        advance();
+                    }
+                }
+            }
+        )";
+        program.parse (messages, "", source);
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        CHOC_EXPECT_TRUE (engine.load (messages, program, {}, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        const auto inHandle = engine.getEndpointHandle ("in");
+        const auto outHandle = engine.getEndpointHandle ("out");
+
+        engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                      .setMaxBlockSize (4));
+
+        CHOC_EXPECT_TRUE (engine.link (messages, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        auto pool = engine.createPerformerPool (8);
+        CHOC_EXPECT_TRUE (pool);
+        CHOC_EXPECT_EQ (pool.getNumInstances(), 8u);
+
+        std::vector<cmaj::Performer> instances;
+
+        for (uint32_t i = 0; i < pool.getNumInstances(); ++i)
+        {
+            instances.push_back (pool.getPerformer (i));
+            CHOC_EXPECT_TRUE (instances.back());
+            instances.back().setInputValue (inHandle, float (i + 1), 0);
+        }
+
+        pool.setBlockSize (4);
+        pool.advance();
+
+        // each instance must have accumulated its own total, independently of the others
+        for (uint32_t i = 0; i < instances.size(); ++i)
+        {
+            auto output = choc::buffer::InterleavedBuffer<float> (1, 4);
+            instances[i].copyOutputFrames (outHandle, output);
+
+            for (uint32_t frame = 0; frame < 4; ++frame)
+                CHOC_EXPECT_NEAR (float ((i + 1) * (frame + 1)), output.getSample (0, frame), 0.0001);
+        }
+    }
+
+    static void checkNodeProfiling (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkNodeProfiling)
+
+        const auto source = R"(
+            processor Counter
+            {
+                output stream float out;
+
+                float count;
+
+                void main()
+                {
+                    loop
+                    {
+                        count += 1.0f;
+                        out <- count;
+                        advance();
+                    }
+                }
+            }
+
+            processor Doubler
+            {
+                input stream float in;
+                output stream float out;
+
+                void main()
+                {
+                    loop
+                    {
+                        out <- in * 2.0f;
+                        advance();
+                    }
+                }
+            }
+
+            graph G  [[ main ]]
+            {
+                output stream float out;
+
+                node counter = Counter;
+                node doubler = Doubler;
+
+                connection counter -> doubler -> out;
+            }
+        )";
+
+        auto build = [&] (bool profileNodes)
+        {
+            auto engine = cmaj::Engine::create ("llvm");
+
+            cmaj::Program program;
+            cmaj::DiagnosticMessageList messages;
+
+            program.parse (messages, "", source);
+            CHOC_EXPECT_TRUE (messages.empty());
+            CHOC_EXPECT_TRUE (engine.load (messages, program, {}, {}));
+
+            engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                          .setMaxBlockSize (4)
+                                                          .setProfileNodes (profileNodes));
+
+            CHOC_EXPECT_TRUE (engine.getEndpointHandle ("out") != 0);
+            CHOC_EXPECT_TRUE (engine.link (messages, {}));
+            CHOC_EXPECT_TRUE (messages.empty());
+            return engine;
+        };
+
+        {
+            auto engine = build (false);
+            auto performer = engine.createPerformer();
+            performer.setBlockSize (4);
+            performer.advance();
+
+            CHOC_EXPECT_FALSE (engine.getProgramDetails().hasObjectMember ("profiledNodes"));
+            CHOC_EXPECT_TRUE (performer.getNodeProfileCounters().empty());
+        }
+
+        {
+            auto engine = build (true);
+            auto nodeNames = engine.getProgramDetails()["profiledNodes"];
+            CHOC_EXPECT_EQ (nodeNames.size(), 2u);
+            CHOC_EXPECT_EQ (nodeNames[0].toString(), "counter");
+            CHOC_EXPECT_EQ (nodeNames[1].toString(), "doubler");
+
+            auto performer = engine.createPerformer();
+            auto outHandle = engine.getEndpointHandle ("out");
+            auto output = choc::buffer::InterleavedBuffer<float> (1, 4);
+
+            performer.setBlockSize (4);
+            performer.advance();
+            performer.advance();
+            performer.copyOutputFrames (outHandle, output);
+
+            // the instrumentation mustn't change the rendered output
+            for (uint32_t frame = 0; frame < 4; ++frame)
+                CHOC_EXPECT_NEAR (float (2 * (frame + 5)), output.getSample (0, frame), 0.0001);
+
+            auto counters = performer.getNodeProfileCounters();
+            CHOC_EXPECT_EQ (counters.size(), 2u);
+
+            for (auto& c : counters)
+                CHOC_EXPECT_EQ (c.numCalls, 8u);
+
+            performer.reset();
+
+            for (auto& c : performer.getNodeProfileCounters())
+                CHOC_EXPECT_EQ (c.numCalls, 0u);
+        }
+    }
+
     inline void checkExternalFunctions (choc::test::TestProgress& progress)
     {
         CHOC_TEST (checkExternalFunctions)
@@ -398,13 +775,297 @@ namespace cmaj::api_tests
         CHOC_EXPECT_EQ (output, "111111");
     }
 
+    inline void checkMappedAudioData (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkMappedAudioData)
+
+        auto cacheFile = (std::filesystem::temp_directory_path() / "cmaj_unit_test_audio.cmajaudio").string();
+
+        {
+            choc::buffer::ChannelArrayBuffer<float> frames (2u, 8u);
+
+            for (uint32_t frame = 0; frame < 8; ++frame)
+                for (uint32_t chan = 0; chan < 2; ++chan)
+                    frames.getSample (chan, frame) = static_cast<float> (frame * 10 + chan);
+
+            CHOC_EXPECT_TRUE (cmaj::AudioCacheFile::write (cacheFile, frames, 44100.0));
+        }
+
+        {
+            auto file = cmaj::AudioCacheFile::read (cacheFile);
+            CHOC_EXPECT_TRUE (file.has_value());
+            CHOC_EXPECT_EQ (file->numChannels, 2u);
+            CHOC_EXPECT_EQ (file->numFrames, 8u);
+
+            auto engine = cmaj::Engine::create ("llvm");
+
+            cmaj::Program program;
+            cmaj::DiagnosticMessageList messages;
+
+            program.parse (messages, "", R"(
+                processor P
+                {
+                    output event float32 out;
+
+                    external float32<2>[] samples;
+
+                    void main()
+                    {
+                        out <- float32 (samples.size) <- samples[3][1] <- samples[7][0];
+                        advance();
+                    }
+                }
+            )");
+
+            CHOC_EXPECT_TRUE (messages.empty());
+
+            auto audioFile = cmaj::createAudioFileObject (cmaj::createMappedAudioFramesObject (*file), file->sampleRate);
+
+            bool result = engine.load (messages, program,
+                                       [&] (const cmaj::ExternalVariable&) -> choc::value::Value { return audioFile; },
+                                       {});
+
+            CHOC_EXPECT_TRUE (result);
+            CHOC_EXPECT_TRUE (messages.empty());
+
+            const auto outHandle = engine.getEndpointHandle ("out");
+
+            engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                          .setMaxBlockSize (1));
+
+            CHOC_EXPECT_TRUE (engine.link (messages, {}));
+            auto performer = engine.createPerformer();
+            CHOC_EXPECT_TRUE (performer);
+
+            performer.setBlockSize (1);
+            performer.advance();
+            std::vector<float> output;
+
+            performer.iterateOutputEvents (outHandle, [&] (auto, uint32_t, uint32_t, const void* data, uint32_t)
+            {
+                output.push_back (*reinterpret_cast<const float*> (data));
+                return true;
+            });
+
+            CHOC_EXPECT_TRUE (output == std::vector<float> ({ 8.0f, 31.0f, 70.0f }));
+        }
+
+        std::error_code error;
+        std::filesystem::remove (cacheFile, error);
+    }
+
+    /// Returns the names of the data-segment globals in some printed IR, checking that each
+    /// of them is only declared, and that neither of the large tables has an initialiser
+    static std::vector<std::string> findConstantDataSymbols (choc::test::TestProgress& progress, const std::string& ir)
+    {
+        std::vector<std::string> names;
+
+        for (auto& line : choc::text::splitIntoLines (ir, false))
+        {
+            CHOC_EXPECT_FALSE (choc::text::contains (line, "[8192 x float] [")
+                                || choc::text::contains (line, "[8192 x i64] ["));
+
+            if (choc::text::startsWith (line, "@_cmaj_constant_data_"))
+            {
+                CHOC_EXPECT_TRUE (choc::text::contains (line, " = external "));
+
+                auto name = line.substr (1, line.find (' ') - 1);
+
+                if (std::find (names.begin(), names.end(), name) == names.end())
+                    names.push_back (name);
+            }
+        }
+
+        std::sort (names.begin(), names.end());
+        return names;
+    }
+
+    inline void checkLargeConstantData (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkLargeConstantData)
+
+        const auto source = R"(
+            processor P
+            {
+                output event float32 out;
+                input event int32 index;
+
+                external float32[8192] table;
+                external int64[] bigSlice;
+
+                event index (int32 i)
+                {
+                    out <- table.at (i) <- float32 (bigSlice.at (i));
+                }
+            }
+        )";
+
+        std::vector<float> table;
+        std::vector<int64_t> bigSlice;
+
+        for (int i = 0; i < 8192; ++i)
+        {
+            table.push_back (static_cast<float> (i) * 0.5f);
+            bigSlice.push_back (static_cast<int64_t> (i) * 3);
+        }
+
+        // Build two engines with the same data, and keep them both alive so that they
+        // should end up sharing it
+        std::vector<cmaj::Engine> engines;
+        std::vector<cmaj::Performer> performers;
+        std::vector<std::vector<std::string>> symbolNames;
+
+        for (int i = 0; i < 2; ++i)
+        {
+            cmaj::Program program;
+            cmaj::DiagnosticMessageList messages;
+
+            program.parse (messages, "", source);
+            CHOC_EXPECT_TRUE (messages.empty());
+
+            auto engine = cmaj::Engine::create ("llvm");
+
+            bool result = engine.load (messages, program,
+                                       [&] (const cmaj::ExternalVariable& v) -> choc::value::Value
+                                       {
+                                           if (choc::text::contains (v.name, "table"))
+                                               return choc::value::createArray (static_cast<uint32_t> (table.size()), [&] (uint32_t n) { return table[n]; });
+
+                                           return choc::value::createArray (static_cast<uint32_t> (bigSlice.size()), [&] (uint32_t n) { return bigSlice[n]; });
+                                       },
+                                       {});
+
+            CHOC_EXPECT_TRUE (result);
+
+            const auto inHandle = engine.getEndpointHandle ("index");
+            const auto outHandle = engine.getEndpointHandle ("out");
+
+            // The debug flag makes the JIT print the IR of the module that it builds
+            engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                          .setMaxBlockSize (1)
+                                                          .setDebugFlag (true));
+
+            std::ostringstream debugOutput;
+            auto oldBuffer = std::cout.rdbuf (debugOutput.rdbuf());
+            auto linked = engine.link (messages, {});
+            std::cout.rdbuf (oldBuffer);
+
+            CHOC_EXPECT_TRUE (linked);
+            CHOC_EXPECT_TRUE (choc::text::contains (debugOutput.str(), "Pre optimisation"));
+            symbolNames.push_back (findConstantDataSymbols (progress, debugOutput.str()));
+
+            auto performer = engine.createPerformer();
+            CHOC_EXPECT_TRUE (performer);
+
+            performer.setBlockSize (1);
+            std::vector<float> output;
+
+            for (int32_t index : { 17, 8191 })
+            {
+                performer.addInputEvent (inHandle, 0, choc::value::createInt32 (index));
+                performer.advance();
+
+                performer.iterateOutputEvents (outHandle, [&] (auto, uint32_t, uint32_t, const void* data, uint32_t)
+                {
+                    output.push_back (*reinterpret_cast<const float*> (data));
+                    return true;
+                });
+            }
+
+            CHOC_EXPECT_TRUE (output == std::vector<float> ({ 8.5f, 51.0f, 4095.5f, 24573.0f }));
+
+            engines.push_back (std::move (engine));
+            performers.push_back (std::move (performer));
+        }
+
+        // Both tables are linked as data-segment symbols, and the two programs resolve
+        // each of them to the same block of memory, which lives as long as they do
+        CHOC_EXPECT_EQ (symbolNames[0].size(), 2u);
+        CHOC_EXPECT_TRUE (symbolNames[0] == symbolNames[1]);
+
+        for (auto& name : symbolNames[0])
+            CHOC_EXPECT_TRUE (cmaj::ConstantDataSegment::findSharedData (name) != nullptr);
+
+        performers.clear();
+        engines.clear();
+
+        for (auto& name : symbolNames[0])
+            CHOC_EXPECT_TRUE (cmaj::ConstantDataSegment::findSharedData (name) == nullptr);
+    }
+
+    static void checkNodeArrayVectorisation (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkNodeArrayVectorisation)
+
+        auto engine = cmaj::Engine::create ("llvm");
+
+        cmaj::Program program;
+        cmaj::DiagnosticMessageList messages;
+
+        program.parse (messages, "", R"(
+            graph G [[main]]
+            {
+                input stream float in;
+                output stream float out;
+
+                node voices = Voice[16];
+
+                connection in -> voices.in;
+                connection voices.out -> out;
+            }
+
+            processor Voice
+            {
+                input stream float in;
+                output stream float out;
+
+                float level = 1.0f;
+
+                void main()
+                {
+                    loop
+                    {
+                        if (in > 0.5f)
+                            level *= 0.99f;
+
+                        out <- in * level;
+                        advance();
+                    }
+                }
+            }
+        )");
+
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        engine.setBuildSettings (cmaj::BuildSettings().setFrequency (44100.0)
+                                                      .setMaxBlockSize (32));
+
+        CHOC_EXPECT_TRUE (engine.load (messages, program, {}, {}));
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        // When the loop vectoriser transforms a loop, it marks it as vectorised in the
+        // optimised IR, so this checks that the loop over the voices was actually run
+        // lane-wise rather than just hinted
+        auto ir = engine.generateCode ("llvm", R"({ "targetFormat": "ir" })").generatedCode;
+        CHOC_EXPECT_FALSE (ir.empty());
+        CHOC_EXPECT_TRUE (choc::text::contains (ir, "llvm.loop.isvectorized"));
+    }
+
     static void runUnitTests (choc::test::TestProgress& progress)
     {
         CHOC_CATEGORY (Performer);
 
         checkExternalFunctions (progress);
+        checkMappedAudioData (progress);
+        checkLargeConstantData (progress);
         checkGraph (progress);
         checkOutputEventWithMultipleTypes (progress);
+        checkEventBatch (progress);
+        checkEventFrameOffsets (progress);
+        checkDirectStreamAccess (progress);
+        checkPerformerPool (progress);
+        checkNodeProfiling (progress);
+        checkNodeArrayVectorisation (progress);
         checkInvalidEngine (progress);
     }
 }
@@ -19,6 +19,7 @@
 #pragma once
 
 #include "cmajor/helpers/cmaj_Patch.h"
+#include "../../../../modules/playback/include/cmaj_AllocationChecker.h"
 
 namespace cmaj::patch_helper_tests
 {
@@ -1160,6 +1161,93 @@ static bool runUnitTests (choc::test::TestProgress& progress)
         CHOC_EXPECT_NEAR (outputBackingBuffer[3], 0.125f, 0.0001f);
     }
 
+    {
+        CHOC_TEST (EndpointMonitoringDoesNotAllocate)
+
+        const auto manifestSource = R"({
+            "CmajorVersion": 1,
+            "ID": "com.your_name.your_patch_ID",
+            "version": "1.0",
+            "name": "Test",
+            "description": "Test",
+            "category": "generator",
+            "manufacturer": "Your Company Goes Here",
+            "isInstrument": true,
+            "source": ["Test.cmajor"]
+        })";
+
+        const auto cmajorSource = R"(
+            processor Test [[ main ]]
+            {
+                input event std::midi::Message midiIn;
+                output stream float out;
+
+                event midiIn (std::midi::Message m) {}
+
+                void main() { loop { out <- 0.5f; advance(); } }
+            }
+        )";
+
+        Patch patch;
+        initTestPatch (patch);
+
+        cmaj::Patch::PlaybackParams params;
+        params.blockSize = 64;
+        params.sampleRate = 44100;
+        params.numInputChannels = 0;
+        params.numOutputChannels = 1;
+        patch.setPlaybackParams (params);
+
+        if (! patch.loadPatch ({ createManifestWithInMemoryFiles (manifestSource, {{ "Test.cmajor", cmajorSource }}), {} }, true))
+        {
+            CHOC_FAIL ("Failed to load patch");
+            return false;
+        }
+
+        struct ProxyPatchView  : public cmaj::PatchView
+        {
+            ProxyPatchView (cmaj::Patch& p) : PatchView (p) {}
+            void sendMessage (const choc::value::ValueView&) override {}
+        };
+
+        ProxyPatchView view1 (patch), view2 (patch);
+
+        for (auto* view : { std::addressof (view1), std::addressof (view2) })
+        {
+            CHOC_EXPECT_TRUE (patch.handleClientMessage (*view, choc::json::create ("type", "add_endpoint_listener",
+                                                                                    "endpoint", "out",
+                                                                                    "replyType", "levels",
+                                                                                    "granularity", choc::value::createInt32 (64))));
+            CHOC_EXPECT_TRUE (patch.handleClientMessage (*view, choc::json::create ("type", "add_endpoint_listener",
+                                                                                    "endpoint", "out",
+                                                                                    "replyType", "scope",
+                                                                                    "granularity", choc::value::createInt32 (64),
+                                                                                    "fullAudioData", true)));
+            CHOC_EXPECT_TRUE (patch.handleClientMessage (*view, choc::json::create ("type", "add_endpoint_listener",
+                                                                                    "endpoint", "midiIn",
+                                                                                    "replyType", "midi")));
+        }
+
+        std::array<float, 64> buffer {{}};
+        std::array<float*, 1> buffers { { buffer.data() } };
+
+        const uint8_t noteOn[] = { 0x90, 60, 100 };
+
+        patch.process (buffers.data(), 64, [] (auto&&...) {});
+
+        {
+            cmaj::ScopedAllocationTracker allocationTracker;
+
+            for (int i = 0; i < 8; ++i)
+            {
+                patch.addMIDIMessage (0, noteOn, sizeof (noteOn));
+                patch.process (buffers.data(), 64, [] (auto&&...) {});
+            }
+        }
+
+        CHOC_EXPECT_NEAR (buffer[0], 0.5f, 0.0001f);
+    }
+
     return progress.numFails == 0;
 }
 
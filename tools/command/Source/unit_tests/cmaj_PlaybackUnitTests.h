@@ -0,0 +1,169 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#pragma once
+
+#include <thread>
+#include "../../../../modules/playback/include/cmaj_AudioFileUtils.h"
+#include "../../../../modules/playback/include/cmaj_AudioPlayer.h"
+
+namespace cmaj::playback_tests
+{
+    inline void checkStreamingAudioFiles (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkStreamingAudioFiles)
+
+        auto wavFile = (std::filesystem::temp_directory_path() / "cmaj_unit_test_streaming.wav").string();
+        const uint32_t numFrames = 1000;
+
+        auto getSample = [] (uint32_t chan, uint32_t frame)  { return static_cast<float> (frame) + 0.25f * static_cast<float> (chan); };
+
+        {
+            // small chunks and odd block sizes, so that blocks straddle chunk boundaries
+            cmaj::audio_utils::WriteBehindAudioFileWriter writer (cmaj::audio_utils::createFileWriter (wavFile, 44100.0, 2), 2, 64, 3);
+            choc::buffer::ChannelArrayBuffer<float> block (2u, 37u);
+
+            for (uint32_t start = 0; start < numFrames; start += 37)
+            {
+                auto blockSize = std::min (37u, numFrames - start);
+
+                for (uint32_t frame = 0; frame < blockSize; ++frame)
+                    for (uint32_t chan = 0; chan < 2; ++chan)
+                        block.getSample (chan, frame) = getSample (chan, start + frame);
+
+                CHOC_EXPECT_TRUE (writer.appendFrames (block.getView().getStart (blockSize)));
+            }
+
+            CHOC_EXPECT_TRUE (writer.finish());
+            CHOC_EXPECT_FALSE (writer.appendFrames (block.getView()));
+        }
+
+        {
+            cmaj::audio_utils::ReadAheadAudioFileReader reader (cmaj::audio_utils::createFileReader (wavFile), 50, 2);
+            CHOC_EXPECT_EQ (reader.getProperties().numFrames, static_cast<uint64_t> (numFrames));
+            CHOC_EXPECT_EQ (reader.getProperties().numChannels, 2u);
+
+            // reading into more channels than the file has should leave the extra ones silent,
+            // and reading past the end should give silence
+            choc::buffer::ChannelArrayBuffer<float> block (3u, 33u);
+            bool allCorrect = true;
+
+            for (uint32_t start = 0; start < numFrames + 100; start += 33)
+            {
+                for (uint32_t frame = 0; frame < 33; ++frame)
+                    for (uint32_t chan = 0; chan < 3; ++chan)
+                        block.getSample (chan, frame) = -1.0f;
+
+                CHOC_EXPECT_TRUE (reader.readNextFrames (block.getView()));
+
+                for (uint32_t frame = 0; frame < 33; ++frame)
+                    for (uint32_t chan = 0; chan < 3; ++chan)
+                        if (block.getSample (chan, frame) != (chan < 2 && start + frame < numFrames ? getSample (chan, start + frame) : 0.0f))
+                            allCorrect = false;
+            }
+
+            CHOC_EXPECT_TRUE (allCorrect);
+        }
+
+        std::error_code error;
+        std::filesystem::remove (wavFile, error);
+    }
+
+    inline void checkMultiClientMixing (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkMultiClientMixing)
+
+        struct ConstantClient  : public cmaj::audio_utils::AudioMIDICallback
+        {
+            ConstantClient (float v) : value (v) {}
+
+            void prepareToStart (double, HandleMIDIOutEventFn) override {}
+            void addIncomingMIDIEvent (const void*, uint32_t) override {}
+
+            void process (choc::buffer::ChannelArrayView<const float>,
+                          choc::buffer::ChannelArrayView<float> output,
+                          bool replaceOutput) override
+            {
+                for (uint32_t chan = 0; chan < output.getNumChannels(); ++chan)
+                    for (uint32_t frame = 0; frame < output.getNumFrames(); ++frame)
+                        output.getSample (chan, frame) = (replaceOutput ? 0.0f : output.getSample (chan, frame))
+                                                            + value * static_cast<float> (chan + 1);
+            }
+
+            const float value;
+        };
+
+        ConstantClient client1 (1.0f), client2 (2.0f), client3 (3.0f);
+
+        std::atomic<bool> allClientsAdded { false }, finished { false };
+        std::atomic<int> blocksAfterAllAdded { 0 };
+        std::atomic<bool> outputCorrect { false };
+
+        cmaj::audio_utils::AudioDeviceOptions options;
+        options.sampleRate = 44100;
+        options.blockSize = 64;
+        options.inputChannelCount = 0;
+        options.outputChannelCount = 2;
+        options.numClientRenderThreads = 3;
+        options.createPlayer = cmaj::audio_utils::createRenderingPlayer;
+
+        options.provideInput = [&] (choc::buffer::ChannelArrayView<float>, std::vector<choc::midi::ShortMessage>&, std::vector<uint32_t>&)
+        {
+            if (allClientsAdded && ++blocksAfterAllAdded > 50)
+            {
+                finished = true;
+                return false;
+            }
+
+            return true;
+        };
+
+        options.handleOutput = [&] (choc::buffer::ChannelArrayView<const float> output)
+        {
+            outputCorrect = output.getSample (0, 0) == 6.0f && output.getSample (1, 63) == 12.0f;
+            return true;
+        };
+
+        {
+            cmaj::audio_utils::MultiClientAudioMIDIPlayer player (options);
+
+            // clients are added while the first one is already being rendered
+            player.addCallback (client1);
+            player.addCallback (client2);
+            player.addCallback (client3);
+            allClientsAdded = true;
+
+            while (! finished)
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
+
+            player.removeCallback (client2);
+            player.removeCallback (client1);
+            player.removeCallback (client3);
+        }
+
+        CHOC_EXPECT_TRUE (outputCorrect.load());
+    }
+
+    inline void runUnitTests (choc::test::TestProgress& progress)
+    {
+        CHOC_CATEGORY (Playback);
+
+        checkStreamingAudioFiles (progress);
+        checkMultiClientMixing (progress);
+    }
+}
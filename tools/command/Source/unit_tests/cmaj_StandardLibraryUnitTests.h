@@ -0,0 +1,170 @@
+//
+//     ,ad888ba,                              88
+//    d8"'    "8b
+//   d8            88,dba,,adba,   ,aPP8A.A8  88     The Cmajor Toolkit
+//   Y8,           88    88    88  88     88  88
+//    Y8a.   .a8P  88    88    88  88,   ,88  88     (C)2024 Cmajor Software Ltd
+//     '"Y888Y"'   88    88    88  '"8bbP"Y8  88     https://cmajor.dev
+//                                           ,88
+//                                        888P"
+//
+//  The Cmajor project is subject to commercial or open-source licensing.
+//  You may use it under the terms of the GPLv3 (see www.gnu.org/licenses), or
+//  visit https://cmajor.dev to learn about our commercial licence options.
+//
+//  CMAJOR IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES, WHETHER
+//  EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR PURPOSE, ARE
+//  DISCLAIMED.
+
+#pragma once
+
+#include <set>
+#include <unordered_set>
+#include "cmajor/API/cmaj_Program.h"
+#include "../../../../modules/compiler/src/AST/cmaj_AST.h"
+#include "../../../../modules/compiler/src/standard_library/cmaj_StandardLibrary.h"
+#include "../../../../modules/compiler/src/transformations/cmaj_Transformations.h"
+
+namespace cmaj::standard_library_tests
+{
+    static void addReachableObjects (AST::Property& property, std::vector<AST::Object*>& objectsToVisit)
+    {
+        if (auto p = property.getAsObjectProperty())
+        {
+            if (auto o = p->getRawPointer())
+                objectsToVisit.push_back (o);
+        }
+        else if (auto list = property.getAsListProperty())
+        {
+            for (auto& item : *list)
+                addReachableObjects (item, objectsToVisit);
+        }
+    }
+
+    /// Returns everything that can be reached from a program's root namespace through
+    /// properties or parent scopes
+    static std::vector<AST::Object*> findReachableObjects (AST::Program& program)
+    {
+        std::unordered_set<AST::Object*> found;
+        std::vector<AST::Object*> objectsToVisit { std::addressof (program.rootNamespace) }, results;
+
+        while (! objectsToVisit.empty())
+        {
+            auto o = objectsToVisit.back();
+            objectsToVisit.pop_back();
+
+            if (! found.insert (o).second)
+                continue;
+
+            results.push_back (o);
+
+            for (auto& property : o->getPropertyList())
+                addReachableObjects (*property, objectsToVisit);
+
+            if (auto parent = o->context.parentScope.get())
+                objectsToVisit.push_back (parent);
+        }
+
+        return results;
+    }
+
+    static bool areAllObjectsInOwnAllocator (AST::Program& program)
+    {
+        for (auto o : findReachableObjects (program))
+            if (std::addressof (o->context.allocator) != std::addressof (program.allocator))
+                return false;
+
+        return true;
+    }
+
+    static std::set<std::string> getIntrinsicFunctionNames (AST::Program& program)
+    {
+        std::set<std::string> names;
+
+        for (auto& f : findIntrinsicsNamespaceFromRoot (program.rootNamespace)->functions)
+            names.insert (std::string (AST::castToFunctionRef (f).getName().get()));
+
+        return names;
+    }
+
+    static AST::Program& createProgram (cmaj::Program& program, DiagnosticMessageList& messages, const std::string& code)
+    {
+        program.parse (messages, "internal", code);
+        auto& ast = AST::getProgram (*program.program);
+        ast.prepareForLoading();
+        return ast;
+    }
+
+    /// Runs the same transformations as an engine's load() and link(), which add
+    /// specialised functions to the intrinsics namespace
+    static void prepareForCodeGen (AST::Program& program)
+    {
+        auto buildSettings = BuildSettings().setFrequency (44100).setMaxBlockSize (512);
+        double latency = 0;
+
+        transformations::runBasicResolutionPasses (program);
+        program.setMainProcessor (*program.findMainProcessorCandidate ({}));
+        transformations::prepareForResolution (program, buildSettings.getMaxStackSize());
+        program.endpointList.initialise (*program.findMainProcessor());
+
+        transformations::prepareForCodeGen (program, buildSettings, true, true, false, false,
+                                            [] (AST::Intrinsic::Type) { return true; }, latency,
+                                            [] (const EndpointID&) { return true; }, nullptr);
+    }
+
+    static void checkClonedProgramsAreIsolated (choc::test::TestProgress& progress)
+    {
+        CHOC_TEST (checkClonedProgramsAreIsolated);
+
+        auto code = R"(
+processor P
+{
+    output stream float out;
+    wrap<5> w;
+
+    void main()
+    {
+        loop
+        {
+            out <- float (++w);
+            advance();
+        }
+    }
+}
+)";
+
+        DiagnosticMessageList messages;
+        cmaj::Program programA, programB, programC;
+
+        auto& astB = createProgram (programB, messages, code);
+        CHOC_EXPECT_TRUE (areAllObjectsInOwnAllocator (astB));
+        auto originalIntrinsics = getIntrinsicFunctionNames (astB);
+
+        auto& astA = createProgram (programA, messages, code);
+        prepareForCodeGen (astA);
+        CHOC_EXPECT_TRUE (messages.empty());
+
+        auto modifiedIntrinsics = getIntrinsicFunctionNames (astA);
+        CHOC_EXPECT_TRUE (modifiedIntrinsics.find ("_wrap_5") != modifiedIntrinsics.end());
+        CHOC_EXPECT_TRUE (originalIntrinsics.find ("_wrap_5") == originalIntrinsics.end());
+        CHOC_EXPECT_TRUE (areAllObjectsInOwnAllocator (astA));
+
+        // neither a program that already existed nor a new one should see what was
+        // added to the first program's copy of the library
+        auto& astC = createProgram (programC, messages, code);
+        CHOC_EXPECT_TRUE (getIntrinsicFunctionNames (astB) == originalIntrinsics);
+        CHOC_EXPECT_TRUE (getIntrinsicFunctionNames (astC) == originalIntrinsics);
+        CHOC_EXPECT_TRUE (areAllObjectsInOwnAllocator (astC));
+
+        CHOC_EXPECT_TRUE (findIntrinsicsNamespaceFromRoot (astA.rootNamespace) != findIntrinsicsNamespaceFromRoot (astB.rootNamespace));
+        CHOC_EXPECT_TRUE (findIntrinsicsNamespaceFromRoot (astB.rootNamespace) != findIntrinsicsNamespaceFromRoot (astC.rootNamespace));
+        CHOC_EXPECT_TRUE (messages.empty());
+    }
+
+    static void runUnitTests (choc::test::TestProgress& progress)
+    {
+        CHOC_CATEGORY (StandardLibrary);
+
+        checkClonedProgramsAreIsolated (progress);
+    }
+}